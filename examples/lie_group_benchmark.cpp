@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/common.h>
+#include <m3t/lie_group.h>
+
+#include <Eigen/Geometry>
+#include <chrono>
+#include <iostream>
+#include <unsupported/Eigen/MatrixFunctions>
+#include <vector>
+
+// Adjoint as previously computed in Link
+Eigen::Matrix<float, 6, 6> PreviousAdjoint(const m3t::Transform3fA &pose) {
+  Eigen::Matrix<float, 6, 6> m{Eigen::Matrix<float, 6, 6>::Zero()};
+  m.topLeftCorner<3, 3>() = pose.rotation();
+  m.bottomLeftCorner<3, 3>() =
+      m3t::Vector2Skewsymmetric(pose.translation()) * pose.rotation();
+  m.bottomRightCorner<3, 3>() = pose.rotation();
+  return m;
+}
+
+// Measures the average time in nanoseconds of a function over all samples
+template <typename F>
+float MeasureTime(int n_samples, int n_runs, F &&function) {
+  auto begin_time{std::chrono::high_resolution_clock::now()};
+  for (int i = 0; i < n_runs; ++i)
+    for (int j = 0; j < n_samples; ++j) function(j);
+  auto end_time{std::chrono::high_resolution_clock::now()};
+  return float(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   end_time - begin_time)
+                   .count()) /
+         float(n_runs * n_samples);
+}
+
+// Script that compares Lie group kernels to previously used implementations
+int main(int argc, char *argv[]) {
+  // Parameters
+  int n_samples = 1000;
+  int n_runs = 1000;
+  int n_jacobian_columns = 30;
+
+  // Generate random rotation vectors, poses, and Jacobians
+  std::vector<Eigen::Vector3f> rotation_vectors(n_samples);
+  std::vector<Eigen::Matrix3f> rotations(n_samples);
+  std::vector<m3t::Transform3fA> poses(n_samples);
+  for (int i = 0; i < n_samples; ++i) {
+    rotation_vectors[i] = Eigen::Vector3f::Random();
+    rotations[i] = m3t::ExpSO3(rotation_vectors[i]);
+    poses[i] = m3t::Transform3fA::Identity();
+    poses[i].translate(Eigen::Vector3f::Random());
+    poses[i].rotate(rotations[i]);
+  }
+  Eigen::Matrix<float, 6, Eigen::Dynamic> jacobian{
+      Eigen::Matrix<float, 6, Eigen::Dynamic>::Random(6, n_jacobian_columns)};
+  Eigen::Matrix<float, 6, Eigen::Dynamic> result(6, n_jacobian_columns + 6);
+  float sink = 0.0f;
+
+  // Exponential map
+  float pade_exp_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    sink += m3t::Vector2Skewsymmetric(rotation_vectors[i]).exp()(0, 1);
+  });
+  float rodrigues_exp_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    sink += m3t::ExpSO3(rotation_vectors[i])(0, 1);
+  });
+
+  // Logarithmic map
+  float angle_axis_log_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    Eigen::AngleAxisf angle_axis{rotations[i]};
+    sink += (angle_axis.angle() * angle_axis.axis())(0);
+  });
+  float log_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    sink += m3t::LogSO3(rotations[i])(0);
+  });
+
+  // Adjoint matrix
+  float previous_adjoint_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    sink += PreviousAdjoint(poses[i])(4, 0);
+  });
+  float adjoint_time = MeasureTime(n_samples, n_runs, [&](int i) {
+    sink += m3t::AdjointSE3(poses[i])(4, 0);
+  });
+
+  // Projection of Jacobian
+  float adjoint_product_time = MeasureTime(n_samples, n_runs / 10, [&](int i) {
+    result.leftCols(n_jacobian_columns) = PreviousAdjoint(poses[i]) * jacobian;
+    sink += result(4, 0);
+  });
+  float apply_adjoint_time = MeasureTime(n_samples, n_runs / 10, [&](int i) {
+    m3t::ApplyAdjointSE3(poses[i], jacobian,
+                         result.leftCols(n_jacobian_columns));
+    sink += result(4, 0);
+  });
+
+  // Print results
+  std::cout << "Exponential map: Pade " << pade_exp_time << " ns, Rodrigues "
+            << rodrigues_exp_time << " ns" << std::endl;
+  std::cout << "Logarithmic map: AngleAxis " << angle_axis_log_time
+            << " ns, LogSO3 " << log_time << " ns" << std::endl;
+  std::cout << "Adjoint: rotation() " << previous_adjoint_time
+            << " ns, AdjointSE3 " << adjoint_time << " ns" << std::endl;
+  std::cout << "Projection of " << n_jacobian_columns
+            << " columns: previous " << adjoint_product_time
+            << " ns, ApplyAdjointSE3 " << apply_adjoint_time << " ns"
+            << std::endl;
+  std::cout << "(" << sink << ")" << std::endl;
+  return 0;
+}
@@ -9,9 +9,11 @@
 #include <m3t/common.h>
 #include <m3t/renderer.h>
 #include <m3t/renderer_geometry.h>
+#include <m3t/software_renderer.h>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -25,6 +27,15 @@ namespace m3t {
  * \brief Class that implements the main functionality for a basic depth
  * renderer and is used by \ref FullBasicDepthRenderer and \ref
  * FocusedBasicDepthRenderer.
+ *
+ * \details If a region is provided, drawing is restricted to this region using
+ * scissoring, only the region is read back, and all other pixels are set to
+ * the cleared value. If `use_linear_depth` is true, a shader program with a
+ * fragment shader writes depth values that are linear between the near and
+ * far plane to a 16-bit color attachment from which depth images are read.
+ * The depth attachment is then only used for depth tests. Bodies that share
+ * vertex objects are drawn with instanced draw calls that take poses from a
+ * uniform array.
  */
 class BasicDepthRendererCore {
  public:
@@ -34,11 +45,16 @@ class BasicDepthRendererCore {
   BasicDepthRendererCore &operator=(const BasicDepthRendererCore &) = delete;
   ~BasicDepthRendererCore();
   bool SetUp(const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-             int image_width, int image_height);
+             int image_width, int image_height,
+             bool use_pixel_buffer_readback = false, int context_id = 0,
+             bool use_linear_depth = false, float lod_max_pixel_error = 0.0f);
 
   // Main methods
   bool StartRendering(const Eigen::Matrix4f &projection_matrix,
                       const Transform3fA &world2camera_pose);
+  bool StartRendering(const Eigen::Matrix4f &projection_matrix,
+                      const Transform3fA &world2camera_pose,
+                      const cv::Rect &region);
   bool FetchDepthImage(cv::Mat *depth_image);
 
  private:
@@ -50,14 +66,25 @@ class BasicDepthRendererCore {
   std::shared_ptr<RendererGeometry> renderer_geometry_ptr_;
   int image_width_;
   int image_height_;
+  bool use_pixel_buffer_readback_ = false;
+  int context_id_ = 0;
+  bool use_linear_depth_ = false;
+  float lod_max_pixel_error_ = 0.0f;
+  cv::Rect region_{};
+  std::vector<InstanceGroup> instance_groups_{};
+  std::array<Eigen::Matrix4f, kMaxNInstances> transs_{};
 
   // Shader code
   static std::string vertex_shader_code_;
+  static std::string linear_fragment_shader_code_;
 
   // OpenGL variables
   unsigned fbo_ = 0;
   unsigned rbo_ = 0;
+  unsigned rbo_linear_depth_ = 0;
   unsigned shader_program_ = 0;
+  unsigned linear_shader_program_ = 0;
+  PixelBufferReader depth_reader_{};
 
   // Internal state
   bool image_rendered_ = false;
@@ -112,6 +139,10 @@ class FullBasicDepthRenderer : public FullDepthRenderer {
  * \details Rendering is started using `StartRendering()`. Images are fetched
  * from the GPU using `FetchDepthImage()` and can then be accessed using the
  * `depth_image()` getter. Setters and all main methods are thread-safe.
+ *
+ * @param use_software_rendering if true, images are rasterized on the CPU
+ * using \ref SoftwareRendererCore. No OpenGL context is used and the \ref
+ * RendererGeometry does not have to be set up.
  */
 class FocusedBasicDepthRenderer : public FocusedDepthRenderer {
  public:
@@ -132,16 +163,24 @@ class FocusedBasicDepthRenderer : public FocusedDepthRenderer {
       const std::shared_ptr<Camera> &camera_ptr);
   bool SetUp() override;
 
+  // Setters
+  void set_use_software_rendering(bool use_software_rendering);
+
   // Main methods
   bool StartRendering() override;
   bool FetchDepthImage() override;
 
+  // Getters
+  bool use_software_rendering() const;
+
  private:
   // Helper methods
   bool LoadMetaData();
 
   // Data
+  bool use_software_rendering_ = false;
   BasicDepthRendererCore core_{};
+  SoftwareRendererCore software_core_{};
 };
 
 }  // namespace m3t
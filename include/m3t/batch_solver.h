@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_BATCH_SOLVER_H_
+#define M3T_INCLUDE_M3T_BATCH_SOLVER_H_
+
+#include <Eigen/Dense>
+
+namespace m3t {
+
+/**
+ * \brief Class that solves many independent symmetric positive definite 6x6
+ * systems at once.
+ *
+ * \details Coefficients are stored as structure of arrays. Each column of the
+ * internal data contains the same coefficient of all systems. In this way,
+ * the Cholesky decomposition, forward substitution, and backward substitution
+ * are computed using array operations over all systems, which are vectorized
+ * by Eigen. Systems are set with `SetSystem()` after the number of systems is
+ * defined using `Resize()`. Memory is only allocated if the number of systems
+ * increases. After `Solve()`, `GetSolution()` provides the result of each
+ * system and returns false if the matrix was not positive definite.
+ */
+class BatchSolver {
+ public:
+  // Setup and main methods
+  void Resize(int n_systems);
+  void SetSystem(int idx, const Eigen::Matrix<float, 6, 6> &a,
+                 const Eigen::Matrix<float, 6, 1> &b);
+  void Solve();
+  bool GetSolution(int idx, Eigen::Matrix<float, 6, 1> *theta) const;
+
+  // Getters
+  int n_systems() const;
+
+ private:
+  // Column indices of coefficients
+  static constexpr int LowerIndex(int row, int col) {
+    return row * (row + 1) / 2 + col;
+  }
+  static constexpr int kBIndex = 21;
+  static constexpr int kInverseDiagonalIndex = 27;
+  static constexpr int kNColumns = 33;
+
+  // Internal data
+  int n_systems_ = 0;
+  Eigen::Array<float, Eigen::Dynamic, kNColumns> data_{};
+  Eigen::Array<bool, Eigen::Dynamic, 1> positive_definite_{};
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_BATCH_SOLVER_H_
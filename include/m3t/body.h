@@ -5,12 +5,15 @@
 #define M3T_INCLUDE_M3T_BODY_H_
 
 #include <m3t/common.h>
+#include <m3t/mesh_simplification.h>
 
 #include <filesystem/filesystem.h>
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <array>
 #include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -23,7 +26,20 @@ namespace m3t {
  *
  * \details Calling the `SetUp()` method loads `mesh_indices` and `vertices`
  * from a wavefront obj file and automatically computes the
- * `maximum_body_diameter`.
+ * `maximum_body_diameter`. If `n_lod_levels` is larger than zero, simplified
+ * meshes are generated as levels of detail using \ref MeshSimplifier. Each
+ * level reduces the number of triangles by `lod_reduction_factor`. Renderers
+ * use `SelectLODLevel()` to pick the coarsest level with a geometric error
+ * that is acceptable for the current view. Level 0 refers to the original
+ * mesh. If `use_mesh_cache` is true, vertices and triangles parsed from the
+ * wavefront obj file are stored in a binary file `<geometry_path>.m3tmesh`
+ * next to it or, if `mesh_cache_directory` is set, in a file with the name of
+ * the obj file in that directory. On the next set up, the cache is read
+ * instead of the obj file if the size of the obj file is unchanged and either
+ * its modification time or its content hash matches the values stored in the
+ * cache. Caches with a size that does not match their header are ignored.
+ * Since the cache holds unscaled vertices in the original winding order, it
+ * is independent of all other geometry parameters.
  *
  * @param geometry_path path to wavefront obj file. Using `INFER_FROM_NAME` in
  * the metafile sets the path to `<name>.obj`.
@@ -42,8 +58,32 @@ namespace m3t {
  * @param region_id value that is assigned to pixels by the \ref
  * FullSilhouetteRenderer or \ref FocusedSilhouetteRenderer is the \ref IDType
  * REGION is selected. During construction, a unique id is assigned.
+ * @param n_lod_levels number of simplified meshes that are generated.
+ * @param lod_reduction_factor ratio between the number of triangles of
+ * consecutive levels of detail.
+ * @param use_mesh_cache true if a binary cache of the wavefront obj file
+ * should be read and written.
+ * @param mesh_cache_directory directory in which mesh caches are stored. If
+ * empty, caches are stored next to the wavefront obj file.
  */
 class Body {
+ private:
+  static constexpr float kMinLODTriangles = 8.0f;
+  static constexpr char kMeshCacheMagic[8] = "M3TMESH";
+  static constexpr uint32_t kMeshCacheVersion = 1;
+
+  // Header of binary mesh cache files
+  struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t obj_size;
+    int64_t obj_write_time;
+    uint64_t obj_hash;
+    uint64_t n_vertices;
+    uint64_t n_triangles;
+  };
+
  public:
   // Constructors and initialization methods
   Body(const std::string &name, const std::filesystem::path &geometry_path,
@@ -60,6 +100,11 @@ class Body {
   void set_geometry_counterclockwise(bool geometry_counterclockwise);
   void set_geometry_enable_culling(bool geometry_enable_culling);
   void set_geometry2body_pose(const Transform3fA &geometry2body_pose);
+  void set_n_lod_levels(int n_lod_levels);
+  void set_lod_reduction_factor(float lod_reduction_factor);
+  void set_use_mesh_cache(bool use_mesh_cache);
+  void set_mesh_cache_directory(
+      const std::filesystem::path &mesh_cache_directory);
 
   // ID setters
   void set_id(IDType id_type, uchar id);
@@ -78,6 +123,11 @@ class Body {
   bool geometry_counterclockwise() const;
   bool geometry_enable_culling() const;
   const Transform3fA &geometry2body_pose() const;
+  int n_lod_levels() const;
+  float lod_reduction_factor() const;
+  bool use_mesh_cache() const;
+  const std::filesystem::path &mesh_cache_directory() const;
+  std::filesystem::path mesh_cache_path() const;
 
   // ID getters
   uchar get_id(IDType id_type) const;
@@ -94,6 +144,8 @@ class Body {
   const std::vector<std::array<int, 3>> &mesh_indices() const;
   const std::vector<Eigen::Vector3f> &vertices() const;
   float maximum_body_diameter() const;
+  const std::vector<LODMesh> &lod_meshes() const;
+  int SelectLODLevel(float max_geometric_error) const;
 
   // Internal state
   bool set_up() const;
@@ -102,7 +154,13 @@ class Body {
   // Helper methods
   bool LoadMetaData();
   bool LoadMeshData();
+  bool LoadObjFile();
+  bool LoadMeshCache();
+  void SaveMeshCache() const;
+  bool GetObjFileStatus(uint64_t *obj_size, int64_t *obj_write_time) const;
+  static uint64_t HashFile(const std::filesystem::path &path);
   bool CalculateMaximumBodyDiameter();
+  bool GenerateLODMeshes();
 
   // Geometry data
   std::string name_{};
@@ -112,6 +170,10 @@ class Body {
   bool geometry_counterclockwise_ = true;
   bool geometry_enable_culling_ = true;
   Transform3fA geometry2body_pose_{Transform3fA::Identity()};
+  int n_lod_levels_ = 0;
+  float lod_reduction_factor_ = 0.25f;
+  bool use_mesh_cache_ = false;
+  std::filesystem::path mesh_cache_directory_{};
 
   // ID data
   uchar body_id_ = 0;
@@ -127,6 +189,7 @@ class Body {
   std::vector<std::array<int, 3>> mesh_indices_{};
   std::vector<Eigen::Vector3f> vertices_{};
   float maximum_body_diameter_ = 0.0f;
+  std::vector<LODMesh> lod_meshes_{};
 
   // Internal state
   static std::atomic<uchar> next_id_;
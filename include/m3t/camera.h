@@ -20,9 +20,14 @@ namespace m3t {
  *
  * \details Using the main method `UpdateImage(bool synchronized)`, a new image
  * is obtained. If the flag `synchronized` is true, a corresponding real-world
- * camera waits until a new image arrives. The class also includes functionality
- * to save images using `StartSavingImages()` and `StopSavingImages()`.
+ * camera waits until a new image arrives. Each new image increments
+ * `image_index()`, which allows other objects to detect new images. The class
+ * also includes functionality to save images using `StartSavingImages()` and
+ * `StopSavingImages()`.
  *
+ * @param timestamp time in seconds at which the current image was captured.
+ * It is set by cameras that provide timestamps and can be set by the user
+ * otherwise. If no timestamps are available, it remains 0.
  * @param camera2world_pose pose of the camera relative to the world frame.
  * @param save_directory directory to which images are saved.
  * @param save_index index of the first image that is saved.
@@ -39,6 +44,7 @@ class Camera {
   void set_metafile_path(const std::filesystem::path &metafile_path);
   void set_camera2world_pose(const Transform3fA &camera2world_pose);
   void set_world2camera_pose(const Transform3fA &world2camera_pose);
+  void set_timestamp(double timestamp);
   void StartSavingImages(const std::filesystem::path &save_directory,
                          int save_index = 0,
                          const std::string &save_image_type = "png");
@@ -54,6 +60,8 @@ class Camera {
   const Intrinsics &intrinsics() const;
   const Transform3fA &camera2world_pose() const;
   const Transform3fA &world2camera_pose() const;
+  double timestamp() const;
+  int image_index() const;
   const std::filesystem::path &save_directory() const;
   int save_index() const;
   const std::string &save_image_type() const;
@@ -75,6 +83,8 @@ class Camera {
   Intrinsics intrinsics_{};
   Transform3fA camera2world_pose_{Transform3fA::Identity()};
   Transform3fA world2camera_pose_{Transform3fA::Identity()};
+  double timestamp_ = 0.0;
+  int image_index_ = 0;
   std::filesystem::path save_directory_{};
   int save_index_ = 0;
   std::string save_image_type_ = "png";
@@ -70,12 +70,6 @@ inline Eigen::Matrix3f Vector2Skewsymmetric(const Eigen::Vector3f &vector) {
   return skew_symmetric;
 }
 
-inline float xcotx(float x) {
-  if (tanf(x) <= std::numeric_limits<float>::min()) return 1.0f;
-  if (tanf(x) >= std::numeric_limits<float>::max()) return 0.0f;
-  return x / tan(x);
-}
-
 // Commonly used functions to compare paths
 bool Equivalent(const std::filesystem::path &path1,
                 const std::filesystem::path &path2);
@@ -166,6 +160,15 @@ void DrawFocusedPointInImage(const Eigen::Vector3f &point_f_camera,
                              const Intrinsics &intrinsics, float corner_u,
                              float corner_v, float scale, cv::Mat *image);
 
+// Commonly used function to calculate the region of interest and the scale of
+// a focused image from the projected bounding sphere of a body
+bool CalculateScaleAndRegionOfInterest(const Transform3fA &body2camera_pose,
+                                       float body_radius,
+                                       const Intrinsics &intrinsics,
+                                       int focused_image_size, int margin,
+                                       cv::Rect *region_of_interest,
+                                       float *scale);
+
 // Commonly used functions to access and print vector elements
 template <typename T>
 inline T LastValidValue(const std::vector<T> &values, int idx) {
@@ -6,6 +6,7 @@
 
 #include <m3t/body.h>
 #include <m3t/common.h>
+#include <m3t/lie_group.h>
 #include <m3t/link.h>
 #include <m3t/modality.h>
 
@@ -23,9 +24,10 @@ namespace m3t {
  * constraint Jacobian for the defined data.
  *
  * The method `CalculateResidualAndConstraintJacobian()` computes the residual
- * for constraint directions. In addition, it computes the constraint Jacobian
- * with respect to the degrees of freedom of the kinematic structure, using the
- * Jacobian matrices from both referenced \ref Link objects.
+ * for constraint directions. In addition, it computes the constraint
+ * Jacobians with respect to variations of the first and second body. They are
+ * provided separately such that solvers only consider the two links and
+ * the columns of their sparse \ref Link Jacobians.
  *
  * @param link1_ptr defines the first of the two referenced \ref Link objects
  * that are considered.
@@ -77,7 +79,8 @@ class Constraint {
 
   // Getters residual and constraint Jacobian
   const Eigen::VectorXf &residual();
-  const Eigen::MatrixXf &constraint_jacobian();
+  const Eigen::MatrixXf &link1_constraint_jacobian();
+  const Eigen::MatrixXf &link2_constraint_jacobian();
 
   // Getters
   const std::string &name() const;
@@ -92,14 +95,16 @@ class Constraint {
  private:
   // Helper methods
   bool LoadMetaData();
-  Eigen::VectorXf Residual(const Transform3fA &joint22joint1_pose);
-  Eigen::MatrixXf UnprojectedConstraintJacobian(
-      const Transform3fA &joint22joint1_pose,
-      const Transform3fA &body2joint1_pose);
+  void Residual(const Transform3fA &joint22joint1_pose,
+                Eigen::VectorXf *residual);
+  void UnprojectedConstraintJacobian(const Transform3fA &joint22joint1_pose,
+                                     const Transform3fA &body2joint1_pose,
+                                     Eigen::MatrixXf *jacobian);
 
   // Internal data
   Eigen::VectorXf residual_{};
-  Eigen::MatrixXf constraint_jacobian_{};
+  Eigen::MatrixXf link1_constraint_jacobian_{};
+  Eigen::MatrixXf link2_constraint_jacobian_{};
 
   // Parameters and state variable
   std::string name_{};
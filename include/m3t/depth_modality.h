@@ -194,6 +194,7 @@ class DepthModality : public Modality {
   bool VisualizeOptimization(int save_idx) override;
   bool CalculateResults(int iteration) override;
   bool VisualizeResults(int save_idx) override;
+  bool CalculateScore(float *score) override;
 
   // Getters data
   const std::shared_ptr<DepthCamera> &depth_camera_ptr() const;
@@ -291,6 +292,7 @@ class DepthModality : public Modality {
 
   // Internal data objects
   std::vector<DataPoint> data_points_;
+  int n_considered_points_ = 0;
 
   // Pointers to referenced objects
   std::shared_ptr<DepthCamera> depth_camera_ptr_ = nullptr;
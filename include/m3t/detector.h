@@ -8,6 +8,11 @@
 #include <m3t/common.h>
 #include <m3t/optimizer.h>
 
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
 namespace m3t {
 
 /**
@@ -16,7 +21,9 @@ namespace m3t {
  *
  * \details Using the main method `DetectPoses()`, the poses of all \ref Link
  * and \ref Body objects of \ref Optimizer objects that are specified in `names`
- * are defined. Names of optimizers are returnd in `detected_names`.
+ * are defined. Names of optimizers are returnd in `detected_names`. Detectors
+ * that find multiple candidates for the pose of a root link provide them
+ * with `AddPoseHypotheses()`, e.g. to be evaluated using \ref Refiner.
  *
  * @param reset_joint_poses reset the joint poses of all referenced \ref Link
  * objects.
@@ -34,6 +41,10 @@ class Detector {
   // Main methods
   virtual bool DetectPoses(const std::set<std::string> &names,
                            std::set<std::string> *detected_names) = 0;
+  virtual void AddPoseHypotheses(
+      const std::set<std::string> &names,
+      std::map<std::string, std::vector<Transform3fA>>
+          *link2world_pose_hypotheses) const;
 
   // Getters
   const std::string &name() const;
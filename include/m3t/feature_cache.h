@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_FEATURE_CACHE_H_
+#define M3T_INCLUDE_M3T_FEATURE_CACHE_H_
+
+#include <m3t/body.h>
+#include <m3t/camera.h>
+#include <m3t/common.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <opencv2/features2d.hpp>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace m3t {
+
+/**
+ * \brief Class that detects features and computes descriptors once per image
+ * of a \ref ColorCamera and shares them between multiple \ref TextureModality
+ * objects.
+ *
+ * \details Modalities register their \ref Body and feature detector using
+ * `AddRequest()`. For each new image, the grayscale image is computed once.
+ * Regions of interest are calculated from the projected bounding spheres of
+ * all registered bodies and assigned to pyramid levels with scales of powers
+ * of two that are closest to the scale requested by each modality. For each
+ * level, features are detected once in the union of overlapping regions. Using
+ * `GetFeatures()`, modalities obtain the keypoints and descriptors that lie
+ * inside their own region. A new image is assumed if the image index or the
+ * image data of the camera changes. Repeated requests for the same image,
+ * e.g. from `StartModality()` and `CalculateCorrespondences()`, therefore
+ * return the same features. The feature detector and descriptor of the first
+ * request are used for all modalities. ORB detectors are copied since the
+ * number of features is scaled with the number of merged requests.
+ *
+ * @param color_camera_ptr referenced \ref ColorCamera from which images are
+ * taken.
+ */
+class FeatureCache {
+ private:
+  static constexpr int kRegionOfInterestMargin = 10;  // pixels
+
+  // Request of a modality
+  struct Request {
+    std::string name;
+    std::shared_ptr<Body> body_ptr;
+    int focused_image_size;
+  };
+
+  // Features detected for a request in the current image
+  struct RequestData {
+    bool valid = false;
+    int level = 0;
+    cv::Rect region_of_interest{};
+    std::vector<cv::KeyPoint> keypoints{};
+    cv::Mat descriptors;
+  };
+
+ public:
+  // Constructor and setup method
+  FeatureCache(const std::string &name,
+               const std::shared_ptr<ColorCamera> &color_camera_ptr);
+  bool SetUp();
+
+  // Setters
+  void set_name(const std::string &name);
+  void set_color_camera_ptr(
+      const std::shared_ptr<ColorCamera> &color_camera_ptr);
+
+  // Configure requests
+  bool AddRequest(const std::string &name,
+                  const std::shared_ptr<Body> &body_ptr,
+                  int focused_image_size,
+                  const cv::Ptr<cv::Feature2D> &feature_detector,
+                  const cv::Ptr<cv::Feature2D> &feature_descriptor);
+  bool DeleteRequest(const std::string &name);
+  void ClearRequests();
+
+  // Main method
+  bool GetFeatures(const std::string &name,
+                   std::vector<cv::KeyPoint> *keypoints,
+                   cv::Mat *descriptors);
+
+  // Getters
+  const std::string &name() const;
+  const std::shared_ptr<ColorCamera> &color_camera_ptr() const;
+  const cv::Mat &gray_image() const;
+  bool set_up() const;
+
+ private:
+  // Helper methods
+  bool IsNewImage() const;
+  void DetectAndComputeFeatures();
+  bool CalculateScaleAndRegionOfInterest(const Request &request,
+                                         cv::Rect *region_of_interest,
+                                         float *scale) const;
+  void DetectAndComputeRegion(const cv::Rect &region_of_interest, float scale,
+                              int n_requests,
+                              std::vector<cv::KeyPoint> *keypoints,
+                              cv::Mat *descriptors);
+
+  // Internal data objects
+  std::vector<Request> requests_{};
+  std::map<std::string, RequestData> request_data_{};
+  cv::Ptr<cv::Feature2D> feature_detector_;
+  cv::Ptr<cv::Feature2D> feature_descriptor_;
+  cv::Ptr<cv::ORB> orb_detector_;
+  int orb_n_features_ = 0;
+  cv::Mat gray_image_;
+  const uchar *image_data_ = nullptr;
+  int image_index_ = 0;
+
+  // Pointers to referenced objects
+  std::shared_ptr<ColorCamera> color_camera_ptr_ = nullptr;
+
+  // Parameters
+  std::string name_{};
+  bool set_up_ = false;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_FEATURE_CACHE_H_
@@ -33,6 +33,7 @@
 #include <m3t/renderer_geometry.h>
 #include <m3t/soft_constraint.h>
 #include <m3t/static_detector.h>
+#include <m3t/template_detector.h>
 #include <m3t/subscriber.h>
 #include <m3t/texture_modality.h>
 #include <m3t/tracker.h>
@@ -852,6 +853,41 @@ inline bool ConfigureManualDetectors(
       detector_ptrs);
 }
 
+inline bool ConfigureTemplateDetectors(
+    const std::filesystem::path& configfile_path,
+    const cv::FileStorage& file_storage,
+    const std::vector<std::shared_ptr<Optimizer>>& optimizer_ptrs,
+    const std::vector<std::shared_ptr<ColorCamera>>& color_camera_ptrs,
+    const std::vector<std::shared_ptr<RegionModel>>& region_model_ptrs,
+    std::vector<std::shared_ptr<Detector>>* detector_ptrs) {
+  std::string class_name{"TemplateDetector"};
+  return ConfigureObjects<TemplateDetector>(
+      file_storage, class_name,
+      {"name", "optimizer", "color_camera", "region_model"},
+      [&](const auto& file_node, auto* detector_ptr) {
+        std::shared_ptr<Optimizer> optimizer_ptr;
+        std::shared_ptr<ColorCamera> color_camera_ptr;
+        std::shared_ptr<RegionModel> region_model_ptr;
+        if (!GetObject(file_node, "optimizer", class_name, optimizer_ptrs,
+                       &optimizer_ptr) ||
+            !GetObject(file_node, "color_camera", class_name, color_camera_ptrs,
+                       &color_camera_ptr) ||
+            !GetObject(file_node, "region_model", class_name, region_model_ptrs,
+                       &region_model_ptr))
+          return false;
+        if (MetafilePathEmpty(file_node))
+          *detector_ptr = std::make_shared<TemplateDetector>(
+              Name(file_node), optimizer_ptr, color_camera_ptr,
+              region_model_ptr);
+        else
+          *detector_ptr = std::make_shared<TemplateDetector>(
+              Name(file_node), MetafilePath(file_node, configfile_path),
+              optimizer_ptr, color_camera_ptr, region_model_ptr);
+        return true;
+      },
+      detector_ptrs);
+}
+
 inline bool ConfigureRefiners(
     const std::filesystem::path& configfile_path,
     const cv::FileStorage& file_storage,
@@ -1095,7 +1131,10 @@ inline bool GenerateConfiguredTracker(
   if (!ConfigureStaticDetectors(configfile_path, fs, optimizer_ptrs,
                                 &detector_ptrs) ||
       !ConfigureManualDetectors(configfile_path, fs, optimizer_ptrs,
-                                color_camera_ptrs, &detector_ptrs))
+                                color_camera_ptrs, &detector_ptrs) ||
+      !ConfigureTemplateDetectors(configfile_path, fs, optimizer_ptrs,
+                                  color_camera_ptrs, region_model_ptrs,
+                                  &detector_ptrs))
     return false;
 
   // Configure publishers
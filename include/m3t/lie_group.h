@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_LIE_GROUP_H_
+#define M3T_INCLUDE_M3T_LIE_GROUP_H_
+
+#include <m3t/common.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <cmath>
+
+namespace m3t {
+
+// Kernels for rotations and rigid body transformations. Variations of poses
+// are ordered as rotation followed by translation. Poses are assumed to be
+// rigid such that the linear part of a transformation is its rotation.
+
+// Thresholds below which small-angle series expansions are used
+constexpr float kLieGroupSmallAngleSquared = 1.0e-2f;
+constexpr float kLieGroupSmallSine = 1.0e-4f;
+
+// Rotation matrix for a rotation vector using the Rodrigues formula
+inline Eigen::Matrix3f ExpSO3(const Eigen::Vector3f &rotation_vector) {
+  float angle_squared = rotation_vector.squaredNorm();
+  float sinc, cosc;
+  if (angle_squared < kLieGroupSmallAngleSquared) {
+    sinc = 1.0f - angle_squared * (1.0f / 6.0f -
+                                   angle_squared * (1.0f / 120.0f));
+    cosc = 0.5f - angle_squared * (1.0f / 24.0f -
+                                   angle_squared * (1.0f / 720.0f));
+  } else {
+    float angle = std::sqrt(angle_squared);
+    float sin_angle_half = std::sin(0.5f * angle);
+    sinc = std::sin(angle) / angle;
+    cosc = 2.0f * sin_angle_half * sin_angle_half / angle_squared;
+  }
+  Eigen::Matrix3f skew_symmetric{Vector2Skewsymmetric(rotation_vector)};
+  return Eigen::Matrix3f::Identity() + sinc * skew_symmetric +
+         cosc * skew_symmetric * skew_symmetric;
+}
+
+// Rotation vector for a rotation matrix
+inline Eigen::Vector3f LogSO3(const Eigen::Matrix3f &rotation) {
+  Eigen::Vector3f vee{rotation(2, 1) - rotation(1, 2),
+                      rotation(0, 2) - rotation(2, 0),
+                      rotation(1, 0) - rotation(0, 1)};
+  float cos_angle_double = rotation.trace() - 1.0f;
+  float sin_angle_double = vee.norm();
+  if (sin_angle_double < kLieGroupSmallSine) {
+    if (cos_angle_double > 0.0f) return 0.5f * vee;
+    Eigen::AngleAxisf angle_axis{rotation};
+    return angle_axis.angle() * angle_axis.axis();
+  }
+  float angle = std::atan2(sin_angle_double, cos_angle_double);
+  return (angle / sin_angle_double) * vee;
+}
+
+// Inverse of the left Jacobian that maps variations of the rotation vector
+inline Eigen::Matrix3f InverseLeftJacobianSO3(
+    const Eigen::Vector3f &rotation_vector) {
+  float angle_squared = rotation_vector.squaredNorm();
+  float factor;
+  if (angle_squared < kLieGroupSmallAngleSquared) {
+    factor = 1.0f / 12.0f + angle_squared * (1.0f / 720.0f);
+  } else {
+    float angle_half = 0.5f * std::sqrt(angle_squared);
+    factor = (1.0f - angle_half / std::tan(angle_half)) / angle_squared;
+  }
+  Eigen::Matrix3f skew_symmetric{Vector2Skewsymmetric(rotation_vector)};
+  return Eigen::Matrix3f::Identity() - 0.5f * skew_symmetric +
+         factor * skew_symmetric * skew_symmetric;
+}
+
+// Left Jacobian that maps variations of the rotation vector
+inline Eigen::Matrix3f LeftJacobianSO3(const Eigen::Vector3f &rotation_vector) {
+  float angle_squared = rotation_vector.squaredNorm();
+  float cosc, sinc_complement;
+  if (angle_squared < kLieGroupSmallAngleSquared) {
+    cosc = 0.5f - angle_squared * (1.0f / 24.0f -
+                                   angle_squared * (1.0f / 720.0f));
+    sinc_complement = 1.0f / 6.0f -
+                      angle_squared * (1.0f / 120.0f -
+                                       angle_squared * (1.0f / 5040.0f));
+  } else {
+    float angle = std::sqrt(angle_squared);
+    float sin_angle_half = std::sin(0.5f * angle);
+    cosc = 2.0f * sin_angle_half * sin_angle_half / angle_squared;
+    sinc_complement = (angle - std::sin(angle)) / (angle_squared * angle);
+  }
+  Eigen::Matrix3f skew_symmetric{Vector2Skewsymmetric(rotation_vector)};
+  return Eigen::Matrix3f::Identity() + cosc * skew_symmetric +
+         sinc_complement * skew_symmetric * skew_symmetric;
+}
+
+// Pose for a twist that consists of a rotation vector and a translation
+inline Transform3fA ExpSE3(const Eigen::Matrix<float, 6, 1> &twist) {
+  const Eigen::Vector3f rotation_vector{twist.head<3>()};
+  Transform3fA pose;
+  pose.linear() = ExpSO3(rotation_vector);
+  pose.translation().noalias() =
+      LeftJacobianSO3(rotation_vector) * twist.tail<3>();
+  pose.makeAffine();
+  return pose;
+}
+
+// Twist that consists of a rotation vector and a translation for a pose
+inline Eigen::Matrix<float, 6, 1> LogSE3(const Transform3fA &pose) {
+  const Eigen::Vector3f rotation_vector{LogSO3(pose.linear())};
+  Eigen::Matrix<float, 6, 1> twist;
+  twist.head<3>() = rotation_vector;
+  twist.tail<3>().noalias() =
+      InverseLeftJacobianSO3(rotation_vector) * pose.translation();
+  return twist;
+}
+
+// Adjoint that transforms variations from the source to the target frame of
+// the pose
+inline Eigen::Matrix<float, 6, 6> AdjointSE3(const Transform3fA &pose) {
+  const auto &rotation{pose.linear()};
+  Eigen::Matrix<float, 6, 6> adjoint;
+  adjoint.topLeftCorner<3, 3>() = rotation;
+  adjoint.topRightCorner<3, 3>().setZero();
+  adjoint.bottomLeftCorner<3, 3>().noalias() =
+      Vector2Skewsymmetric(pose.translation()) * rotation;
+  adjoint.bottomRightCorner<3, 3>() = rotation;
+  return adjoint;
+}
+
+// Applies the adjoint of the pose to columns of variations without forming
+// the 6x6 matrix
+void ApplyAdjointSE3(
+    const Transform3fA &pose,
+    const Eigen::Ref<const Eigen::Matrix<float, 6, Eigen::Dynamic>> &variations,
+    Eigen::Ref<Eigen::Matrix<float, 6, Eigen::Dynamic>> result);
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_LIE_GROUP_H_
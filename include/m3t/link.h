@@ -6,13 +6,13 @@
 
 #include <m3t/body.h>
 #include <m3t/common.h>
+#include <m3t/lie_group.h>
 #include <m3t/modality.h>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
 #include <iostream>
 #include <string>
-#include <unsupported/Eigen/MatrixFunctions>
 #include <vector>
 
 namespace m3t {
@@ -29,14 +29,29 @@ namespace m3t {
  * Jacobian while the parameter `first_jacobian_index` defines the location of
  * the \ref Link object's free directions within the Jacobian. The method
  * `CalculateJacobian()` calculates the Jacobian of the \ref Link based on the
- * Jacobian of the parent \ref Link. The method `CalculateGradientAndHessian()`
- * combines the gradient vectors and Hessian matrices from all referenced \ref
- * Modality objects. `UpdatePoses()` takes the variation vector for the
- * kinematic structure to update the pose of the joint and the referenced \ref
- * Body. If the \ref Link has no parent, only the pose of the \ref Body is
- * updated. The variation is thereby considered in the joint coordinate frame.
- * If the \ref Link does not reference a \ref Body, the internal
- * `link2world_pose` is updated.
+ * Jacobian of the parent \ref Link. Since the Jacobian only depends on free
+ * directions of the \ref Link and its ancestors, only those columns are
+ * stored. They are ordered from the root to the \ref Link, and
+ * `jacobian_blocks` defines where the columns of each ancestor are located
+ * within the full Jacobian. In addition, the adjoint that maps variations of
+ * the parent body to variations of the body and the Jacobian of the body with
+ * respect to free joint directions are provided. They allow solvers to
+ * exploit the tree structure. Both are cached and only recomputed if the
+ * corresponding joint poses change. Columns of the parent Jacobian are
+ * projected using `ApplyAdjointSE3()`, and the 6x6 adjoint is only formed
+ * when `parent_adjoint()` is requested. The method
+ * `CalculateGradientAndHessian()` combines the gradient vectors and Hessian
+ * matrices from all referenced \ref Modality objects. `UpdatePoses()` takes
+ * the variation vector for the kinematic structure to update the pose of the
+ * joint and the referenced \ref Body. If the \ref Link has no parent, only
+ * the pose of the \ref Body is updated. The variation is thereby considered
+ * in the joint coordinate frame. If the \ref Link does not reference a \ref
+ * Body, the internal `link2world_pose` is updated. `ApplyJointVariation()`
+ * performs the same update for a variation vector of all six joint
+ * directions. `RevertPoses()` and `RevertJointVariation()` exactly undo the
+ * corresponding updates if they are called from the root to the leaves.
+ * `ResetJointPoses()` sets joint poses to the values that were defined by
+ * the user while `SetJointPoses()` sets them without changing those values.
  *
  * @param body_ptr referenced \ref Body object that contains the pose.
  * @param modality_ptrs defines the referenced \ref Modality objects that are
@@ -66,6 +81,13 @@ namespace m3t {
  */
 class Link {
  public:
+  // Consecutive columns of the Jacobian that belong to a single link
+  struct JacobianBlock {
+    int first_jacobian_index;
+    int first_column;
+    int n_columns;
+  };
+
   // Constructors and setup methods
   Link(const std::string &name, const std::shared_ptr<Body> &body_ptr = nullptr,
        const Transform3fA &body2joint_pose = Transform3fA::Identity(),
@@ -104,8 +126,16 @@ class Link {
       const Eigen::Matrix<float, 6, 1> &gradient_summand,
       const Eigen::Matrix<float, 6, 6> &hessian_summand);
   bool UpdatePoses(const std::shared_ptr<Link> &parent_link_ptr,
-                   Eigen::VectorXf theta);
+                   const Eigen::VectorXf &theta);
+  bool ApplyJointVariation(const std::shared_ptr<Link> &parent_link_ptr,
+                           const Eigen::Matrix<float, 6, 1> &joint_variation);
+  bool RevertPoses(const std::shared_ptr<Link> &parent_link_ptr,
+                   const Eigen::VectorXf &theta);
+  bool RevertJointVariation(const std::shared_ptr<Link> &parent_link_ptr,
+                            const Eigen::Matrix<float, 6, 1> &joint_variation);
   void ResetJointPoses();
+  void SetJointPoses(const Transform3fA &body2joint_pose,
+                     const Transform3fA &joint2parent_pose);
 
   // Additional Methods
   int DegreesOfFreedom() const;
@@ -114,6 +144,9 @@ class Link {
   const Eigen::Matrix<float, 6, 1> &gradient();
   const Eigen::Matrix<float, 6, 6> &hessian();
   const Eigen::Matrix<float, 6, Eigen::Dynamic> &jacobian();
+  const std::vector<JacobianBlock> &jacobian_blocks();
+  const Eigen::Matrix<float, 6, 6> &parent_adjoint();
+  const Eigen::Matrix<float, 6, Eigen::Dynamic, 0, 6, 6> &joint_jacobian();
 
   // Getters
   const std::string &name() const;
@@ -133,12 +166,20 @@ class Link {
   // Helper methods
   bool LoadMetaData();
   bool IsSetup(bool check_jacobian_defined);
-  static Eigen::Matrix<float, 6, 6> Adjoint(const Transform3fA &pose);
+  Eigen::Matrix<float, 6, 1> JointVariation(const Eigen::VectorXf &theta) const;
+  static Transform3fA PoseVariation(
+      const Eigen::Matrix<float, 6, 1> &joint_variation);
+  void ApplyPoseVariation(const std::shared_ptr<Link> &parent_link_ptr,
+                          const Transform3fA &pose_variation);
 
   // Internal data
   Eigen::Matrix<float, 6, 1> gradient_{};
   Eigen::Matrix<float, 6, 6> hessian_{};
   Eigen::Matrix<float, 6, Eigen::Dynamic> jacobian_{};
+  std::vector<JacobianBlock> jacobian_blocks_{};
+  Eigen::Matrix<float, 6, 6> parent_adjoint_{};
+  Transform3fA parent2body_pose_{Transform3fA::Identity()};
+  Eigen::Matrix<float, 6, Eigen::Dynamic, 0, 6, 6> joint_jacobian_{};
   int first_jacobian_index_ = 0;
 
   // Parameters
@@ -157,6 +198,9 @@ class Link {
 
   // State variables
   bool jacobian_defined_ = false;
+  bool joint_jacobian_valid_ = false;
+  bool parent_adjoint_valid_ = false;
+  bool parent2body_pose_valid_ = false;
   bool set_up_ = false;
 };
 
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_MESH_SIMPLIFICATION_H_
+#define M3T_INCLUDE_M3T_MESH_SIMPLIFICATION_H_
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <vector>
+
+namespace m3t {
+
+/**
+ * \brief Simplified triangle mesh that is used as level of detail of a \ref
+ * Body.
+ *
+ * @param vertices vertices of the simplified mesh.
+ * @param mesh_indices indices of vertices that form triangles.
+ * @param geometric_error estimate of the maximum distance in meter between
+ * the simplified and the original surface.
+ */
+struct LODMesh {
+  std::vector<Eigen::Vector3f> vertices{};
+  std::vector<std::array<int, 3>> mesh_indices{};
+  float geometric_error = 0.0f;
+};
+
+/**
+ * \brief Class that simplifies triangle meshes by iteratively collapsing the
+ * edge with the lowest quadric error.
+ *
+ * \details Following Garland and Heckbert, each vertex accumulates a quadric
+ * that measures squared distances to the planes of adjacent triangles. Planes
+ * perpendicular to boundary edges are added to preserve open borders. Edges
+ * are collapsed into the position that minimizes the combined quadric.
+ * Collapses that flip triangles or change the topology are rejected. Vertices
+ * with identical positions are merged before simplification. Whenever the
+ * number of triangles reaches one of `target_n_triangles`, which have to be
+ * sorted in descending order, the current mesh is stored. Its geometric error
+ * is the square root of the highest collapse cost so far. If no further edges
+ * can be collapsed, fewer meshes than targets are returned.
+ */
+class MeshSimplifier {
+ private:
+  static constexpr double kBoundaryWeight = 10.0;
+  using Quadric = Eigen::Matrix4d;
+
+  // Candidate for an edge collapse
+  struct Collapse {
+    double cost;
+    int vertex_1;
+    int vertex_2;
+    int version_1;
+    int version_2;
+    Eigen::Vector3d position;
+    bool operator>(const Collapse &collapse) const {
+      return cost > collapse.cost;
+    }
+  };
+
+ public:
+  // Main method
+  void Simplify(const std::vector<Eigen::Vector3f> &vertices,
+                const std::vector<std::array<int, 3>> &mesh_indices,
+                const std::vector<int> &target_n_triangles,
+                std::vector<LODMesh> *lod_meshes);
+
+ private:
+  // Helper methods
+  void Initialize(const std::vector<Eigen::Vector3f> &vertices,
+                  const std::vector<std::array<int, 3>> &mesh_indices);
+  void InitializeQuadrics();
+  void InitializeCollapses();
+  void PushCollapse(int vertex_1, int vertex_2);
+  bool IsCollapseValid(const Collapse &collapse) const;
+  void ApplyCollapse(const Collapse &collapse);
+  void ExtractMesh(float geometric_error, LODMesh *lod_mesh) const;
+  static bool Contains(const std::array<int, 3> &triangle, int vertex);
+  static Eigen::Vector4d Plane(const Eigen::Vector3d &normal,
+                               const Eigen::Vector3d &point);
+
+  // Internal data
+  std::vector<Eigen::Vector3d> positions_{};
+  std::vector<Quadric> quadrics_{};
+  std::vector<int> versions_{};
+  std::vector<std::array<int, 3>> triangles_{};
+  std::vector<bool> triangle_removed_{};
+  std::vector<std::vector<int>> vertex_triangles_{};
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>
+      collapses_{};
+  int n_triangles_ = 0;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_MESH_SIMPLIFICATION_H_
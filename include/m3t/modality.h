@@ -31,7 +31,10 @@ namespace m3t {
  * `CalculateCorrespondences()`, `VisualizeCorrespondences()`,
  * `CalculateGradientAndHessian()`, `VisualizeOptimization()`,
  * `CalculateResults()`, and `VisualizeResults()` that are used by the \ref
- * Tracker object to coordinate tracking. The getter functions
+ * Tracker object to coordinate tracking. `CalculateScore()` evaluates how
+ * well the current pose is supported by established correspondences. Scores
+ * are between 0 and 1 and allow the comparison of pose hypotheses. Modalities
+ * that do not implement the method return 0. The getter functions
  * `imshow_correspondence()`, `imshow_optimization()`, and `imshow_result()`
  * indicate if `VisualizeCorrespondences()`, `VisualizeOptimization()`, and
  * `VisualizeResults()` show images. The class also includes functionality to
@@ -84,6 +87,7 @@ class Modality {
   virtual bool VisualizeOptimization(int save_idx) = 0;
   virtual bool CalculateResults(int iteration) = 0;
   virtual bool VisualizeResults(int save_idx) = 0;
+  virtual bool CalculateScore(float *score);
 
   // Getters gradient and hessian
   const Eigen::Matrix<float, 6, 1> &gradient() const;
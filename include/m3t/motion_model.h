@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_MOTION_MODEL_H_
+#define M3T_INCLUDE_M3T_MOTION_MODEL_H_
+
+#include <m3t/common.h>
+#include <m3t/lie_group.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+namespace m3t {
+
+/**
+ * \brief Class that predicts poses using a constant velocity model.
+ *
+ * \details The velocity is a twist in the frame of the pose that is estimated
+ * from the two most recent poses given to `Update()`. `Predict()` then
+ * extrapolates the most recent pose to a given timestamp. The velocity is
+ * scaled by the difference of timestamps to consider variable frame
+ * intervals. If timestamps do not increase, e.g. because a camera does not
+ * provide them, each update is considered a time step of one. If
+ * `use_kalman_filter` is true, each velocity component is filtered
+ * independently. Changes of the velocity are modeled as a random walk with
+ * variance `process_noise` per time unit while velocities computed from
+ * consecutive poses have variance `measurement_noise`.
+ *
+ * @param use_kalman_filter true if velocities should be filtered.
+ * @param process_noise variance of velocity changes per time unit.
+ * @param measurement_noise variance of velocities computed from poses.
+ */
+class MotionModel {
+ public:
+  // Main methods
+  void Reset();
+  void Update(const Transform3fA &pose, double timestamp);
+  bool Predict(double timestamp, Transform3fA *pose) const;
+
+  // Setters
+  void set_use_kalman_filter(bool use_kalman_filter);
+  void set_process_noise(float process_noise);
+  void set_measurement_noise(float measurement_noise);
+
+  // Getters
+  bool use_kalman_filter() const;
+  float process_noise() const;
+  float measurement_noise() const;
+  const Eigen::Matrix<float, 6, 1> &velocity() const;
+  bool velocity_valid() const;
+
+ private:
+  // Helper methods
+  float TimeStep(double timestamp) const;
+
+  // Internal data
+  Transform3fA pose_{Transform3fA::Identity()};
+  double timestamp_ = 0.0;
+  Eigen::Matrix<float, 6, 1> velocity_{Eigen::Matrix<float, 6, 1>::Zero()};
+  Eigen::Matrix<float, 6, 1> velocity_variance_{
+      Eigen::Matrix<float, 6, 1>::Zero()};
+  bool pose_valid_ = false;
+  bool velocity_valid_ = false;
+
+  // Parameters
+  bool use_kalman_filter_ = false;
+  float process_noise_ = 10.0f;
+  float measurement_noise_ = 1.0f;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_MOTION_MODEL_H_
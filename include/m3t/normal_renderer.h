@@ -12,6 +12,7 @@
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -24,6 +25,12 @@ namespace m3t {
 /**
  * \brief Class that implements the main functionality for a normal renderer and
  * is used by \ref FullBasicDepthRenderer and \ref FocusedBasicDepthRenderer.
+ *
+ * \details If `use_linear_depth` is true, a second shader program writes depth
+ * values that are linear between the near and far plane to a second color
+ * attachment from which depth images are read. Bodies that share
+ * vertex objects are drawn with instanced draw calls that take poses from
+ * uniform arrays.
  */
 class NormalRendererCore {
  public:
@@ -33,7 +40,9 @@ class NormalRendererCore {
   NormalRendererCore &operator=(const NormalRendererCore &) = delete;
   ~NormalRendererCore();
   bool SetUp(const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-             int image_width, int image_height);
+             int image_width, int image_height,
+             bool use_pixel_buffer_readback = false, int context_id = 0,
+             bool use_linear_depth = false, float lod_max_pixel_error = 0.0f);
 
   // Main methods
   bool StartRendering(const Eigen::Matrix4f &projection_matrix,
@@ -50,16 +59,28 @@ class NormalRendererCore {
   std::shared_ptr<RendererGeometry> renderer_geometry_ptr_;
   int image_width_;
   int image_height_;
+  bool use_pixel_buffer_readback_ = false;
+  int context_id_ = 0;
+  bool use_linear_depth_ = false;
+  float lod_max_pixel_error_ = 0.0f;
+  std::vector<InstanceGroup> instance_groups_{};
+  std::array<Eigen::Matrix4f, kMaxNInstances> transs_{};
+  std::array<Eigen::Matrix3f, kMaxNInstances> rots_{};
 
   // Shader code
   static std::string vertex_shader_code_;
   static std::string fragment_shader_code_;
+  static std::string linear_fragment_shader_code_;
 
   // OpenGL variables
   unsigned fbo_ = 0;
   unsigned rbo_normal_ = 0;
   unsigned rbo_depth_ = 0;
+  unsigned rbo_linear_depth_ = 0;
   unsigned shader_program_ = 0;
+  unsigned linear_shader_program_ = 0;
+  PixelBufferReader normal_reader_{};
+  PixelBufferReader depth_reader_{};
 
   // Internal state
   bool image_rendered_ = false;
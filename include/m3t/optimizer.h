@@ -8,10 +8,12 @@
 #include <m3t/common.h>
 #include <m3t/constraint.h>
 #include <m3t/link.h>
+#include <m3t/motion_model.h>
 #include <m3t/soft_constraint.h>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -35,6 +37,48 @@ namespace m3t {
  * objects are updated. The method `ReferencedLinks()` provides a list of all
  * links that are considered by the optimizer.
  *
+ * If `use_tree_solver` is true, the normal equations are not assembled.
+ * Instead, similar to articulated-body algorithms, Hessians of links are
+ * recursively projected from the leaves to the root while the degrees of
+ * freedom of each joint are eliminated. A forward pass then computes joint
+ * variations from the root to the leaves. The cost is linear in the number of
+ * links. Constraints are considered by solving the system for unit forces on
+ * the two links of each constraint row and by computing Lagrange multipliers
+ * from the resulting Schur complement. Otherwise, the dense system is solved
+ * using an LDLT decomposition. All matrices and vectors that are required
+ * during the optimization are allocated in `SetUp()` and reused in every
+ * iteration. If the structure consists of a single \ref Link with six free
+ * directions and no constraints or soft constraints are assigned, both
+ * solvers are bypassed. The system is then solved with fixed-size matrices
+ * and a Cholesky decomposition. If, in addition, Levenberg-Marquardt is not
+ * used, `IsBatchable()` is true and the system can be solved together with
+ * those of other optimizers. `CalculateSingleLinkSystem()` then provides the
+ * system while `ApplySingleLinkVariation()` updates poses with the solution.
+ *
+ * If `use_levenberg_marquardt` is true, the Tikhonov regularization is scaled
+ * by an adaptive damping factor. For each step, the increase of the
+ * log-likelihood that is predicted by the quadratic model of gradient vectors
+ * and Hessian matrices is compared to the actual increase. The actual increase
+ * is approximated from gradient vectors before and after the step using the
+ * trapezoidal rule. Because of this, a step is evaluated in the following
+ * update iteration, after gradients were recalculated for the new poses. If
+ * the ratio of actual and predicted increase is below
+ * `step_acceptance_ratio`, the step is rejected and poses are reverted. The
+ * damping factor is increased by `damping_adaption_factor` for small ratios
+ * and decreased for ratios close to one. Steps are not evaluated across
+ * correspondence iterations since correspondences change the cost. The last
+ * step of each correspondence iteration is therefore always kept without
+ * evaluation. At the start of each frame, the damping factor is reset to one.
+ * If the variations of all rotational and translational degrees of freedom
+ * are below the convergence thresholds, `converged()` is true.
+ *
+ * If `use_motion_model` is true, `PredictPoses()` extrapolates the pose of
+ * the root link to the timestamp of the next frame using a constant velocity
+ * model in se(3). Joint poses remain unchanged. The model is updated with
+ * the final pose of each frame using `UpdateMotionModel()` and reset with
+ * `ResetMotionModel()`. If `use_kalman_filter` is true, the velocity is
+ * filtered to reduce the influence of noisy pose estimates.
+ *
  * @param root_link_ptr referenced \ref Link object that is at the root of
  * the corresponding tree-like kinematic structure that should be optimized.
  * @param constraint_ptrs defines the referenced \ref Constraint objects that
@@ -44,8 +88,51 @@ namespace m3t {
  * @param tikhonov_parameter_rotation regularization parameter for rotation.
  * @param tikhonov_parameter_translation regularization parameter for
  * translation.
+ * @param use_tree_solver true if the tree-structured solver should be used
+ * instead of the dense decomposition.
+ * @param use_levenberg_marquardt true if steps should be evaluated and the
+ * regularization should be adapted. The last update step of every
+ * correspondence iteration is never evaluated.
+ * @param step_acceptance_ratio minimum ratio of actual and predicted increase
+ * for which steps are accepted.
+ * @param damping_adaption_factor factor by which the damping is increased or
+ * decreased.
+ * @param min_damping_factor minimum factor that scales the regularization.
+ * @param max_damping_factor maximum factor that scales the regularization.
+ * @param convergence_threshold_rotation maximum rotational variation in
+ * radian for which the optimization is considered converged.
+ * @param convergence_threshold_translation maximum translational variation in
+ * meter for which the optimization is considered converged.
+ * @param use_motion_model true if poses should be predicted before tracking.
+ * @param use_kalman_filter true if the velocity of the motion model should be
+ * filtered.
+ * @param kalman_process_noise variance of velocity changes per second.
+ * @param kalman_measurement_noise variance of velocities that are computed
+ * from consecutive poses.
  */
 class Optimizer {
+ private:
+  // Data of a link in depth-first order that is used by the tree solver
+  struct TreeLinkData {
+    Link *link_ptr = nullptr;
+    int parent_index = -1;
+    int first_index = 0;
+    int n_dofs = 0;
+    Eigen::Matrix<float, 6, 6> articulated_hessian{};
+    Eigen::Matrix<float, 6, 1> articulated_gradient{};
+    Eigen::Matrix<float, 6, Eigen::Dynamic, 0, 6, 6> hessian_joint_jacobian{};
+    Eigen::LDLT<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6>>
+        joint_ldlt{};
+    Eigen::Matrix<float, Eigen::Dynamic, 1, 0, 6, 1> joint_variation{};
+    Eigen::Matrix<float, 6, 1> variation{};
+  };
+
+  // Indices of constraint links in the tree solver data
+  struct TreeConstraintData {
+    int link1_index = 0;
+    int link2_index = 0;
+  };
+
  public:
   // Constructors and setup methods
   Optimizer(const std::string &name, const std::shared_ptr<Link> &root_link_ptr,
@@ -69,12 +156,36 @@ class Optimizer {
   void set_metafile_path(const std::filesystem::path &metafile_path);
   void set_tikhonov_parameter_rotation(float tikhonov_parameter_rotation);
   void set_tikhonov_parameter_translation(float tikhonov_parameter_translation);
+  void set_use_tree_solver(bool use_tree_solver);
+  void set_use_levenberg_marquardt(bool use_levenberg_marquardt);
+  void set_step_acceptance_ratio(float step_acceptance_ratio);
+  void set_damping_adaption_factor(float damping_adaption_factor);
+  void set_min_damping_factor(float min_damping_factor);
+  void set_max_damping_factor(float max_damping_factor);
+  void set_convergence_threshold_rotation(float convergence_threshold_rotation);
+  void set_convergence_threshold_translation(
+      float convergence_threshold_translation);
+  void set_use_motion_model(bool use_motion_model);
+  void set_use_kalman_filter(bool use_kalman_filter);
+  void set_kalman_process_noise(float kalman_process_noise);
+  void set_kalman_measurement_noise(float kalman_measurement_noise);
 
   // Main methods
   bool CalculateConsistentPoses();
   bool CalculateOptimization(int iteration, int corr_iteration,
                              int opt_iteration);
 
+  // Methods for batched optimization of single links
+  bool IsBatchable() const;
+  bool CalculateSingleLinkSystem(Eigen::Matrix<float, 6, 6> *a,
+                                 Eigen::Matrix<float, 6, 1> *b);
+  bool ApplySingleLinkVariation(const Eigen::Matrix<float, 6, 1> &theta);
+
+  // Methods for motion model
+  bool PredictPoses(double timestamp);
+  bool UpdateMotionModel(double timestamp);
+  void ResetMotionModel();
+
   // Additional methods
   std::vector<std::shared_ptr<Link>> ReferencedLinks();
 
@@ -87,6 +198,20 @@ class Optimizer {
       const;
   float tikhonov_parameter_rotation() const;
   float tikhonov_parameter_translation() const;
+  bool use_tree_solver() const;
+  bool use_levenberg_marquardt() const;
+  float step_acceptance_ratio() const;
+  float damping_adaption_factor() const;
+  float min_damping_factor() const;
+  float max_damping_factor() const;
+  float convergence_threshold_rotation() const;
+  float convergence_threshold_translation() const;
+  bool use_motion_model() const;
+  bool use_kalman_filter() const;
+  float kalman_process_noise() const;
+  float kalman_measurement_noise() const;
+  float damping_factor() const;
+  bool converged() const;
   bool set_up() const;
 
  private:
@@ -99,24 +224,59 @@ class Optimizer {
   bool DefineJacobians(const std::shared_ptr<Link> &link_ptr,
                        int *first_jacobian_index);
   void DefineTikhonovVector();
-  void DefineTikhonovVector(const std::shared_ptr<Link> &link_ptr,
-                            Eigen::VectorXf *tikhonov_vector) const;
+  void DefineConvergenceVector();
+  void DefineDirectionVector(const std::shared_ptr<Link> &link_ptr,
+                             float value_rotation, float value_translation,
+                             Eigen::VectorXf *direction_vector) const;
+  void DefineWorkspaces();
   void AddReferencedLinks(
       const std::shared_ptr<Link> &link_ptr,
       std::vector<std::shared_ptr<Link>> *referenced_links) const;
+  bool DefineTreeData();
+  void AddTreeLinkData(const std::shared_ptr<Link> &link_ptr,
+                       int parent_index);
+  int TreeLinkIndex(const Link *link_ptr) const;
 
   // Helper methods for optimization
   bool CalculateDataLinks();
   bool CalculateDataLinks(const std::shared_ptr<Link> &link_ptr,
                           const std::shared_ptr<Link> &parent_link_ptr);
   bool CalculateDataConstraints() const;
-  void AddProjectedGradientsAndHessians(Eigen::VectorXf *b,
-                                        Eigen::MatrixXf *a) const;
+  void AddProjectedGradientsAndHessians(Eigen::VectorXf *b, Eigen::MatrixXf *a);
   void AddProjectedGradientsAndHessians(const std::shared_ptr<Link> &link_ptr,
-                                        Eigen::VectorXf *b,
-                                        Eigen::MatrixXf *a) const;
+                                        Eigen::VectorXf *b, Eigen::MatrixXf *a);
   void AddResidualsAndConstraintJacobians(Eigen::VectorXf *b,
-                                          Eigen::MatrixXf *a) const;
+                                          Eigen::MatrixXf *a);
+  void SubtractConstraintJacobian(
+      int first_row, const Eigen::MatrixXf &link_constraint_jacobian,
+      const std::shared_ptr<Link> &link_ptr, Eigen::MatrixXf *a);
+  void SolveDenseSystem(Eigen::VectorXf *theta);
+
+  // Helper methods for single link with six degrees of freedom
+  bool SolveSingleLinkSystem(Eigen::VectorXf *theta);
+  void AssembleSingleLinkSystem(Eigen::Matrix<float, 6, 6> *a,
+                                Eigen::Matrix<float, 6, 1> *b) const;
+
+  // Helper methods for Levenberg-Marquardt
+  bool EvaluateStep(int corr_iteration, int opt_iteration);
+  void PredictIncrease(const Eigen::VectorXf &theta);
+  void PredictIncrease(const std::shared_ptr<Link> &link_ptr,
+                       const Eigen::VectorXf &theta, int *link_idx);
+  float GradientIncrease() const;
+  float GradientIncrease(const std::shared_ptr<Link> &link_ptr,
+                         int *link_idx) const;
+  bool RevertPoses(const Eigen::VectorXf &theta);
+  static bool RevertPoses(const std::shared_ptr<Link> &link_ptr,
+                          const std::shared_ptr<Link> &parent_link_ptr,
+                          const Eigen::VectorXf &theta);
+
+  // Helper methods for tree solver
+  void SolveTreeSystem(Eigen::VectorXf *theta);
+  void FactorizeTree();
+  void SetTreeGradients();
+  void AddTreeConstraintForce(int constraint_idx, int row, float force);
+  void SolveTree(Eigen::VectorXf *theta);
+  void CalculateConstraintVariations(Eigen::VectorXf *variations) const;
   bool UpdatePoses(const Eigen::VectorXf &theta);
   static bool UpdatePoses(const std::shared_ptr<Link> &link_ptr,
                           const std::shared_ptr<Link> &parent_link_ptr,
@@ -125,6 +285,36 @@ class Optimizer {
   // Internal data
   int degrees_of_freedom_{};
   Eigen::VectorXf tikhonov_vector_{};
+  Eigen::VectorXf damping_vector_{};
+  Eigen::VectorXf convergence_vector_{};
+  std::vector<TreeLinkData> tree_link_data_{};
+  std::vector<TreeConstraintData> tree_constraint_data_{};
+  bool single_link_ = false;
+
+  // Data of the last step that is evaluated by Levenberg-Marquardt
+  std::vector<Eigen::Matrix<float, 6, 1>> link_variations_{};
+  float predicted_increase_ = 0.0f;
+  float gradient_increase_ = 0.0f;
+  float damping_factor_ = 1.0f;
+  bool step_pending_ = false;
+  bool converged_ = false;
+
+  // Motion model of the root link
+  MotionModel motion_model_{};
+
+  // Workspaces that are reused in every iteration
+  Eigen::VectorXf theta_{};
+  Eigen::VectorXf b_{};
+  Eigen::MatrixXf a_{};
+  Eigen::LDLT<Eigen::MatrixXf, Eigen::Lower> ldlt_{};
+  Eigen::Matrix<float, 6, Eigen::Dynamic> hessian_jacobian_{};
+  Eigen::MatrixXf constraint_jacobian_{};
+  Eigen::VectorXf residual_{};
+  Eigen::VectorXf constraint_variations_{};
+  Eigen::VectorXf column_variations_{};
+  Eigen::MatrixXf schur_complement_{};
+  Eigen::LDLT<Eigen::MatrixXf> schur_complement_ldlt_{};
+  Eigen::VectorXf lambda_{};
 
   // Data
   std::string name_{};
@@ -134,6 +324,18 @@ class Optimizer {
   std::vector<std::shared_ptr<SoftConstraint>> soft_constraint_ptrs_{};
   float tikhonov_parameter_rotation_ = 1000.0f;
   float tikhonov_parameter_translation_ = 30000.0f;
+  bool use_tree_solver_ = true;
+  bool use_levenberg_marquardt_ = false;
+  float step_acceptance_ratio_ = 0.1f;
+  float damping_adaption_factor_ = 3.0f;
+  float min_damping_factor_ = 0.1f;
+  float max_damping_factor_ = 1000.0f;
+  float convergence_threshold_rotation_ = 1.0e-4f;
+  float convergence_threshold_translation_ = 1.0e-5f;
+  bool use_motion_model_ = false;
+  bool use_kalman_filter_ = false;
+  float kalman_process_noise_ = 10.0f;
+  float kalman_measurement_noise_ = 1.0f;
   bool set_up_ = false;
 };
 
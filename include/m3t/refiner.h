@@ -10,6 +10,8 @@
 #include <m3t/modality.h>
 #include <m3t/optimizer.h>
 
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -26,6 +28,18 @@ namespace m3t {
  * Model, \ref Renderer, \ref RendererGeometry, and \ref Body objects are
  * derived from \ref Optimizer objects.
  *
+ * Using `RefinePoseHypotheses()`, multiple hypotheses for the pose of the
+ * root link of each \ref Optimizer are refined. Hypotheses with the same
+ * index are refined together. Optimizers without hypotheses are refined only
+ * once and keep their best pose while remaining hypotheses of other
+ * optimizers are refined. After each refinement, correspondences are
+ * established for the final poses and `CalculateScores()` sums the scores of
+ * all \ref Modality objects that are referenced by an optimizer. For each
+ * optimizer, the poses with the highest score are kept. Hypotheses are
+ * refined one after another. Each \ref Body, \ref Modality, and \ref
+ * Renderer holds the state of a single pose, which would have to be
+ * duplicated for every hypothesis to refine them in parallel.
+ *
  * @param optimizer_ptrs referenced \ref Optimizer objects that are
  * considered in the refinement.
  * @param n_corr_iterations number of times new correspondences are established.
@@ -35,6 +49,14 @@ namespace m3t {
  * corresponds to infinite time.
  */
 class Refiner {
+ private:
+  // Root link pose and joint poses of all links of an optimizer
+  struct OptimizerPoses {
+    Transform3fA link2world_pose{Transform3fA::Identity()};
+    std::vector<Transform3fA> body2joint_poses{};
+    std::vector<Transform3fA> joint2parent_poses{};
+  };
+
  public:
   // Constructor and setup method
   Refiner(const std::string &name, int n_corr_iterations = 7,
@@ -54,8 +76,12 @@ class Refiner {
   void set_n_update_iterations(int n_update_iterations);
   void set_visualization_time(int visualization_time);
 
-  // Main method
+  // Main methods
   bool RefinePoses(const std::set<std::string> &names);
+  bool RefinePoseHypotheses(
+      const std::set<std::string> &names,
+      const std::map<std::string, std::vector<Transform3fA>>
+          &link2world_pose_hypotheses);
 
   // Methods of for advanced use
   bool ExecuteRefinementStep();
@@ -68,6 +94,7 @@ class Refiner {
   bool CalculateGradientAndHessian(int corr_iteration, int opt_iteration);
   bool CalculateOptimization(int corr_iteration, int opt_iteration);
   bool VisualizeOptimization(int save_idx);
+  bool CalculateScores();
 
   // Getters
   const std::string &name() const;
@@ -89,6 +116,7 @@ class Refiner {
   int n_corr_iterations() const;
   int n_update_iterations() const;
   int visualization_time() const;
+  const std::map<std::string, float> &scores() const;
   bool set_up() const;
 
  private:
@@ -98,6 +126,10 @@ class Refiner {
   void AssembleDerivedObjectPtrs();
   bool SetUpAllObjects();
   bool AreAllObjectsSetUp();
+  static void SavePoses(const std::shared_ptr<Optimizer> &optimizer_ptr,
+                        OptimizerPoses *poses);
+  static bool RestorePoses(const OptimizerPoses &poses,
+                           const std::shared_ptr<Optimizer> &optimizer_ptr);
 
   // Objects
   std::vector<std::shared_ptr<Optimizer>> optimizer_ptrs_{};
@@ -118,6 +150,9 @@ class Refiner {
   std::vector<std::shared_ptr<Renderer>> used_correspondence_renderer_ptrs_{};
   std::vector<std::shared_ptr<ColorHistograms>> used_color_histograms_ptrs_{};
 
+  // Scores of used optimizers
+  std::map<std::string, float> scores_{};
+
   // Parameters
   std::string name_{};
   std::filesystem::path metafile_path_{};
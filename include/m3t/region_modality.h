@@ -254,6 +254,7 @@ class RegionModality : public Modality {
   bool VisualizeOptimization(int save_idx) override;
   bool CalculateResults(int iteration) override;
   bool VisualizeResults(int save_idx) override;
+  bool CalculateScore(float *score) override;
 
   // Getters data
   const std::shared_ptr<ColorCamera> &color_camera_ptr() const;
@@ -398,6 +399,7 @@ class RegionModality : public Modality {
 
   // Internal data objects
   std::vector<DataLine> data_lines_;
+  int n_considered_lines_ = 0;
 
   // Pointers to referenced objects
   std::shared_ptr<ColorCamera> color_camera_ptr_ = nullptr;
@@ -491,7 +493,6 @@ class RegionModality : public Modality {
 
   // Precalculated variables for renderer (referenced data)
   int depth_image_size_minus_1_{};
-  float fsilhouette_image_size_{};
 
   // Precalculated variables for poses (continuously changing)
   Transform3fA body2camera_pose_;
@@ -163,6 +163,7 @@ class RegionModel : public Model {
 
   // Getter
   float max_contour_length() const;
+  const std::vector<View> &views() const;
   const std::vector<std::shared_ptr<Body>> &associated_body_ptrs() const;
   const std::vector<std::shared_ptr<Body>> &fixed_body_ptrs() const;
   const std::vector<std::shared_ptr<Body>> &movable_body_ptrs() const;
@@ -10,6 +10,8 @@
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <opencv2/opencv.hpp>
@@ -18,6 +20,8 @@
 
 namespace m3t {
 
+class FocusedRendererAtlas;
+
 // General functions to create shader programs
 bool CreateShaderProgram(RendererGeometry *renderer_geometry,
                          const char *vertex_shader_code,
@@ -28,6 +32,72 @@ bool CreateShaderProgram(RendererGeometry *renderer_geometry,
                          unsigned *shader_program);
 bool CheckCompileErrors(unsigned shader, const std::string &type);
 
+// General function to set uniforms ZMin and ZMax of shaders that write linear
+// depth values, using the near and far planes of the projection matrix
+void SetLinearDepthUniforms(unsigned shader_program,
+                            const Eigen::Matrix4f &projection_matrix);
+
+// General function to select the coarsest level of detail of a body for which
+// the geometric error projected into the image is below a maximum pixel error
+int SelectLODLevel(const Body &body, const Transform3fA &world2camera_pose,
+                   float focal_length, float max_pixel_error);
+
+// Maximum number of bodies that are drawn with a single instanced draw call
+constexpr int kMaxNInstances = 16;
+
+// Bodies that share vertex objects, level of detail, and culling and are
+// drawn with a single instanced draw call
+struct InstanceGroup {
+  const RendererGeometry::RenderDataBody *render_data_body_ptr = nullptr;
+  int lod_level = 0;
+  bool enable_culling = false;
+  std::vector<const Body *> body_ptrs{};
+};
+
+// General function to group bodies with shared vertex objects into instance
+// groups with at most kMaxNInstances bodies
+void AssignInstanceGroups(
+    const std::vector<RendererGeometry::RenderDataBody> &render_data_bodies,
+    const Transform3fA &world2camera_pose, float focal_length,
+    float max_pixel_error, std::vector<InstanceGroup> *instance_groups);
+
+// General function to set all pixels outside of a region to a value
+void FillOutsideRegion(const cv::Rect &region, const cv::Scalar &value,
+                       cv::Mat *image);
+
+/**
+ * \brief Class that reads images from the currently bound framebuffer
+ * asynchronously using a pixel buffer object.
+ *
+ * \details `StartReadback()` issues `glReadPixels()` into the pixel buffer
+ * object and inserts a fence without waiting for the GPU. `Fetch()` waits for
+ * the fence, maps the buffer, and copies the data into the provided image. If
+ * a region is provided, only this region is read back and copied. All methods
+ * have to be called with a current OpenGL context.
+ */
+class PixelBufferReader {
+ public:
+  // Constructor and setup methods
+  PixelBufferReader() = default;
+  PixelBufferReader(const PixelBufferReader &) = delete;
+  PixelBufferReader &operator=(const PixelBufferReader &) = delete;
+  void Create(int image_width, int image_height, int pixel_size);
+  void Delete();
+
+  // Main methods
+  void StartReadback(unsigned format, unsigned type);
+  void StartReadback(unsigned format, unsigned type, const cv::Rect &region);
+  bool Fetch(cv::Mat *image);
+
+ private:
+  unsigned pbo_ = 0;
+  void *sync_ = nullptr;
+  int image_width_ = 0;
+  int image_height_ = 0;
+  int pixel_size_ = 0;
+  cv::Rect region_{};
+};
+
 /**
  * \brief Abstract class that defines a renderer as a single camera at a defined
  * location.
@@ -48,6 +118,19 @@ bool CheckCompileErrors(unsigned shader, const std::string &type);
  * `intrinsics` parameters from the camera to the renderer.
  * @param z_min minimum z-distance that is rendered.
  * @param z_max maximum z-distance that is rendered.
+ * @param use_pixel_buffer_readback if true, images are read back
+ * asynchronously into pixel buffer objects during `StartRendering()` and only
+ * mapped when images are fetched.
+ * @param context_id context of \ref RendererGeometry that is used for
+ * rendering. Renderers that are used concurrently from different threads should
+ * use different contexts.
+ * @param use_linear_depth if true, depth images store values that are linear
+ * in the z-distance between `z_min` and `z_max` instead of the non-linear
+ * OpenGL depth. This results in a constant depth resolution over the entire
+ * range and depth values that are computed without a division.
+ * @param lod_max_pixel_error maximum projected geometric error in pixels that
+ * is accepted when levels of detail of bodies are selected. Levels of detail
+ * are only used if bodies provide them.
  */
 class Renderer {
  public:
@@ -65,6 +148,10 @@ class Renderer {
   void set_intrinsics(const Intrinsics &intrinsics);
   void set_z_min(float z_min);
   void set_z_max(float z_max);
+  void set_use_pixel_buffer_readback(bool use_pixel_buffer_readback);
+  void set_context_id(int context_id);
+  void set_use_linear_depth(bool use_linear_depth);
+  void set_lod_max_pixel_error(float lod_max_pixel_error);
 
   // Main methods
   virtual bool StartRendering() = 0;
@@ -79,6 +166,10 @@ class Renderer {
   const Intrinsics &intrinsics() const;
   float z_min() const;
   float z_max() const;
+  bool use_pixel_buffer_readback() const;
+  int context_id() const;
+  bool use_linear_depth() const;
+  float lod_max_pixel_error() const;
   bool set_up() const;
 
   // Getters optional data
@@ -111,6 +202,10 @@ class Renderer {
   Intrinsics intrinsics_{};
   float z_min_ = 0.02f;  // min and max z-distance considered in clip space
   float z_max_ = 10.0f;
+  bool use_pixel_buffer_readback_ = false;
+  int context_id_ = 0;
+  bool use_linear_depth_ = false;
+  float lod_max_pixel_error_ = 1.0f;
 
   // State variables
   std::mutex mutex_{};
@@ -163,11 +258,33 @@ class FullRenderer : public Renderer {
  * relative scale of the image is provided by `scale`. The visibility of bodies
  * in the rendered image can be checked using `IsBodyVisible()`.
  *
+ * If `render_cache_threshold` is larger than zero, `StartRendering()` skips
+ * rendering if neither the camera nor any body of the \ref RendererGeometry
+ * moved by more than the threshold since the last rendering. Movement is
+ * measured as a conservative estimate of the projected displacement of the
+ * bounding sphere of each body in pixels of the focused image. In this case,
+ * previously rendered images and the corresponding projection are kept.
+ * Renderers that use a \ref FocusedRendererAtlas do not use the cache.
+ *
+ * If `use_region_readback` is true, the tight bounding box of the projected
+ * bounding spheres of visible referenced bodies is calculated together with
+ * the projection. Renderers that support it restrict drawing to this region
+ * using scissoring and only read back the region, while all other pixels are
+ * set to the cleared value. The region is provided by `valid_region()` and can
+ * be used by modalities to skip cleared areas. Note that bodies that are not
+ * referenced are only rendered inside the region.
+ *
  * @param image_size image size that is rendered.
  * @param referenced_body_ptrs referenced \ref Body objects on which the scene
  * is focused.
+ * @param render_cache_threshold maximum projected displacement in pixels for
+ * which rendering is skipped. A value of zero disables caching.
+ * @param use_region_readback if true, only the region that contains
+ * referenced bodies is rendered and read back.
  */
 class FocusedRenderer : public Renderer {
+  friend class FocusedRendererAtlas;
+
  private:
   static constexpr float kImageSizeSafetyMargin = 1.05f;
 
@@ -182,6 +299,8 @@ class FocusedRenderer : public Renderer {
 
   // Setters
   void set_image_size(int image_size);
+  void set_render_cache_threshold(float render_cache_threshold);
+  void set_use_region_readback(bool use_region_readback);
 
   // Main methods
   virtual bool StartRendering() override = 0;
@@ -192,9 +311,12 @@ class FocusedRenderer : public Renderer {
   const std::vector<std::shared_ptr<Body>> &referenced_body_ptrs()
       const override;
   int image_size() const;
+  float render_cache_threshold() const;
+  bool use_region_readback() const;
   float corner_u() const;
   float corner_v() const;
   float scale() const;
+  const cv::Rect &valid_region() const;
 
  protected:
   // Constructors
@@ -215,15 +337,25 @@ class FocusedRenderer : public Renderer {
 
   // Helper Methods
   void CalculateProjectionMatrix();
+  bool IsRenderCacheValid() const;
+  void UpdateRenderCache();
 
   // Data
   std::vector<std::shared_ptr<Body>> referenced_body_ptrs_{};
   std::vector<std::string> visible_body_names_{};
   int image_size_ = 200;
+  float render_cache_threshold_ = 0.0f;
+  bool use_region_readback_ = false;
   float corner_u_{};
   float corner_v_{};
   float scale_{};
+  cv::Rect valid_region_{};
   Eigen::Matrix4f projection_matrix_{};
+
+  // Render cache
+  Transform3fA cached_world2camera_pose_{};
+  std::vector<Transform3fA> cached_body2world_poses_{};
+  bool render_cache_valid_ = false;
 };
 
 /**
@@ -280,12 +412,21 @@ class FullDepthRenderer : public FullRenderer {
  * \brief Abstract \ref Renderer class that defines a focused depth renderer
  * that extends the \ref FocusedRenderer class with functionality specific to
  * depth renderings.
+ *
+ * \details Using `UseAtlas()`, the renderer can be configured to render into a
+ * tile of a \ref FocusedRendererAtlas instead of a separate framebuffer.
+ * Focused images are then copied from the tile of the renderer.
  */
 class FocusedDepthRenderer : public FocusedRenderer {
  public:
-  // Setup methods
+  // Destructor and setup methods
+  ~FocusedDepthRenderer();
   virtual bool SetUp() override = 0;
 
+  // Configure atlas
+  void UseAtlas(const std::shared_ptr<FocusedRendererAtlas> &atlas_ptr);
+  void DoNotUseAtlas();
+
   // Main methods
   virtual bool StartRendering() override = 0;
   virtual bool FetchDepthImage() = 0;
@@ -293,6 +434,8 @@ class FocusedDepthRenderer : public FocusedRenderer {
 
   // Getters
   const cv::Mat &focused_depth_image() const;
+  const std::shared_ptr<FocusedRendererAtlas> &atlas_ptr() const;
+  bool use_atlas() const;
 
   // Getters that calculate values based on the rendered depth image for the
   // original image coordinates
@@ -322,10 +465,14 @@ class FocusedDepthRenderer : public FocusedRenderer {
   void CalculateProjectionTerms();
   void ClearDepthImage();
 
+  bool SetUpAtlas(IDType id_type);
+
   // Data
   cv::Mat focused_depth_image_{};
   float projection_term_a_ = 0;
   float projection_term_b_ = 0;
+  std::shared_ptr<FocusedRendererAtlas> atlas_ptr_ = nullptr;
+  bool use_atlas_ = false;
 };
 
 }  // namespace m3t
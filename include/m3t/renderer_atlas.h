@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_RENDERER_ATLAS_H_
+#define M3T_INCLUDE_M3T_RENDERER_ATLAS_H_
+
+#include <m3t/body.h>
+#include <m3t/common.h>
+#include <m3t/renderer.h>
+#include <m3t/renderer_geometry.h>
+#include <m3t/silhouette_renderer.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+namespace m3t {
+
+/**
+ * \brief Class that renders the views of multiple \ref FocusedDepthRenderer
+ * objects into tiles of a single framebuffer.
+ *
+ * \details Renderers are assigned using `FocusedDepthRenderer::UseAtlas()` and
+ * register themselves during their setup. Tiles are packed into rows of an
+ * atlas with a maximum width of `max_width`. If `StartRendering()` is called
+ * by a renderer and the tile of the renderer is outdated because poses of
+ * bodies or the projection changed, all tiles are rendered in a single pass
+ * with per-tile viewports, projection matrices, and ID types. Images are read
+ * back once for the entire atlas, and focused images of renderers are copied
+ * from their tile. Both a silhouette and a depth image are rendered. Other
+ * renderers are rendered with the projection they used for their last
+ * rendering, which is only read while their mutex can be acquired. Their
+ * projection and previously fetched images remain unchanged.
+ *
+ * @param renderer_geometry_ptr referenced \ref RendererGeometry object that is
+ * shared with all renderers of the atlas.
+ * @param max_width maximum width of the atlas image in pixels.
+ */
+class FocusedRendererAtlas {
+ private:
+  // Tile of a renderer
+  struct Tile {
+    FocusedDepthRenderer *renderer_ptr = nullptr;
+    IDType id_type = IDType::BODY;
+    cv::Rect rect{};
+    Eigen::Matrix4f projection_matrix{Eigen::Matrix4f::Zero()};
+    Transform3fA world2camera_pose{Transform3fA::Identity()};
+  };
+
+ public:
+  // Constructor and setup method
+  FocusedRendererAtlas(
+      const std::string &name,
+      const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+      int max_width = 2048);
+  bool SetUp();
+
+  // Setters
+  void set_name(const std::string &name);
+  void set_renderer_geometry_ptr(
+      const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr);
+  void set_max_width(int max_width);
+
+  // Configure renderers
+  bool AddRenderer(FocusedDepthRenderer *renderer_ptr, IDType id_type);
+  bool DeleteRenderer(const FocusedDepthRenderer *renderer_ptr);
+
+  // Main methods
+  bool StartRendering(const FocusedDepthRenderer *renderer_ptr);
+  bool FetchSilhouetteImage(const FocusedDepthRenderer *renderer_ptr,
+                            cv::Mat *focused_silhouette_image);
+  bool FetchDepthImage(const FocusedDepthRenderer *renderer_ptr,
+                       cv::Mat *focused_depth_image);
+
+  // Getters
+  const std::string &name() const;
+  const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr() const;
+  int max_width() const;
+  int n_tiles() const;
+  const cv::Mat &silhouette_image() const;
+  const cv::Mat &depth_image() const;
+  bool set_up() const;
+
+ private:
+  // Helper methods
+  Tile *FindTile(const FocusedDepthRenderer *renderer_ptr);
+  bool UpdateLayout();
+  bool IsTileOutdated(const Tile &tile) const;
+  void RenderTiles(const FocusedDepthRenderer *renderer_ptr);
+
+  // Internal data objects
+  std::vector<Tile> tiles_{};
+  std::vector<SilhouetteRendererCore::Tile> core_tiles_{};
+  std::vector<Transform3fA> rendered_body2world_poses_{};
+  cv::Mat silhouette_image_{};
+  cv::Mat depth_image_{};
+  SilhouetteRendererCore core_{};
+
+  // Pointers to referenced objects
+  std::shared_ptr<RendererGeometry> renderer_geometry_ptr_ = nullptr;
+
+  // Parameters
+  std::string name_{};
+  int max_width_ = 2048;
+
+  // State variables
+  std::mutex mutex_{};
+  bool layout_changed_ = true;
+  bool rendered_ = false;
+  bool set_up_ = false;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_RENDERER_ATLAS_H_
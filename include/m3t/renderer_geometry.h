@@ -8,10 +8,15 @@
 #include <GLFW/glfw3.h>
 #include <m3t/body.h>
 #include <m3t/common.h>
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 #include <filesystem/filesystem.h>
 #include <Eigen/Dense>
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -20,6 +25,12 @@
 
 namespace m3t {
 
+/**
+ * \brief Backend that is used by \ref RendererGeometry to create OpenGL
+ * contexts. GLFW = 0, EGL = 1.
+ */
+enum class ContextBackend { GLFW = 0, EGL = 1 };
+
 /**
  * \brief Loads geometric information from referenced \ref Body objects in
  * *Vertex Array Objects (VAOs)* and *Vertex Buffers Objects (VBOs)* and
@@ -33,15 +44,59 @@ namespace m3t {
  * *GLFW* thread-safety requirements. Calling the `SetUp()` method initializes
  * *GLFW*, creates a *GLFW* context, and creates *VAOs* and *VBOs*. \ref Body
  * objects can be added and deleted without requiring a new call of `SetUp()`.
- * Setters and all main methods are thread-safe.
+ * To iterate over bodies while others might be added or deleted concurrently,
+ * a copy of `body_ptrs` is obtained with `CopyBodyPtrs()`.
+ * Setters and all main methods are thread-safe. Levels of detail of bodies
+ * are appended to the same *VBO* and can be drawn using the vertex ranges
+ * `first_vertex()` and `vertex_count()` of `RenderDataBody`. Bodies with the
+ * same geometry path, unit, winding order, and level of detail parameters
+ * share *VBOs* and *VAOs*, which are only deleted together with the last body
+ * that uses them. Renderers can draw such bodies with a single instanced call.
+ *
+ * To render concurrently, multiple contexts that share *VBOs* and shader
+ * programs can be created. Each context is guarded by its own mutex and has its
+ * own *VAOs*, which are accessed using `RenderDataBody::context_vao()`.
+ * Renderers that use different contexts can therefore render and read back
+ * images from different threads at the same time. Calling `SetUp()` again
+ * keeps existing contexts and only adds or removes shared contexts if
+ * `n_contexts` changed. If the backend is changed, all contexts are recreated
+ * and renderers have to be set up again.
+ *
+ * Instead of hidden *GLFW* windows, which require a display, contexts can be
+ * created off-screen with *EGL* if the library is compiled with `USE_EGL`.
+ * *EGL* displays are obtained from GPU devices or, if no device is available,
+ * from the surfaceless Mesa platform, which falls back to the llvmpipe software
+ * renderer on CPU-only machines. With *EGL*, `SetUp()` and the destructor are
+ * not restricted to the main thread.
  *
  * @param body_ptrs referenced \ref Body objects that are considered in the
  * renderer geometry.
+ * @param n_contexts number of *GLFW* contexts that share objects and can be
+ * used concurrently.
+ * @param backend backend that is used to create contexts. It has to be set
+ * before renderers are set up.
  */
 class RendererGeometry {
  private:
   // Count the number of instances to manage the GLFW library
   static int n_instances_;
+#ifdef USE_EGL
+  // Count the number of instances to manage the EGL display
+  static int n_egl_instances_;
+  static EGLDisplay egl_display_;
+  static EGLConfig egl_config_;
+  static bool egl_pbuffer_supported_;
+  static std::mutex egl_mutex_;
+#endif
+
+  // Handle of OpenGL context
+  struct Context {
+    GLFWwindow *window = nullptr;  // Only used to hold a glfw context
+#ifdef USE_EGL
+    EGLContext egl_context = EGL_NO_CONTEXT;
+    EGLSurface egl_surface = EGL_NO_SURFACE;
+#endif
+  };
 
  public:
   // Data Structs
@@ -50,43 +105,87 @@ class RendererGeometry {
     GLuint vao = 0;
     GLuint vbo = 0;
     unsigned n_vertices = 0;
+    std::vector<GLuint> shared_vaos{};  // vaos of contexts 1 to n_contexts - 1
+    std::vector<unsigned> lod_first_vertices{};  // levels 1 to n_lod_levels
+    std::vector<unsigned> lod_n_vertices{};
+    GLuint context_vao(int context_id) const {
+      return context_id == 0 ? vao : shared_vaos[context_id - 1];
+    }
+    unsigned first_vertex(int lod_level) const {
+      return lod_level == 0 ? 0 : lod_first_vertices[lod_level - 1];
+    }
+    unsigned vertex_count(int lod_level) const {
+      return lod_level == 0 ? n_vertices : lod_n_vertices[lod_level - 1];
+    }
   };
 
   // Constructor, destructor, and setup method
-  RendererGeometry(const std::string &name);
+  RendererGeometry(const std::string &name, int n_contexts = 1,
+                   ContextBackend backend = ContextBackend::GLFW);
   RendererGeometry(const RendererGeometry &) = delete;
   RendererGeometry &operator=(const RendererGeometry &) = delete;
-  ~RendererGeometry();  // deletes glfw context
-  bool SetUp();         // creates glfw context
+  ~RendererGeometry();  // deletes contexts
+  bool SetUp();         // creates contexts
+
+  // Setters
+  void set_n_contexts(int n_contexts);
+  void set_backend(ContextBackend backend);
 
   // Configure bodies
   bool AddBody(const std::shared_ptr<Body> &body_ptr);
   bool DeleteBody(const std::string &name);
   void ClearBodies();
+  std::vector<std::shared_ptr<Body>> CopyBodyPtrs();
 
-  // Handling of GLFW context
-  bool MakeContextCurrent();
-  bool DetachContext();
+  // Handling of contexts
+  bool MakeContextCurrent(int context_id = 0);
+  bool DetachContext(int context_id = 0);
 
   // Getters
   const std::string &name() const;
+  int n_contexts() const;
+  ContextBackend backend() const;
   const std::vector<std::shared_ptr<Body>> &body_ptrs() const;
   const std::vector<RenderDataBody> &render_data_bodies() const;
   bool set_up() const;
 
  private:
   // Helper methods
+  void SetUpGLVertexObjects(RenderDataBody *render_data_body);
+  bool ShareGLVertexObjects(RenderDataBody *render_data_body) const;
+  static bool HasEqualGeometry(const Body &body_1, const Body &body_2);
   static void AssembleVertexData(const Body &body,
-                                 std::vector<float> *vertex_data);
-  static void CreateGLVertexObjects(const std::vector<float> &vertices,
-                                    RenderDataBody *render_data_body);
-  static void DeleteGLVertexObjects(RenderDataBody *render_data_body);
+                                 std::vector<float> *vertex_data,
+                                 RenderDataBody *render_data_body);
+  static void AppendVertexData(
+      const std::vector<Eigen::Vector3f> &vertices,
+      const std::vector<std::array<int, 3>> &mesh_indices,
+      std::vector<float> *vertex_data);
+  void CreateGLVertexObjects(const std::vector<float> &vertices,
+                             RenderDataBody *render_data_body);
+  void DeleteGLVertexObjects(RenderDataBody *render_data_body);
+  static void CreateGLVertexArray(GLuint vbo, GLuint *vao);
+  bool InitializeBackend();
+  void TerminateBackend();
+  bool CreateContext(const Context *share_context, Context *context) const;
+  void DestroyContext(Context *context) const;
+  void ActivateContext(const Context *context) const;
+  bool CreateSharedContexts();
+  void DestroySharedContexts(int n_remaining_contexts);
+  std::vector<std::unique_lock<std::mutex>> LockAllContexts();
+#ifdef USE_EGL
+  static bool InitializeEGLDisplay();
+#endif
 
   // Variables
   std::string name_{};
+  int n_contexts_ = 1;
+  ContextBackend backend_ = ContextBackend::GLFW;
+  ContextBackend initialized_backend_ = ContextBackend::GLFW;
   std::vector<std::shared_ptr<Body>> body_ptrs_;
   std::vector<RenderDataBody> render_data_bodies_;
-  GLFWwindow *window_ = nullptr;  // Only used to hold a glfw context
+  std::vector<Context> contexts_{};  // primary context followed by shared ones
+  std::vector<std::unique_ptr<std::mutex>> context_mutexes_{};
   std::mutex mutex_;
   bool initial_set_up_ = false;
   bool set_up_ = false;
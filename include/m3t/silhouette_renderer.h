@@ -9,9 +9,11 @@
 #include <m3t/common.h>
 #include <m3t/renderer.h>
 #include <m3t/renderer_geometry.h>
+#include <m3t/software_renderer.h>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -25,25 +27,50 @@ namespace m3t {
  * \brief Class that implements the main functionality for a silhouette renderer
  * and is used by \ref FullSilhouetteRenderer and \ref
  * FocusedSilhouetteRenderer.
+ *
+ * \details Using tiles, multiple views with separate viewports, projection
+ * matrices, poses, and ID types can be rendered in a single pass. If a region
+ * is provided, drawing is restricted to this region using scissoring, only
+ * the region is read back, and all other pixels are set to cleared values.
+ * If `use_linear_depth` is true, a second shader program writes depth values
+ * that are linear between the near and far plane of the projection matrix to
+ * a second color attachment from which depth images are read.
+ * Bodies that share vertex objects are drawn with instanced draw calls that
+ * take poses and silhouette IDs from uniform arrays.
  */
 class SilhouetteRendererCore {
  public:
+  // Data Structs
+  struct Tile {
+    cv::Rect viewport;
+    Eigen::Matrix4f projection_matrix;
+    Transform3fA world2camera_pose;
+    IDType id_type;
+  };
+
   // Destructor and setup method
   SilhouetteRendererCore() = default;
   SilhouetteRendererCore(const SilhouetteRendererCore &) = delete;
   SilhouetteRendererCore &operator=(const SilhouetteRendererCore &) = delete;
   ~SilhouetteRendererCore();
   bool SetUp(const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-             int image_width, int image_height);
+             int image_width, int image_height,
+             bool use_pixel_buffer_readback = false, int context_id = 0,
+             bool use_linear_depth = false, float lod_max_pixel_error = 0.0f);
 
   // Main methods
   bool StartRendering(const Eigen::Matrix4f &projection_matrix,
                       const Transform3fA &world2camera_pose, IDType id_type);
+  bool StartRendering(const Eigen::Matrix4f &projection_matrix,
+                      const Transform3fA &world2camera_pose, IDType id_type,
+                      const cv::Rect &region);
+  bool StartRendering(const std::vector<Tile> &tiles);
   bool FetchSilhouetteImage(cv::Mat *silhouette_image);
   bool FetchDepthImage(cv::Mat *depth_image);
 
  private:
   // Helper methods
+  bool RenderTiles(const Tile *tiles, size_t n_tiles, const cv::Rect &region);
   void CreateBufferObjects();
   void DeleteBufferObjects();
 
@@ -51,16 +78,29 @@ class SilhouetteRendererCore {
   std::shared_ptr<RendererGeometry> renderer_geometry_ptr_;
   int image_width_;
   int image_height_;
+  bool use_pixel_buffer_readback_ = false;
+  int context_id_ = 0;
+  bool use_linear_depth_ = false;
+  float lod_max_pixel_error_ = 0.0f;
+  cv::Rect region_{};
+  std::vector<InstanceGroup> instance_groups_{};
+  std::array<Eigen::Matrix4f, kMaxNInstances> transs_{};
+  std::array<float, kMaxNInstances> silhouette_ids_{};
 
   // Shader code
   static std::string vertex_shader_code_;
   static std::string fragment_shader_code_;
+  static std::string linear_fragment_shader_code_;
 
   // OpenGL variables
   unsigned fbo_ = 0;
   unsigned rbo_silhouette_ = 0;
   unsigned rbo_depth_ = 0;
+  unsigned rbo_linear_depth_ = 0;
   unsigned shader_program_ = 0;
+  unsigned linear_shader_program_ = 0;
+  PixelBufferReader silhouette_reader_{};
+  PixelBufferReader depth_reader_{};
 
   // Internal state
   bool image_rendered_ = false;
@@ -142,6 +182,9 @@ class FullSilhouetteRenderer : public FullDepthRenderer {
  *
  * @param id_type type of ID from \ref Body object that is rendered. BODY = 0,
  * REGION = 1.
+ * @param use_software_rendering if true, images are rasterized on the CPU
+ * using \ref SoftwareRendererCore. No OpenGL context is used and the \ref
+ * RendererGeometry does not have to be set up.
  */
 class FocusedSilhouetteRenderer : public FocusedDepthRenderer {
  public:
@@ -165,6 +208,7 @@ class FocusedSilhouetteRenderer : public FocusedDepthRenderer {
 
   // Setters
   void set_id_type(IDType id_type);
+  void set_use_software_rendering(bool use_software_rendering);
 
   // Main methods
   bool StartRendering() override;
@@ -173,6 +217,7 @@ class FocusedSilhouetteRenderer : public FocusedDepthRenderer {
 
   // Getters
   IDType id_type() const;
+  bool use_software_rendering() const;
   const cv::Mat &focused_silhouette_image() const;
 
   // Getters that calculate values based on the rendered silhouette image
@@ -185,8 +230,10 @@ class FocusedSilhouetteRenderer : public FocusedDepthRenderer {
 
   // Data
   IDType id_type_{};
+  bool use_software_rendering_ = false;
   cv::Mat focused_silhouette_image_{};
   SilhouetteRendererCore core_{};
+  SoftwareRendererCore software_core_{};
 };
 
 }  // namespace m3t
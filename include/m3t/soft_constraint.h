@@ -6,6 +6,7 @@
 
 #include <m3t/body.h>
 #include <m3t/common.h>
+#include <m3t/lie_group.h>
 #include <m3t/link.h>
 
 #include <Eigen/Dense>
@@ -48,6 +49,13 @@ namespace m3t {
  * translational constraint in meter.
  */
 class SoftConstraint {
+ private:
+  // Vectors and matrices for up to three rotational or translational directions
+  using ConsideredVector = Eigen::Matrix<float, Eigen::Dynamic, 1, 0, 3, 1>;
+  using ConsideredMatrix =
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3>;
+  using ConsideredJacobian = Eigen::Matrix<float, Eigen::Dynamic, 6, 0, 3, 6>;
+
  public:
   // Constructors and setup methods
   SoftConstraint(
@@ -105,14 +113,14 @@ class SoftConstraint {
       const Transform3fA &joint22joint1_pose,
       const Transform3fA &body2joint1_pose, float sign,
       const std::shared_ptr<Link> &link_ptr) const;
-  Eigen::VectorXf ConsideredRotationVector(
+  ConsideredVector ConsideredRotationVector(
       const Transform3fA &joint22joint1_pose) const;
-  Eigen::VectorXf ConsideredTranslationVector(
+  ConsideredVector ConsideredTranslationVector(
       const Transform3fA &joint22joint1_pose) const;
-  Eigen::MatrixXf UnprojectedConstraintJacobianRotation(
+  ConsideredJacobian UnprojectedConstraintJacobianRotation(
       const Transform3fA &joint22joint1_pose,
       const Transform3fA &body2joint1_pose) const;
-  Eigen::MatrixXf UnprojectedConstraintJacobianTranslation(
+  ConsideredJacobian UnprojectedConstraintJacobianTranslation(
       const Transform3fA &joint22joint1_pose,
       const Transform3fA &body2joint1_pose) const;
 
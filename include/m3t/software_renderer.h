@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_SOFTWARE_RENDERER_H_
+#define M3T_INCLUDE_M3T_SOFTWARE_RENDERER_H_
+
+#include <m3t/body.h>
+#include <m3t/common.h>
+#include <m3t/renderer.h>
+#include <m3t/renderer_geometry.h>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace m3t {
+
+/**
+ * \brief Class that rasterizes silhouette and depth images of the bodies in a
+ * \ref RendererGeometry on the CPU and can be used by \ref
+ * FocusedSilhouetteRenderer and \ref FocusedBasicDepthRenderer instead of the
+ * OpenGL-based cores.
+ *
+ * \details Vertices and mesh indices are taken directly from the \ref Body
+ * objects, so neither an OpenGL context nor a set-up \ref RendererGeometry is
+ * required and rendering is possible from any thread. Triangles are clipped
+ * at the near plane, culled according to `geometry_enable_culling`, and
+ * rasterized in tiles of `kTileSize` x `kTileSize` pixels. Tiles that lie
+ * outside of a triangle are rejected and tiles that are fully covered skip
+ * edge tests. Pixel centers, depth values, and culled faces follow the OpenGL
+ * conventions of \ref SilhouetteRendererCore such that images are equivalent.
+ * If `use_linear_depth` is true, depth values are converted to be linear
+ * between the near and far plane when the depth image is fetched. Levels of
+ * detail of bodies are selected according to `lod_max_pixel_error`.
+ * The approach is intended for small focused images, where the rasterization
+ * itself is cheaper than the round trip to the GPU.
+ */
+class SoftwareRendererCore {
+ private:
+  static constexpr int kTileSize = 8;
+
+  // Edge function of a triangle in window coordinates
+  struct Edge {
+    float a;
+    float b;
+    float c;
+    bool top_left;
+  };
+
+ public:
+  // Setup method
+  bool SetUp(const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+             int image_width, int image_height, bool use_linear_depth = false,
+             float lod_max_pixel_error = 0.0f);
+
+  // Main methods
+  bool StartRendering(const Eigen::Matrix4f &projection_matrix,
+                      const Transform3fA &world2camera_pose, IDType id_type);
+  bool FetchSilhouetteImage(cv::Mat *silhouette_image);
+  bool FetchDepthImage(cv::Mat *depth_image);
+
+ private:
+  // Helper methods
+  void RasterizeBody(const Body &body, int lod_level,
+                     const Eigen::Matrix4f &trans, uchar id);
+  void ClipAndRasterizeTriangle(const std::array<Eigen::Vector4f, 3> &triangle,
+                                bool enable_culling, uchar id);
+  void RasterizeTriangle(const Eigen::Vector3f &vertex_a,
+                         const Eigen::Vector3f &vertex_b,
+                         const Eigen::Vector3f &vertex_c, bool enable_culling,
+                         uchar id);
+  void RasterizeTile(const std::array<Edge, 3> &edges,
+                     const Eigen::Vector3f &depth_plane, bool covered,
+                     int x_begin, int x_end, int y_begin, int y_end, uchar id);
+  static Edge CalculateEdge(const Eigen::Vector3f &vertex_1,
+                            const Eigen::Vector3f &vertex_2);
+  static bool CoversPixel(float edge_value, bool top_left);
+
+  // Internal data
+  std::shared_ptr<RendererGeometry> renderer_geometry_ptr_;
+  int image_width_ = 0;
+  int image_height_ = 0;
+  bool use_linear_depth_ = false;
+  float lod_max_pixel_error_ = 0.0f;
+  float z_min_ = 0.0f;
+  float z_max_ = 0.0f;
+  cv::Mat silhouette_buffer_{};
+  cv::Mat depth_buffer_{};
+  std::vector<Eigen::Vector4f> clip_vertices_{};
+
+  // Internal state
+  bool image_rendered_ = false;
+  bool initial_set_up_ = false;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_SOFTWARE_RENDERER_H_
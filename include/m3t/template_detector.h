@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#ifndef M3T_INCLUDE_M3T_TEMPLATE_DETECTOR_H_
+#define M3T_INCLUDE_M3T_TEMPLATE_DETECTOR_H_
+
+#include <m3t/camera.h>
+#include <m3t/common.h>
+#include <m3t/detector.h>
+#include <m3t/optimizer.h>
+#include <m3t/region_model.h>
+#include <omp.h>
+
+#include <filesystem/filesystem.h>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace m3t {
+
+/**
+ * \brief \ref Detector that matches gradient orientations of the color image
+ * to contour templates that are generated from views of a \ref RegionModel
+ * and that sets the pose of the root link of the referenced \ref Optimizer.
+ *
+ * \details In `SetUp()`, views are selected from the \ref RegionModel such
+ * that orientations differ by at least `min_view_angle`. For each selected
+ * view, `n_rolls` rotations around the viewing axis, and each value in
+ * `distances`, contour points and normals are projected to obtain a template
+ * with `n_features` quantized gradient orientations and image offsets
+ * relative to the body origin. In `DetectPoses()`, an image pyramid with
+ * `n_pyramid_levels` is computed. On each level, gradient orientations with a
+ * magnitude above `min_magnitude` are quantized, spread to a local
+ * neighborhood, and converted to response maps. Templates are matched
+ * exhaustively on the coarsest level in parallel. The best candidates are then
+ * refined in a small window on finer levels. Up to `n_hypotheses` poses are
+ * provided by `link2world_pose_hypotheses()`. If the best similarity exceeds
+ * `min_similarity`, the pose of the root link is updated. All hypotheses that
+ * exceed `min_similarity` are then provided by `AddPoseHypotheses()`, e.g. to
+ * be evaluated using \ref Refiner. The number of pyramid levels and rolls
+ * has to be at least one and at least one distance is required.
+ *
+ * @param optimizer_ptr referenced \ref Optimizer object for which referenced
+ * body and link poses are set. The body of the root link has to be the body of
+ * `region_model_ptr`.
+ * @param color_camera_ptr referenced \ref ColorCamera object that is used.
+ * @param region_model_ptr referenced \ref RegionModel that provides views.
+ * @param distances distances between camera and body origin in meter for which
+ * templates are generated.
+ * @param n_rolls number of rotations around the viewing axis for which
+ * templates are generated.
+ * @param min_view_angle minimum angle in radian between the orientations of
+ * views that are used for templates.
+ * @param n_features number of contour points that are used per template.
+ * @param n_pyramid_levels number of levels of the image pyramid.
+ * @param min_magnitude minimum magnitude of image gradients that are
+ * considered.
+ * @param min_similarity minimum similarity between 0 and 1 that is required to
+ * update poses.
+ * @param n_hypotheses maximum number of pose hypotheses that are provided.
+ */
+class TemplateDetector : public Detector {
+ private:
+  // Fixed parameters
+  static constexpr int kNOrientations = 8;
+  static constexpr int kMaxResponse = 4;
+  static constexpr int kSpreadRadius = 2;
+  static constexpr int kRefinementRadius = 2;
+  static constexpr int kNCandidatesPerHypothesis = 4;
+
+  /**
+   * \brief Struct that contains the image offset relative to the projected
+   * body origin and the quantized orientation of a contour point.
+   */
+  struct Feature {
+    int u;
+    int v;
+    int orientation;
+  };
+
+  /**
+   * \brief Struct that contains the features of a template for each pyramid
+   * level and the pose that was used to generate it.
+   */
+  struct Template {
+    std::vector<std::vector<Feature>> level_features;
+    Eigen::Matrix3f body2camera_rotation;
+    float distance;
+  };
+
+  /**
+   * \brief Struct that contains a match of a template at an image location
+   * of a specific pyramid level.
+   */
+  struct Match {
+    int template_idx;
+    int u;
+    int v;
+    float similarity;
+  };
+
+ public:
+  // Constructor and setup method
+  TemplateDetector(const std::string &name,
+                   const std::shared_ptr<Optimizer> &optimizer_ptr,
+                   const std::shared_ptr<ColorCamera> &color_camera_ptr,
+                   const std::shared_ptr<RegionModel> &region_model_ptr,
+                   bool reset_joint_poses = true);
+  TemplateDetector(const std::string &name,
+                   const std::filesystem::path &metafile_path,
+                   const std::shared_ptr<Optimizer> &optimizer_ptr,
+                   const std::shared_ptr<ColorCamera> &color_camera_ptr,
+                   const std::shared_ptr<RegionModel> &region_model_ptr);
+  bool SetUp() override;
+
+  // Setters
+  void set_optimizer_ptr(const std::shared_ptr<Optimizer> &optimizer_ptr);
+  void set_color_camera_ptr(
+      const std::shared_ptr<ColorCamera> &color_camera_ptr);
+  void set_region_model_ptr(
+      const std::shared_ptr<RegionModel> &region_model_ptr);
+  void set_distances(const std::vector<float> &distances);
+  void set_n_rolls(int n_rolls);
+  void set_min_view_angle(float min_view_angle);
+  void set_n_features(int n_features);
+  void set_n_pyramid_levels(int n_pyramid_levels);
+  void set_min_magnitude(float min_magnitude);
+  void set_min_similarity(float min_similarity);
+  void set_n_hypotheses(int n_hypotheses);
+
+  // Main methods
+  bool DetectPoses(const std::set<std::string> &names,
+                   std::set<std::string> *detected_names = nullptr) override;
+  void AddPoseHypotheses(const std::set<std::string> &names,
+                         std::map<std::string, std::vector<Transform3fA>>
+                             *link2world_pose_hypotheses) const override;
+
+  // Getters
+  const std::shared_ptr<Optimizer> &optimizer_ptr() const;
+  const std::shared_ptr<ColorCamera> &color_camera_ptr() const;
+  const std::shared_ptr<RegionModel> &region_model_ptr() const;
+  const std::vector<float> &distances() const;
+  int n_rolls() const;
+  float min_view_angle() const;
+  int n_features() const;
+  int n_pyramid_levels() const;
+  float min_magnitude() const;
+  float min_similarity() const;
+  int n_hypotheses() const;
+  int n_templates() const;
+  const std::vector<Transform3fA> &link2world_pose_hypotheses() const;
+  const std::vector<float> &similarities() const;
+  std::vector<std::shared_ptr<Optimizer>> optimizer_ptrs() const override;
+  std::shared_ptr<Camera> camera_ptr() const override;
+
+ private:
+  // Helper methods for set up
+  bool LoadMetaData();
+  void GenerateTemplates();
+  void SelectViews(std::vector<const RegionModel::View *> *view_ptrs) const;
+  void GenerateTemplate(const RegionModel::View &view,
+                        const Eigen::Matrix3f &body2camera_rotation,
+                        float distance, Template *templ) const;
+  void GenerateResponseLUTs();
+
+  // Helper methods for detection
+  void CalculateResponseMaps();
+  void QuantizeOrientations(const cv::Mat &image,
+                            cv::Mat *quantized_image) const;
+  void SpreadOrientations(const cv::Mat &quantized_image,
+                          cv::Mat *spread_image) const;
+  void MatchTemplatesOnCoarsestLevel(std::vector<Match> *matches) const;
+  void RefineMatch(int level, Match *match) const;
+  int CalculateScore(const std::vector<Feature> &features,
+                     const std::vector<cv::Mat> &response_maps, int u,
+                     int v) const;
+  void CalculatePose(const Match &match, Transform3fA *link2world_pose) const;
+  static int QuantizeAngle(float angle);
+
+  // Data
+  std::shared_ptr<Optimizer> optimizer_ptr_{};
+  std::shared_ptr<ColorCamera> color_camera_ptr_{};
+  std::shared_ptr<RegionModel> region_model_ptr_{};
+  std::vector<Template> templates_{};
+  std::array<cv::Mat, kNOrientations> response_luts_{};
+  std::vector<std::vector<cv::Mat>> level_response_maps_{};
+  std::vector<Transform3fA> link2world_pose_hypotheses_{};
+  std::vector<float> similarities_{};
+
+  // Parameters
+  std::vector<float> distances_{0.5f, 0.7f, 1.0f};
+  int n_rolls_ = 12;
+  float min_view_angle_ = 0.35f;
+  int n_features_ = 32;
+  int n_pyramid_levels_ = 3;
+  float min_magnitude_ = 50.0f;
+  float min_similarity_ = 0.7f;
+  int n_hypotheses_ = 5;
+};
+
+}  // namespace m3t
+
+#endif  // M3T_INCLUDE_M3T_TEMPLATE_DETECTOR_H_
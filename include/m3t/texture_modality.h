@@ -9,13 +9,17 @@
 #include <m3t/body.h>
 #include <m3t/camera.h>
 #include <m3t/common.h>
+#include <m3t/feature_cache.h>
 #include <m3t/modality.h>
 #include <m3t/renderer.h>
 #include <m3t/silhouette_renderer.h>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
+#include <bitset>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
 #ifdef USE_CUDA
 #include <opencv2/cudafeatures2d.hpp>
@@ -23,9 +27,13 @@
 #include <deque>
 #include <opencv2/features2d.hpp>
 #include <opencv2/opencv.hpp>
+#include <opencv2/video/tracking.hpp>
 #include <opencv2/xfeatures2d.hpp>
 #include <string>
 #include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace m3t {
 
@@ -39,7 +47,9 @@ namespace m3t {
  * to reconstruct 3D feature points for keyframes. The modality is able to
  * measure occlusions using images from a referenced \ref DepthCamera that is
  * close to the referenced \ref ColorCamera and model occlusions using
- * renderings from a \ref FocusedDepthRenderer object.
+ * renderings from a \ref FocusedDepthRenderer object. Using a \ref
+ * FeatureCache, features can be detected once per image for all modalities
+ * that reference the same \ref ColorCamera.
  *
  * @param color_camera_ptr referenced \ref ColorCamera from which images are
  * taken.
@@ -50,12 +60,18 @@ namespace m3t {
  * measured occlusion handling.
  * @param depth_renderer_ptr referenced \ref FocusedDepthRenderer that is used
  * for modeled occlusion handling.
+ * @param feature_cache_ptr referenced \ref FeatureCache from which keypoints
+ * and descriptors are obtained instead of detecting them individually.
  * @param descriptor_type specifies the \ref DescriptorType that defines which
  * descriptor and detector pair is used.
  * @param focused_image_size specifies the size of the image crop in which
  * features are detected.
  * @param descriptor_distance_threshold specifies the minimum difference of the
  * Hamming distance between the best and second-best match.
+ * @param max_hamming_distance maximum Hamming distance in bit for which
+ * matches of binary descriptors (BRISK, FREAK, ORB) are accepted. ORB
+ * descriptors have 256 bit, BRISK and FREAK descriptors 512 bit. Values above
+ * the descriptor length do not reject any match.
  * @param tukey_norm_constant defines the maximum expected value for valid
  * residual errors in image space in pixel.
  * @param standard_deviations user-defined standard deviation for each
@@ -67,6 +83,8 @@ namespace m3t {
  * has to be generated, even if the rotational difference criterion is not
  * fulfilled.
  * @param n_keyframes how many keyframes are considered at the same time.
+ * Descriptors of binary types are stored contiguously for all keyframes and
+ * matched in a single pass.
  * @param orb_n_features number of features considered by ORB detector.
  * @param orb_scale_factor scale factor used by ORB detector.
  * @param orb_n_levels number of levels considered by ORB detector.
@@ -95,6 +113,28 @@ namespace m3t {
  * SIFT detector.
  * @param sift_sigma sigma of the Gaussian applied to the input image at the
  * octave #0 by SIFT detector.
+ * @param use_klt_propagation if true, correspondences of the previous frame
+ * are propagated with pyramidal Lucas-Kanade optical flow instead of detecting
+ * and matching features in every frame.
+ * @param klt_detection_interval number of frames after which features are
+ * detected and matched again while KLT propagation is used.
+ * @param klt_min_n_points minimum number of propagated correspondences that
+ * are consistent with the estimated pose. If fewer remain, features are
+ * detected and matched in the next frame.
+ * @param klt_window_size size of the search window at each pyramid level in
+ * pixels.
+ * @param klt_n_pyramid_levels number of pyramid levels used for optical flow.
+ * @param klt_max_error maximum mean absolute intensity difference between the
+ * window around a previous and propagated correspondence center.
+ * @param klt_max_forward_backward_error maximum distance in pixels between a
+ * previous correspondence center and the point that is obtained by tracking
+ * the propagated center back to the previous image.
+ * @param use_silhouette_mask restrict feature detection and description to
+ * the dilated silhouette of the body in the \ref FocusedSilhouetteRenderer
+ * rendering of the current pose estimate. Features obtained from a \ref
+ * FeatureCache are filtered using the same mask.
+ * @param silhouette_mask_dilation number of pixels in the focused image by
+ * which the silhouette mask is dilated.
  * @param measured_occlusion_radius radius in meter that defines the area in
  * which depth measurements from a \ref DepthCamera are considered for occlusion
  * handling.
@@ -140,7 +180,16 @@ class TextureModality : public Modality {
     Eigen::Vector2f correspondence_center;
   };
 
+  // Match between a keyframe descriptor and a descriptor of the current frame
+  struct BinaryMatch {
+    int keyframe_id;
+    int keyframe_idx;
+    int idx;
+  };
+
  public:
+  static constexpr int kBinaryDescriptorBlockSize = 32;  // bytes
+
   /**
    * \brief Enum that defines considered descriptor and detector pairs.
    * @param BRISK uses the BRISK descriptor and BRISK detector.
@@ -186,6 +235,7 @@ class TextureModality : public Modality {
   void set_descriptor_type(DescriptorType descriptor_type);
   void set_focused_image_size(int focused_image_size);
   void set_descriptor_distance_threshold(float descriptor_distance_threshold);
+  void set_max_hamming_distance(int max_hamming_distance);
   void set_tukey_norm_constant(float tukey_norm_constant);
   void set_standard_deviations(const std::vector<float> &standard_deviations);
   void set_max_keyframe_rotation_difference(
@@ -213,6 +263,17 @@ class TextureModality : public Modality {
   void set_sift_contrast_threshold(double sift_contrast_threshold);
   void set_sift_edge_threshold(double sift_edge_threshold);
   void set_sift_sigma(double sift_sigma);
+  void set_use_silhouette_mask(bool use_silhouette_mask);
+  void set_silhouette_mask_dilation(int silhouette_mask_dilation);
+
+  // Setters for feature propagation
+  void set_use_klt_propagation(bool use_klt_propagation);
+  void set_klt_detection_interval(int klt_detection_interval);
+  void set_klt_min_n_points(int klt_min_n_points);
+  void set_klt_window_size(int klt_window_size);
+  void set_klt_n_pyramid_levels(int klt_n_pyramid_levels);
+  void set_klt_max_error(float klt_max_error);
+  void set_klt_max_forward_backward_error(float klt_max_forward_backward_error);
 
   // Setters for occlusion handling
   void MeasureOcclusions(const std::shared_ptr<DepthCamera> &depth_camera_ptr);
@@ -225,6 +286,10 @@ class TextureModality : public Modality {
   void set_modeled_occlusion_radius(float modeled_occlusion_radius);
   void set_modeled_occlusion_threshold(float modeled_occlusion_threshold);
 
+  // Setters for shared feature detection
+  void UseFeatureCache(const std::shared_ptr<FeatureCache> &feature_cache_ptr);
+  void DoNotUseFeatureCache();
+
   // Setters to turn on individual visualizations
   void set_visualize_correspondences_correspondence(
       bool visualize_correspondences_correspondence);
@@ -258,6 +323,9 @@ class TextureModality : public Modality {
   const std::shared_ptr<FocusedSilhouetteRenderer> &silhouette_renderer_ptr()
       const;
   const std::shared_ptr<FocusedDepthRenderer> &depth_renderer_ptr() const;
+  const std::shared_ptr<FeatureCache> &feature_cache_ptr() const;
+  int n_data_points() const;
+  bool data_points_propagated() const;
   std::shared_ptr<Model> model_ptr() const override;
   std::vector<std::shared_ptr<Camera>> camera_ptrs() const override;
   std::vector<std::shared_ptr<Renderer>> start_modality_renderer_ptrs()
@@ -268,6 +336,7 @@ class TextureModality : public Modality {
   DescriptorType descriptor_type() const;
   int focused_image_size() const;
   float descriptor_distance_threshold() const;
+  int max_hamming_distance() const;
   float tukey_norm_constant() const;
   const std::vector<float> &standard_deviations() const;
   float max_keyframe_rotation_difference() const;
@@ -294,6 +363,17 @@ class TextureModality : public Modality {
   double sift_contrast_threshold() const;
   double sift_edge_threshold() const;
   double sift_sigma() const;
+  bool use_silhouette_mask() const;
+  int silhouette_mask_dilation() const;
+
+  // Getters for feature propagation
+  bool use_klt_propagation() const;
+  int klt_detection_interval() const;
+  int klt_min_n_points() const;
+  int klt_window_size() const;
+  int klt_n_pyramid_levels() const;
+  float klt_max_error() const;
+  float klt_max_forward_backward_error() const;
 
   // Getters for occlusion handling
   bool measure_occlusions() const;
@@ -305,6 +385,9 @@ class TextureModality : public Modality {
   int n_unoccluded_iterations() const;
   int min_n_unoccluded_points() const;
 
+  // Getters for shared feature detection
+  bool use_feature_cache() const;
+
   // Getters to turn on individual visualizations
   bool visualize_correspondences_correspondence() const;
   bool visualize_correspondences_optimization() const;
@@ -317,6 +400,16 @@ class TextureModality : public Modality {
   float visualization_min_depth() const;
   float visualization_max_depth() const;
 
+  // Methods for binary descriptors that are zero-padded to blocks of
+  // kBinaryDescriptorBlockSize bytes
+  static int HammingDistance(const uchar *descriptor1, const uchar *descriptor2,
+                             int n_blocks);
+  static bool MatchBinaryDescriptor(const uchar *descriptor,
+                                    const cv::Mat &descriptors, int n_blocks,
+                                    int max_hamming_distance,
+                                    float descriptor_distance_threshold,
+                                    int *idx);
+
  private:
   // Helper method for setup
   bool LoadMetaData();
@@ -335,7 +428,15 @@ class TextureModality : public Modality {
   void DetectAndComputeCorrKeypoints();
   bool CalculateScaleAndRegionOfInterest(cv::Rect *region_of_interest,
                                          float *scale) const;
+  bool CalculateSilhouetteMask(const cv::Rect &region_of_interest, float scale,
+                               const cv::Size &size, cv::Mat *mask);
+  void FilterKeypointsWithSilhouetteMask();
   void ComputeKeyframeData();
+  bool PropagateDataPoints();
+  void UpdatePropagationImage();
+  void RemoveInconsistentDataPoints();
+  void UpdateBinaryDescriptorStore();
+  void MatchBinaryDescriptors();
   bool Reconstruct3DPoint(const cv::Point2f &center,
                           Eigen::Vector3f *center_f_body) const;
   bool IsPointValid(const Eigen::Vector3f &center_f_body,
@@ -382,6 +483,22 @@ class TextureModality : public Modality {
   Eigen::Vector3f orientation_last_keyframe_{};
   int keyframe_age_ = 0;
 
+  // Internal data for propagation of correspondences
+  cv::Mat propagation_image_;
+  cv::Rect propagation_region_{};
+  int n_frames_since_detection_ = 0;
+  bool keypoints_current_ = false;
+  bool data_points_propagated_ = false;
+
+  // Internal data for matching of binary descriptors
+  bool use_binary_matcher_ = false;
+  int n_binary_descriptor_blocks_ = 0;
+  cv::Mat binary_descriptors_keyframes_;
+  std::vector<int> binary_keyframe_ids_{};
+  std::vector<int> binary_keyframe_idxs_{};
+  cv::Mat binary_descriptors_;
+  std::vector<BinaryMatch> binary_matches_{};
+
 #ifdef USE_CUDA
   // Internal data specific to cuda implementation
   cv::Ptr<cv::cuda::ORB> feature_detector_orb_cuda_;
@@ -395,11 +512,13 @@ class TextureModality : public Modality {
   std::shared_ptr<DepthCamera> depth_camera_ptr_ = nullptr;
   std::shared_ptr<FocusedSilhouetteRenderer> silhouette_renderer_ptr_ = nullptr;
   std::shared_ptr<FocusedDepthRenderer> depth_renderer_ptr_ = nullptr;
+  std::shared_ptr<FeatureCache> feature_cache_ptr_ = nullptr;
 
   // Parameters for general settings
   DescriptorType descriptor_type_ = DescriptorType::ORB;
   int focused_image_size_ = 200;
   float descriptor_distance_threshold_ = 0.7f;
+  int max_hamming_distance_ = 64;
   float tukey_norm_constant_ = 20.0f;
   std::vector<float> standard_deviations_{15.0f, 5.0f};
   float max_keyframe_rotation_difference_ = 10.0f * kPi / 180.0f;
@@ -426,6 +545,17 @@ class TextureModality : public Modality {
   double sift_contrast_threshold_ = 0.04;
   double sift_edge_threshold_ = 10.0;
   double sift_sigma_ = 0.7;
+  bool use_silhouette_mask_ = false;
+  int silhouette_mask_dilation_ = 5;
+
+  // Parameters for feature propagation
+  bool use_klt_propagation_ = false;
+  int klt_detection_interval_ = 5;
+  int klt_min_n_points_ = 20;
+  int klt_window_size_ = 21;
+  int klt_n_pyramid_levels_ = 3;
+  float klt_max_error_ = 30.0f;
+  float klt_max_forward_backward_error_ = 1.0f;
 
   // Parameters for occlusion handling
   bool measure_occlusions_ = false;
@@ -435,6 +565,9 @@ class TextureModality : public Modality {
   float modeled_occlusion_radius_ = 0.01f;
   float modeled_occlusion_threshold_ = 0.03f;
 
+  // Parameters for shared feature detection
+  bool use_feature_cache_ = false;
+
   // Parameters to turn on individual visualizations
   bool visualize_correspondences_correspondence_ = false;
   bool visualize_correspondences_optimization_ = false;
@@ -452,8 +585,6 @@ class TextureModality : public Modality {
   float fv_{};
   float ppu_{};
   float ppv_{};
-  int image_width_minus_1_{};
-  int image_height_minus_1_{};
   float depth_fu_{};
   float depth_fv_{};
   float depth_ppu_{};
@@ -4,6 +4,7 @@
 #ifndef M3T_INCLUDE_M3T_TRACKER_H_
 #define M3T_INCLUDE_M3T_TRACKER_H_
 
+#include <m3t/batch_solver.h>
 #include <m3t/body.h>
 #include <m3t/camera.h>
 #include <m3t/color_histograms.h>
@@ -21,6 +22,7 @@
 #include <m3t/viewer.h>
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -49,7 +51,11 @@ namespace m3t {
  * Link, \ref Constraint, \ref Modality, \ref Model, \ref Renderer, \ref
  * RendererGeometry, \ref ColorHistograms \ref Camera, and \ref Body objects are
  * derived from objects that are provided by the user. `SetUp()` calls the
- * `SetUp()` method of all referenced objects in the correct order.
+ * `SetUp()` method of all referenced objects in the correct order. Before
+ * correspondences are established in each tracking step, \ref Optimizer
+ * objects predict poses using the latest timestamp of all \ref Camera objects.
+ * If detectors provide pose hypotheses in the detecting step, refiners
+ * evaluate them using `RefinePoseHypotheses()` instead of `RefinePoses()`.
  *
  * @param optimizer_ptrs referenced \ref Optimizer objects that are considered.
  * @param detector_ptrs referenced \ref Detector objects that are considered.
@@ -60,7 +66,8 @@ namespace m3t {
  * considered.
  * @param n_corr_iterations number of times new correspondences are established.
  * @param n_update_iterations number of times the pose is updated for each
- * correspondence iteration.
+ * correspondence iteration. Remaining update iterations are skipped if all
+ * tracked \ref Optimizer objects use Levenberg-Marquardt and have converged.
  * @param synchronize_cameras when true, \ref Camera objects wait for new images
  * to arrive. Otherwise they do not wait. Instead, the tracker waits until the
  * `cycle_duration` has passed and starts a new cycle.
@@ -72,6 +79,10 @@ namespace m3t {
  * Modality objects are shown. 0 corresponds to infinite time.
  * @param viewer_time time in milliseconds images from \ref Viewer objects are
  * shown. 0 corresponds to infinite time.
+ * @param use_batched_optimization if true, systems of all batchable \ref
+ * Optimizer objects with a single link are gathered and solved at once by a
+ * \ref BatchSolver before poses are updated. This is beneficial if many
+ * independent bodies are tracked. Other optimizers are computed individually.
  */
 class Tracker {
  public:
@@ -115,6 +126,7 @@ class Tracker {
   void set_cycle_duration(const std::chrono::milliseconds &cycle_duration);
   void set_visualization_time(int visualization_time);
   void set_viewer_time(int viewer_time);
+  void set_use_batched_optimization(bool use_batched_optimization);
 
   // Main method
   bool RunTrackerProcess(bool execute_detection = false,
@@ -147,21 +159,31 @@ class Tracker {
   void MoveBackPoses(const std::set<std::string> &names);
   bool DetectPoses(const std::set<std::string> &names,
               std::set<std::string> *detected_names = nullptr);
-  bool RefinePoses(const std::set<std::string> &names);
+  void AddPoseHypotheses(const std::set<std::string> &names,
+                         std::map<std::string, std::vector<Transform3fA>>
+                             *link2world_pose_hypotheses) const;
+  bool RefinePoses(const std::set<std::string> &names,
+                   const std::map<std::string, std::vector<Transform3fA>>
+                       *link2world_pose_hypotheses = nullptr);
   bool CalculateConsistentPoses();
 
   // Individual steps of starting step for advanced use
   bool StartModalities(int iteration);
+  void ResetMotionModels(const std::set<std::string> &names);
 
   // Individual steps of tracking step for advanced use
+  bool PredictPoses();
   bool CalculateCorrespondences(int iteration, int corr_iteration);
   bool VisualizeCorrespondences(int save_idx);
   bool CalculateGradientAndHessian(int iteration, int corr_iteration,
                                    int opt_iteration);
   bool CalculateOptimization(int iteration, int corr_iteration,
                              int opt_iteration);
+  bool CalculateBatchedOptimization(int iteration, int corr_iteration,
+                                    int opt_iteration);
   bool VisualizeOptimization(int save_idx);
   bool CalculateResults(int iteration);
+  bool UpdateMotionModels();
   bool VisualizeResults(int save_idx);
 
   // Getters
@@ -197,6 +219,7 @@ class Tracker {
   const std::chrono::milliseconds &cycle_duration() const;
   int visualization_time() const;
   int viewer_time() const;
+  bool use_batched_optimization() const;
   bool set_up() const;
 
  private:
@@ -210,6 +233,8 @@ class Tracker {
   void AssembleDerivedObjectPtrs();
   bool SetUpAllObjects();
   bool AreAllObjectsSetUp();
+  bool HaveOptimizersConverged() const;
+  double CameraTimestamp() const;
 
   // Objects
   std::vector<std::shared_ptr<Optimizer>> optimizer_ptrs_{};
@@ -241,6 +266,7 @@ class Tracker {
   std::chrono::milliseconds cycle_duration_{33};
   int visualization_time_ = 0;
   int viewer_time_ = 1;
+  bool use_batched_optimization_ = false;
 
   // Internally used objects
   std::vector<std::shared_ptr<Detector>> detecting_detector_ptrs_{};
@@ -258,6 +284,10 @@ class Tracker {
   std::vector<std::shared_ptr<ColorHistograms>>
       tracking_color_histograms_ptrs_{};
 
+  // Data for batched optimization
+  std::vector<Optimizer *> batched_optimizer_ptrs_{};
+  BatchSolver batch_solver_{};
+
   // State variables
   std::set<std::string> names_all_{};
   std::set<std::string> names_detecting_{};
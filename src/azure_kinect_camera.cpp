@@ -189,7 +189,11 @@ bool AzureKinectColorCamera::UpdateImage(bool synchronized) {
       temp_image, cv::COLOR_RGBA2RGB);
   cv::remap(temp_image, image_, distortion_map_, cv::Mat{}, cv::INTER_NEAREST,
             cv::BORDER_CONSTANT);
+  auto device_timestamp{
+      azure_kinect_.capture().get_color_image().get_device_timestamp()};
+  timestamp_ = std::chrono::duration<double>{device_timestamp}.count();
 
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
@@ -333,6 +337,9 @@ bool AzureKinectDepthCamera::UpdateImage(bool synchronized) {
               cv::Mat::AUTO_STEP},
       image_, distortion_map_, cv::Mat{}, cv::INTER_NEAREST,
       cv::BORDER_CONSTANT);
+  auto device_timestamp{
+      azure_kinect_.capture().get_depth_image().get_device_timestamp()};
+  timestamp_ = std::chrono::duration<double>{device_timestamp}.count();
 
   // Add depth offset
   if (depth_offset_) {
@@ -340,6 +347,7 @@ bool AzureKinectDepthCamera::UpdateImage(bool synchronized) {
     image_ += depth_value_offset;
   }
 
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
@@ -2,6 +2,7 @@
 // Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
 
 #include <m3t/basic_depth_renderer.h>
+#include <m3t/renderer_atlas.h>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -11,10 +12,25 @@ namespace m3t {
 std::string BasicDepthRendererCore::vertex_shader_code_ =
     "#version 330 core\n"
     "layout(location = 0) in vec3 aPos;\n"
-    "uniform mat4 Trans;\n"
+    "uniform mat4 Trans[" +
+    std::to_string(kMaxNInstances) +
+    "];\n"
+    "out float Depth;\n"
     "void main()\n"
     "{\n"
-    "  gl_Position = Trans * vec4(aPos, 1.0);\n"
+    "  gl_Position = Trans[gl_InstanceID] * vec4(aPos, 1.0);\n"
+    "  Depth = gl_Position.w;\n"
+    "}";
+
+std::string BasicDepthRendererCore::linear_fragment_shader_code_ =
+    "#version 330 core\n"
+    "in float Depth;\n"
+    "uniform float ZMin;\n"
+    "uniform float ZMax;\n"
+    "out float LinearDepth;\n"
+    "void main()\n"
+    "{\n"
+    "  LinearDepth = (Depth - ZMin) / (ZMax - ZMin);\n"
     "}";
 
 BasicDepthRendererCore ::~BasicDepthRendererCore() {
@@ -23,20 +39,37 @@ BasicDepthRendererCore ::~BasicDepthRendererCore() {
 
 bool BasicDepthRendererCore::SetUp(
     const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-    int image_width, int image_height) {
+    int image_width, int image_height, bool use_pixel_buffer_readback,
+    int context_id, bool use_linear_depth, float lod_max_pixel_error) {
+  if (context_id < 0 || context_id >= renderer_geometry_ptr->n_contexts()) {
+    std::cerr << "Context " << context_id << " of renderer geometry "
+              << renderer_geometry_ptr->name() << " does not exist"
+              << std::endl;
+    return false;
+  }
+  if (initial_set_up_) DeleteBufferObjects();
   renderer_geometry_ptr_ = renderer_geometry_ptr;
   image_width_ = image_width;
   image_height_ = image_height;
+  use_pixel_buffer_readback_ = use_pixel_buffer_readback;
+  context_id_ = context_id;
+  use_linear_depth_ = use_linear_depth;
+  lod_max_pixel_error_ = lod_max_pixel_error;
   image_rendered_ = false;
 
-  // Create shader program
+  // Create shader programs
   if (!initial_set_up_ &&
       !CreateShaderProgram(renderer_geometry_ptr_.get(),
                            vertex_shader_code_.c_str(), &shader_program_))
     return false;
+  if (use_linear_depth_ && !linear_shader_program_ &&
+      !CreateShaderProgram(renderer_geometry_ptr_.get(),
+                           vertex_shader_code_.c_str(),
+                           linear_fragment_shader_code_.c_str(),
+                           &linear_shader_program_))
+    return false;
 
   // Create buffer objects
-  if (initial_set_up_) DeleteBufferObjects();
   CreateBufferObjects();
   initial_set_up_ = true;
   return true;
@@ -45,39 +78,75 @@ bool BasicDepthRendererCore::SetUp(
 bool BasicDepthRendererCore::StartRendering(
     const Eigen::Matrix4f &projection_matrix,
     const Transform3fA &world2camera_pose) {
+  return StartRendering(projection_matrix, world2camera_pose,
+                        cv::Rect{0, 0, image_width_, image_height_});
+}
+
+bool BasicDepthRendererCore::StartRendering(
+    const Eigen::Matrix4f &projection_matrix,
+    const Transform3fA &world2camera_pose, const cv::Rect &region) {
   if (!initial_set_up_) return false;
-  renderer_geometry_ptr_->MakeContextCurrent();
+  region_ = region;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glViewport(0, 0, image_width_, image_height_);
 
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(region_.x, region_.y, region_.width, region_.height);
   glClear(GL_DEPTH_BUFFER_BIT);
+  if (use_linear_depth_) {
+    const float linear_depth_clear_value = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, &linear_depth_clear_value);
+  }
   glEnable(GL_DEPTH_TEST);
   glFrontFace(GL_CCW);
   glCullFace(GL_FRONT);
 
-  glUseProgram(shader_program_);
-  for (const auto &render_data_body :
-       renderer_geometry_ptr_->render_data_bodies()) {
-    Eigen::Matrix4f trans{
-        projection_matrix *
-        (world2camera_pose * render_data_body.body_ptr->geometry2world_pose())
-            .matrix()};
+  unsigned shader_program =
+      use_linear_depth_ ? linear_shader_program_ : shader_program_;
+  glUseProgram(shader_program);
+  if (use_linear_depth_)
+    SetLinearDepthUniforms(shader_program, projection_matrix);
+  float focal_length = 0.5f * projection_matrix(0, 0) * float(image_width_);
+  AssignInstanceGroups(renderer_geometry_ptr_->render_data_bodies(),
+                       world2camera_pose, focal_length, lod_max_pixel_error_,
+                       &instance_groups_);
+  for (const auto &instance_group : instance_groups_) {
+    int n_instances = int(instance_group.body_ptrs.size());
+    for (int i = 0; i < n_instances; ++i) {
+      transs_[i] = projection_matrix *
+                   (world2camera_pose *
+                    instance_group.body_ptrs[i]->geometry2world_pose())
+                       .matrix();
+    }
 
     unsigned loc;
-    loc = glGetUniformLocation(shader_program_, "Trans");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, trans.data());
+    loc = glGetUniformLocation(shader_program, "Trans");
+    glUniformMatrix4fv(loc, n_instances, GL_FALSE, transs_[0].data());
 
-    if (render_data_body.body_ptr->geometry_enable_culling())
+    if (instance_group.enable_culling)
       glEnable(GL_CULL_FACE);
     else
       glDisable(GL_CULL_FACE);
 
-    glBindVertexArray(render_data_body.vao);
-    glDrawArrays(GL_TRIANGLES, 0, render_data_body.n_vertices);
+    const auto &render_data_body{*instance_group.render_data_body_ptr};
+    int lod_level = instance_group.lod_level;
+    glBindVertexArray(render_data_body.context_vao(context_id_));
+    glDrawArraysInstanced(GL_TRIANGLES,
+                          render_data_body.first_vertex(lod_level),
+                          render_data_body.vertex_count(lod_level),
+                          n_instances);
     glBindVertexArray(0);
   }
+  glDisable(GL_SCISSOR_TEST);
+  if (use_pixel_buffer_readback_) {
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT0);
+    depth_reader_.StartReadback(
+        use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT,
+        region_);
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 
   image_rendered_ = true;
   image_fetched_ = false;
@@ -87,45 +156,76 @@ bool BasicDepthRendererCore::StartRendering(
 bool BasicDepthRendererCore::FetchDepthImage(cv::Mat *depth_image) {
   if (!initial_set_up_ || !image_rendered_) return false;
   if (image_fetched_) return true;
-  renderer_geometry_ptr_->MakeContextCurrent();
-  glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH,
-                GLint(depth_image->step / depth_image->elemSize()));
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-  glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
-  glReadPixels(0, 0, image_width_, image_height_, GL_DEPTH_COMPONENT,
-               GL_UNSIGNED_SHORT, depth_image->data);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  bool fetched = true;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
+  if (use_pixel_buffer_readback_) {
+    fetched = depth_reader_.Fetch(depth_image);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH,
+                  GLint(depth_image->step / depth_image->elemSize()));
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(region_.x, region_.y, region_.width, region_.height,
+                 use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT,
+                 GL_UNSIGNED_SHORT, (*depth_image)(region_).data);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
+  if (!fetched) return false;
+  FillOutsideRegion(region_, cv::Scalar{USHRT_MAX}, depth_image);
   image_fetched_ = true;
   return true;
 }
 
 void BasicDepthRendererCore::CreateBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
 
-  // Initialize renderbuffer bodies_render_data
+  // Initialize renderbuffer bodies_render_data. Linear depth is written to
+  // a color attachment and the depth attachment is only used for depth tests
   glGenRenderbuffers(1, &rbo_);
   glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, image_width_,
-                        image_height_);
+  glRenderbufferStorage(
+      GL_RENDERBUFFER,
+      use_linear_depth_ ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16,
+      image_width_, image_height_);
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
+  if (use_linear_depth_) {
+    glGenRenderbuffers(1, &rbo_linear_depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_linear_depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R16, image_width_,
+                          image_height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
   // Initialize framebuffer bodies_render_data
   glGenFramebuffers(1, &fbo_);
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
   glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                             GL_RENDERBUFFER, rbo_);
+  if (use_linear_depth_)
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, rbo_linear_depth_);
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+
+  // Initialize pixel buffer objects for asynchronous readback
+  if (use_pixel_buffer_readback_) {
+    depth_reader_.Create(image_width_, image_height_, 2);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 void BasicDepthRendererCore::DeleteBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glDeleteRenderbuffers(1, &rbo_);
+  glDeleteRenderbuffers(1, &rbo_linear_depth_);
+  rbo_linear_depth_ = 0;
   glDeleteFramebuffers(1, &fbo_);
-  renderer_geometry_ptr_->DetachContext();
+  depth_reader_.Delete();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 FullBasicDepthRenderer::FullBasicDepthRenderer(
@@ -170,7 +270,8 @@ bool FullBasicDepthRenderer::SetUp() {
   CalculateProjectionTerms();
   ClearDepthImage();
   if (!core_.SetUp(renderer_geometry_ptr_, intrinsics_.width,
-                   intrinsics_.height))
+                   intrinsics_.height, use_pixel_buffer_readback_, context_id_,
+                   use_linear_depth_, lod_max_pixel_error_))
     return false;
 
   set_up_ = true;
@@ -203,6 +304,11 @@ bool FullBasicDepthRenderer::LoadMetaData() {
   // Read parameters from yaml
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
   fs.release();
   return true;
 }
@@ -242,11 +348,17 @@ bool FocusedBasicDepthRenderer::SetUp() {
     if (!LoadMetaData()) return false;
 
   // Check if all required objects are set up
-  if (!renderer_geometry_ptr_->set_up()) {
+  if (!use_software_rendering_ && !renderer_geometry_ptr_->set_up()) {
     std::cerr << "Renderer geometry " << renderer_geometry_ptr_->name()
               << " was not set up" << std::endl;
     return false;
   }
+  if (use_software_rendering_ && use_atlas_) {
+    std::cerr << "Renderer " << name_
+              << " cannot use both software rendering and an atlas"
+              << std::endl;
+    return false;
+  }
   if (camera_ptr_ && !InitParametersFromCamera()) return false;
   if (referenced_body_ptrs_.empty()) {
     std::cerr << "No referenced bodys were assigned to renderer " << name_
@@ -265,21 +377,51 @@ bool FocusedBasicDepthRenderer::SetUp() {
   CalculateProjectionMatrix();
   CalculateProjectionTerms();
   ClearDepthImage();
-  if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_))
+  render_cache_valid_ = false;
+  if (use_software_rendering_) {
+    software_core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_,
+                         use_linear_depth_, lod_max_pixel_error_);
+  } else if (use_atlas_) {
+    if (!SetUpAtlas(IDType::BODY)) return false;
+  } else if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_,
+                          use_pixel_buffer_readback_, context_id_,
+                          use_linear_depth_, lod_max_pixel_error_)) {
     return false;
+  }
 
   set_up_ = true;
   return true;
 }
 
+void FocusedBasicDepthRenderer::set_use_software_rendering(
+    bool use_software_rendering) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  use_software_rendering_ = use_software_rendering;
+  set_up_ = false;
+}
+
 bool FocusedBasicDepthRenderer::StartRendering() {
   const std::lock_guard<std::mutex> lock{mutex_};
   if (!set_up_) {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (use_atlas_) {
+    CalculateProjectionMatrix();
+    return atlas_ptr_->StartRendering(this);
+  }
+  if (IsRenderCacheValid()) return true;
   CalculateProjectionMatrix();
-  return core_.StartRendering(projection_matrix_, world2camera_pose_);
+  if (use_software_rendering_) {
+    if (!software_core_.StartRendering(projection_matrix_, world2camera_pose_,
+                                       IDType::BODY))
+      return false;
+  } else if (!core_.StartRendering(projection_matrix_, world2camera_pose_,
+                                   valid_region_)) {
+    return false;
+  }
+  UpdateRenderCache();
+  return true;
 }
 
 bool FocusedBasicDepthRenderer::FetchDepthImage() {
@@ -288,9 +430,17 @@ bool FocusedBasicDepthRenderer::FetchDepthImage() {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (use_software_rendering_)
+    return software_core_.FetchDepthImage(&focused_depth_image_);
+  if (use_atlas_)
+    return atlas_ptr_->FetchDepthImage(this, &focused_depth_image_);
   return core_.FetchDepthImage(&focused_depth_image_);
 }
 
+bool FocusedBasicDepthRenderer::use_software_rendering() const {
+  return use_software_rendering_;
+}
+
 bool FocusedBasicDepthRenderer::LoadMetaData() {
   // Open file storage from yaml
   cv::FileStorage fs;
@@ -299,7 +449,17 @@ bool FocusedBasicDepthRenderer::LoadMetaData() {
   // Read parameters from yaml
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
   ReadOptionalValueFromYaml(fs, "image_size", &image_size_);
+  ReadOptionalValueFromYaml(fs, "use_software_rendering",
+                            &use_software_rendering_);
+  ReadOptionalValueFromYaml(fs, "render_cache_threshold",
+                            &render_cache_threshold_);
+  ReadOptionalValueFromYaml(fs, "use_region_readback", &use_region_readback_);
   fs.release();
   return true;
 }
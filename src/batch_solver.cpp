@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/batch_solver.h>
+
+namespace m3t {
+
+void BatchSolver::Resize(int n_systems) {
+  n_systems_ = n_systems;
+  if (data_.rows() < n_systems) {
+    data_.resize(n_systems, Eigen::NoChange);
+    positive_definite_.resize(n_systems);
+  }
+}
+
+void BatchSolver::SetSystem(int idx, const Eigen::Matrix<float, 6, 6> &a,
+                            const Eigen::Matrix<float, 6, 1> &b) {
+  for (int row = 0; row < 6; ++row) {
+    for (int col = 0; col <= row; ++col)
+      data_(idx, LowerIndex(row, col)) = a(row, col);
+    data_(idx, kBIndex + row) = b(row);
+  }
+}
+
+void BatchSolver::Solve() {
+  auto column{[&](int idx) { return data_.col(idx).head(n_systems_); }};
+  auto positive_definite{positive_definite_.head(n_systems_)};
+  positive_definite.setConstant(true);
+
+  // Calculate Cholesky decomposition and inverse diagonal
+  for (int j = 0; j < 6; ++j) {
+    auto diagonal{column(LowerIndex(j, j))};
+    for (int k = 0; k < j; ++k) diagonal -= column(LowerIndex(j, k)).square();
+    positive_definite = positive_definite && (diagonal > 0.0f);
+    diagonal = (diagonal > 0.0f).select(diagonal, 1.0f);
+    auto inverse_diagonal{column(kInverseDiagonalIndex + j)};
+    inverse_diagonal = diagonal.rsqrt();
+    for (int i = j + 1; i < 6; ++i) {
+      auto coefficient{column(LowerIndex(i, j))};
+      for (int k = 0; k < j; ++k)
+        coefficient -= column(LowerIndex(i, k)) * column(LowerIndex(j, k));
+      coefficient *= inverse_diagonal;
+    }
+  }
+
+  // Forward substitution with lower triangular matrix
+  for (int i = 0; i < 6; ++i) {
+    auto y{column(kBIndex + i)};
+    for (int k = 0; k < i; ++k)
+      y -= column(LowerIndex(i, k)) * column(kBIndex + k);
+    y *= column(kInverseDiagonalIndex + i);
+  }
+
+  // Backward substitution with transposed lower triangular matrix
+  for (int i = 5; i >= 0; --i) {
+    auto x{column(kBIndex + i)};
+    for (int k = i + 1; k < 6; ++k)
+      x -= column(LowerIndex(k, i)) * column(kBIndex + k);
+    x *= column(kInverseDiagonalIndex + i);
+  }
+}
+
+bool BatchSolver::GetSolution(int idx,
+                              Eigen::Matrix<float, 6, 1> *theta) const {
+  if (!positive_definite_(idx)) return false;
+  for (int row = 0; row < 6; ++row) (*theta)(row) = data_(idx, kBIndex + row);
+  return true;
+}
+
+int BatchSolver::n_systems() const { return n_systems_; }
+
+}  // namespace m3t
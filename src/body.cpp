@@ -6,6 +6,12 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader/tiny_obj_loader.h>
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace m3t {
 
 std::atomic<uchar> Body::next_id_{1};
@@ -37,6 +43,7 @@ bool Body::SetUp() {
     if (!LoadMetaData()) return false;
   if (!LoadMeshData()) return false;
   if (!CalculateMaximumBodyDiameter()) return false;
+  if (!GenerateLODMeshes()) return false;
   set_up_ = true;
   return true;
 }
@@ -73,6 +80,27 @@ void Body::set_geometry2body_pose(const Transform3fA &geometry2body_pose) {
   set_up_ = false;
 }
 
+void Body::set_n_lod_levels(int n_lod_levels) {
+  n_lod_levels_ = n_lod_levels;
+  set_up_ = false;
+}
+
+void Body::set_lod_reduction_factor(float lod_reduction_factor) {
+  lod_reduction_factor_ = lod_reduction_factor;
+  set_up_ = false;
+}
+
+void Body::set_use_mesh_cache(bool use_mesh_cache) {
+  use_mesh_cache_ = use_mesh_cache;
+  set_up_ = false;
+}
+
+void Body::set_mesh_cache_directory(
+    const std::filesystem::path &mesh_cache_directory) {
+  mesh_cache_directory_ = mesh_cache_directory;
+  set_up_ = false;
+}
+
 void Body::set_id(IDType id_type, uchar id) {
   if (id_type == IDType::BODY) body_id_ = id;
   if (id_type == IDType::REGION) region_id_ = id;
@@ -118,6 +146,23 @@ const Transform3fA &Body::geometry2body_pose() const {
   return geometry2body_pose_;
 }
 
+int Body::n_lod_levels() const { return n_lod_levels_; }
+
+float Body::lod_reduction_factor() const { return lod_reduction_factor_; }
+
+bool Body::use_mesh_cache() const { return use_mesh_cache_; }
+
+const std::filesystem::path &Body::mesh_cache_directory() const {
+  return mesh_cache_directory_;
+}
+
+std::filesystem::path Body::mesh_cache_path() const {
+  if (mesh_cache_directory_.empty())
+    return std::filesystem::path{geometry_path_.string() + ".m3tmesh"};
+  return mesh_cache_directory_ /
+         (geometry_path_.filename().string() + ".m3tmesh");
+}
+
 uchar Body::get_id(IDType id_type) const {
   if (id_type == IDType::BODY) return body_id_;
   if (id_type == IDType::REGION) return region_id_;
@@ -147,6 +192,16 @@ const std::vector<Eigen::Vector3f> &Body::vertices() const { return vertices_; }
 
 float Body::maximum_body_diameter() const { return maximum_body_diameter_; }
 
+const std::vector<LODMesh> &Body::lod_meshes() const { return lod_meshes_; }
+
+int Body::SelectLODLevel(float max_geometric_error) const {
+  int lod_level = 0;
+  while (lod_level < int(lod_meshes_.size()) &&
+         lod_meshes_[lod_level].geometric_error <= max_geometric_error)
+    lod_level++;
+  return lod_level;
+}
+
 bool Body::set_up() const { return set_up_; }
 
 bool Body::LoadMetaData() {
@@ -170,6 +225,12 @@ bool Body::LoadMetaData() {
   }
   ReadOptionalValueFromYaml(fs, "body_id", &body_id_);
   ReadOptionalValueFromYaml(fs, "region_id", &region_id_);
+  ReadOptionalValueFromYaml(fs, "n_lod_levels", &n_lod_levels_);
+  ReadOptionalValueFromYaml(fs, "lod_reduction_factor",
+                            &lod_reduction_factor_);
+  ReadOptionalValueFromYaml(fs, "use_mesh_cache", &use_mesh_cache_);
+  ReadOptionalValueFromYaml(fs, "mesh_cache_directory",
+                            &mesh_cache_directory_);
   fs.release();
 
   // Process parameters
@@ -177,12 +238,35 @@ bool Body::LoadMetaData() {
     geometry_path_ = metafile_path_.parent_path() / (name_ + ".obj");
   else if (geometry_path_.is_relative())
     geometry_path_ = metafile_path_.parent_path() / geometry_path_;
+  if (!mesh_cache_directory_.empty() && mesh_cache_directory_.is_relative())
+    mesh_cache_directory_ =
+        metafile_path_.parent_path() / mesh_cache_directory_;
   geometry2world_pose_ = body2world_pose_ * geometry2body_pose_;
   world2geometry_pose_ = geometry2world_pose_.inverse();
   return true;
 }
 
 bool Body::LoadMeshData() {
+  if (!use_mesh_cache_ || !LoadMeshCache()) {
+    if (!LoadObjFile()) return false;
+    if (use_mesh_cache_) SaveMeshCache();
+  }
+
+  // Scale vertices and change winding order if needed
+  if (geometry_unit_in_meter_ != 1.0f) {
+    for (auto &vertex : vertices_) {
+      vertex *= geometry_unit_in_meter_;
+    }
+  }
+  if (!geometry_counterclockwise_) {
+    for (auto &triangle : mesh_indices_) {
+      std::swap(triangle[0], triangle[2]);
+    }
+  }
+  return true;
+}
+
+bool Body::LoadObjFile() {
   tinyobj::attrib_t attributes;
   std::vector<tinyobj::shape_t> shapes;
   std::vector<tinyobj::material_t> materials;
@@ -197,15 +281,10 @@ bool Body::LoadMeshData() {
   }
   if (!error.empty()) std::cerr << error << std::endl;
 
-  // Load vertices and scale them if needed
+  // Load vertices
   vertices_.resize(attributes.vertices.size() / 3);
   memcpy(vertices_.data(), attributes.vertices.data(),
          sizeof(float) * attributes.vertices.size());
-  if (geometry_unit_in_meter_ != 1.0f) {
-    for (auto &vertex : vertices_) {
-      vertex *= geometry_unit_in_meter_;
-    }
-  }
 
   // Reserve space
   mesh_indices_.clear();
@@ -223,24 +302,137 @@ bool Body::LoadMeshData() {
         index_offset += shape.mesh.num_face_vertices[f];
         continue;
       }
-
-      if (geometry_counterclockwise_) {
-        mesh_indices_.push_back(std::array<int, 3>{
-            shape.mesh.indices[index_offset].vertex_index,
-            shape.mesh.indices[index_offset + 1].vertex_index,
-            shape.mesh.indices[index_offset + 2].vertex_index});
-      } else {
-        mesh_indices_.push_back(std::array<int, 3>{
-            shape.mesh.indices[index_offset + 2].vertex_index,
-            shape.mesh.indices[index_offset + 1].vertex_index,
-            shape.mesh.indices[index_offset].vertex_index});
-      }
+      mesh_indices_.push_back(std::array<int, 3>{
+          shape.mesh.indices[index_offset].vertex_index,
+          shape.mesh.indices[index_offset + 1].vertex_index,
+          shape.mesh.indices[index_offset + 2].vertex_index});
       index_offset += 3;
     }
   }
   return true;
 }
 
+bool Body::LoadMeshCache() {
+  std::filesystem::path cache_path{mesh_cache_path()};
+  std::ifstream ifs{cache_path, std::ios::binary};
+  if (!ifs.is_open()) return false;
+
+  // Validate header against obj file
+  MeshCacheHeader header;
+  uint64_t obj_size;
+  int64_t obj_write_time;
+  if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, kMeshCacheMagic, sizeof(header.magic)) != 0 ||
+      header.version != kMeshCacheVersion ||
+      !GetObjFileStatus(&obj_size, &obj_write_time) ||
+      header.obj_size != obj_size)
+    return false;
+  if (header.obj_write_time != obj_write_time &&
+      header.obj_hash != HashFile(geometry_path_))
+    return false;
+
+  // Validate sizes stored in header against size of cache file
+  std::error_code error_code;
+  uint64_t cache_size =
+      uint64_t(std::filesystem::file_size(cache_path, error_code));
+  if (error_code || cache_size < sizeof(header)) return false;
+  uint64_t data_size = cache_size - sizeof(header);
+  if (header.n_vertices > data_size / sizeof(Eigen::Vector3f) ||
+      header.n_triangles > data_size / sizeof(std::array<int, 3>) ||
+      header.n_vertices * sizeof(Eigen::Vector3f) +
+              header.n_triangles * sizeof(std::array<int, 3>) !=
+          data_size)
+    return false;
+
+  // Read data in single blocks
+  vertices_.resize(header.n_vertices);
+  mesh_indices_.resize(header.n_triangles);
+  if (!ifs.read(reinterpret_cast<char *>(vertices_.data()),
+                sizeof(Eigen::Vector3f) * vertices_.size()) ||
+      !ifs.read(reinterpret_cast<char *>(mesh_indices_.data()),
+                sizeof(std::array<int, 3>) * mesh_indices_.size()))
+    return false;
+
+  // Reject corrupted caches
+  for (const auto &triangle : mesh_indices_) {
+    for (int index : triangle) {
+      if (index < 0 || index >= int(vertices_.size())) return false;
+    }
+  }
+  return true;
+}
+
+void Body::SaveMeshCache() const {
+  MeshCacheHeader header{};
+  memcpy(header.magic, kMeshCacheMagic, sizeof(header.magic));
+  header.version = kMeshCacheVersion;
+  if (!GetObjFileStatus(&header.obj_size, &header.obj_write_time)) return;
+  header.obj_hash = HashFile(geometry_path_);
+  header.n_vertices = vertices_.size();
+  header.n_triangles = mesh_indices_.size();
+
+  // Write to temporary file that is unique for each process and body and
+  // rename it to avoid reading partial caches
+  std::filesystem::path cache_path{mesh_cache_path()};
+  if (!mesh_cache_directory_.empty()) {
+    std::error_code error_code;
+    std::filesystem::create_directories(mesh_cache_directory_, error_code);
+    if (error_code) return;
+  }
+#ifdef _WIN32
+  int process_id = _getpid();
+#else
+  int process_id = int(getpid());
+#endif
+  std::filesystem::path temporary_path{
+      cache_path.string() + "." + std::to_string(process_id) + "." +
+      std::to_string(uintptr_t(this)) + ".tmp"};
+  {
+    std::ofstream ofs{temporary_path, std::ios::binary};
+    if (!ofs.is_open()) return;
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(vertices_.data()),
+              sizeof(Eigen::Vector3f) * vertices_.size());
+    ofs.write(reinterpret_cast<const char *>(mesh_indices_.data()),
+              sizeof(std::array<int, 3>) * mesh_indices_.size());
+    if (!ofs) {
+      ofs.close();
+      std::error_code error_code;
+      std::filesystem::remove(temporary_path, error_code);
+      return;
+    }
+  }
+  std::error_code error_code;
+  std::filesystem::rename(temporary_path, cache_path, error_code);
+  if (error_code) std::filesystem::remove(temporary_path, error_code);
+}
+
+bool Body::GetObjFileStatus(uint64_t *obj_size,
+                            int64_t *obj_write_time) const {
+  std::error_code error_code;
+  *obj_size = uint64_t(std::filesystem::file_size(geometry_path_, error_code));
+  if (error_code) return false;
+  *obj_write_time = int64_t(std::filesystem::last_write_time(
+                                geometry_path_, error_code)
+                                .time_since_epoch()
+                                .count());
+  return !error_code;
+}
+
+uint64_t Body::HashFile(const std::filesystem::path &path) {
+  // 64-bit FNV-1a hash
+  uint64_t hash = 14695981039346656037ull;
+  std::ifstream ifs{path, std::ios::binary};
+  std::array<char, 65536> buffer;
+  while (ifs.read(buffer.data(), buffer.size()) || ifs.gcount() > 0) {
+    for (std::streamsize i = 0; i < ifs.gcount(); ++i) {
+      hash ^= uint64_t(uchar(buffer[i]));
+      hash *= 1099511628211ull;
+    }
+  }
+  return hash;
+}
+
 bool Body::CalculateMaximumBodyDiameter() {
   float max_radius = 0.0f;
   for (const auto &vertex : vertices_) {
@@ -250,4 +442,28 @@ bool Body::CalculateMaximumBodyDiameter() {
   return true;
 }
 
+bool Body::GenerateLODMeshes() {
+  lod_meshes_.clear();
+  if (n_lod_levels_ <= 0) return true;
+  if (lod_reduction_factor_ <= 0.0f || lod_reduction_factor_ >= 1.0f) {
+    std::cerr << "LOD reduction factor of body " << name_
+              << " has to be between 0 and 1" << std::endl;
+    return false;
+  }
+
+  // Calculate number of triangles for all levels
+  std::vector<int> target_n_triangles;
+  float n_triangles = float(mesh_indices_.size());
+  for (int i = 0; i < n_lod_levels_; ++i) {
+    n_triangles *= lod_reduction_factor_;
+    if (n_triangles < kMinLODTriangles) break;
+    target_n_triangles.push_back(int(n_triangles));
+  }
+
+  MeshSimplifier mesh_simplifier;
+  mesh_simplifier.Simplify(vertices_, mesh_indices_, target_n_triangles,
+                           &lod_meshes_);
+  return true;
+}
+
 }  // namespace m3t
@@ -24,6 +24,8 @@ void Camera::set_world2camera_pose(const Transform3fA &world2camera_pose) {
   camera2world_pose_ = world2camera_pose_.inverse();
 }
 
+void Camera::set_timestamp(double timestamp) { timestamp_ = timestamp; }
+
 void Camera::StartSavingImages(const std::filesystem::path &save_directory,
                                int save_index,
                                const std::string &save_image_type) {
@@ -54,6 +56,10 @@ const Transform3fA &Camera::world2camera_pose() const {
   return world2camera_pose_;
 }
 
+double Camera::timestamp() const { return timestamp_; }
+
+int Camera::image_index() const { return image_index_; }
+
 const std::filesystem::path &Camera::save_directory() const {
   return save_directory_;
 }
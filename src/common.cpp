@@ -303,4 +303,48 @@ void DrawFocusedPointInImage(const Eigen::Vector3f &point_f_camera,
   cv::circle(*image, cv::Point2i{u_focused, v_focused}, 1, color, cv::FILLED);
 }
 
+bool CalculateScaleAndRegionOfInterest(const Transform3fA &body2camera_pose,
+                                       float body_radius,
+                                       const Intrinsics &intrinsics,
+                                       int focused_image_size, int margin,
+                                       cv::Rect *region_of_interest,
+                                       float *scale) {
+  // Project sphere into image
+  float r = body_radius;
+  auto translation{body2camera_pose.translation()};
+  float x = translation(0);
+  float y = translation(1);
+  float z = translation(2);
+  if (z < r * 1.5f) return false;
+  float abs_x = std::abs(x);
+  float abs_y = std::abs(y);
+  float x2 = x * x;
+  float y2 = y * y;
+  float z2 = z * z;
+  float r2 = r * r;
+  float rz = r * z;
+  float z2_r2 = z2 - r2;
+  float z3_zr2 = z2_r2 * z;
+  float r_u = intrinsics.fu * (abs_x * r2 + rz * sqrtf(z2_r2 + x2)) / z3_zr2;
+  float r_v = intrinsics.fv * (abs_y * r2 + rz * sqrtf(z2_r2 + y2)) / z3_zr2;
+  float center_u = x * intrinsics.fu / z + intrinsics.ppu;
+  float center_v = y * intrinsics.fv / z + intrinsics.ppv;
+
+  // Calculate region of interest
+  int u_min = int(center_u - r_u - margin + 0.5f);
+  int u_max = int(center_u + r_u + margin + 0.5f);
+  int v_min = int(center_v - r_v - margin + 0.5f);
+  int v_max = int(center_v + r_v + margin + 0.5f);
+  u_min = std::max(u_min, 0);
+  u_max = std::min(u_max, intrinsics.width - 1);
+  v_min = std::max(v_min, 0);
+  v_max = std::min(v_max, intrinsics.height - 1);
+  if (u_min >= u_max || v_min >= v_max) return false;
+  *region_of_interest = cv::Rect{u_min, v_min, u_max - u_min, v_max - v_min};
+
+  // Calculate scale
+  *scale = float(focused_image_size) / std::max(2.0f * r_u, 2.0f * r_v);
+  return true;
+}
+
 }  // namespace m3t
@@ -91,14 +91,14 @@ bool Constraint::CalculateResidualAndConstraintJacobian() {
   auto joint22joint1_pose{body22joint1_pose * body22joint2_pose_.inverse()};
 
   // Calculate residual
-  residual_ = Residual(joint22joint1_pose);
+  Residual(joint22joint1_pose, &residual_);
 
   // Calculate jacobian
-  constraint_jacobian_ =
-      UnprojectedConstraintJacobian(joint22joint1_pose, body22joint1_pose) *
-          link2_ptr_->jacobian() -
-      UnprojectedConstraintJacobian(joint22joint1_pose, body12joint1_pose_) *
-          link1_ptr_->jacobian();
+  UnprojectedConstraintJacobian(joint22joint1_pose, body12joint1_pose_,
+                                &link1_constraint_jacobian_);
+  link1_constraint_jacobian_ *= -1.0f;
+  UnprojectedConstraintJacobian(joint22joint1_pose, body22joint1_pose,
+                                &link2_constraint_jacobian_);
   return true;
 }
 
@@ -115,8 +115,12 @@ int Constraint::NumberOfConstraints() {
 
 const Eigen::VectorXf &Constraint::residual() { return residual_; }
 
-const Eigen::MatrixXf &Constraint::constraint_jacobian() {
-  return constraint_jacobian_;
+const Eigen::MatrixXf &Constraint::link1_constraint_jacobian() {
+  return link1_constraint_jacobian_;
+}
+
+const Eigen::MatrixXf &Constraint::link2_constraint_jacobian() {
+  return link2_constraint_jacobian_;
 }
 
 const std::string &Constraint::name() const { return name_; }
@@ -173,72 +177,66 @@ bool Constraint::LoadMetaData() {
   return true;
 }
 
-Eigen::VectorXf Constraint::Residual(const Transform3fA &joint22joint1_pose) {
-  Eigen::AngleAxisf angle_axis{joint22joint1_pose.rotation()};
-  Eigen::Vector3f rotation_vector{angle_axis.angle() * angle_axis.axis()};
+void Constraint::Residual(const Transform3fA &joint22joint1_pose,
+                          Eigen::VectorXf *residual) {
+  Eigen::Vector3f rotation_vector{LogSO3(joint22joint1_pose.linear())};
   Eigen::Vector3f translation_vector{joint22joint1_pose.translation()};
 
   // Calculations for normal vector constraint experiment
   if (kOrthogonalityConstraintExperiment) {
-    Eigen::VectorXf residual{Eigen::VectorXf::Zero(NumberOfConstraints())};
+    residual->setZero(NumberOfConstraints());
     for (int i = 0; i < NumberOfConstraints(); ++i) {
       if (i < 3)
-        residual(i) = translation_vector(i);
+        (*residual)(i) = translation_vector(i);
       else if (i < 6)
-        residual(i) =
+        (*residual)(i) =
             joint22joint1_pose.rotation().matrix()(i % 3, (i + 1) % 3);
       else
-        residual(i) =
+        (*residual)(i) =
             joint22joint1_pose.rotation().matrix()(i % 3, (i + 2) % 3);
     }
-    return residual;
+    return;
   }
 
-  Eigen::VectorXf residual{Eigen::VectorXf::Zero(NumberOfConstraints())};
+  residual->setZero(NumberOfConstraints());
   int residual_idx = 0;
   for (int direction = 0; direction < 6; ++direction) {
     if (constraint_directions_[direction]) {
       if (direction < 3)
-        residual(residual_idx) = rotation_vector(direction);
+        (*residual)(residual_idx) = rotation_vector(direction);
       else
-        residual(residual_idx) = translation_vector(direction - 3);
+        (*residual)(residual_idx) = translation_vector(direction - 3);
       residual_idx++;
     }
   }
-  return residual;
 }
 
-Eigen::MatrixXf Constraint::UnprojectedConstraintJacobian(
+void Constraint::UnprojectedConstraintJacobian(
     const Transform3fA &joint22joint1_pose,
-    const Transform3fA &body2joint1_pose) {
+    const Transform3fA &body2joint1_pose, Eigen::MatrixXf *jacobian) {
   Transform3fA body2joint2_pose{joint22joint1_pose.inverse() *
                                 body2joint1_pose};
   Eigen::Vector3f joint22body_translation{
       body2joint2_pose.inverse().translation().matrix()};
-  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.rotation().matrix()};
-  Eigen::AngleAxisf angle_axis{joint22joint1_pose.rotation()};
-  Eigen::Vector3f axis{angle_axis.axis()};
-  float angle_half = 0.5f * angle_axis.angle();
+  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.linear()};
   Eigen::Matrix3f variation_matrix{
-      xcotx(angle_half) * Eigen::Matrix3f::Identity() -
-      angle_half * Vector2Skewsymmetric(axis) +
-      (1.0f - xcotx(angle_half)) * axis * axis.transpose()};
+      InverseLeftJacobianSO3(LogSO3(joint22joint1_pose.linear()))};
 
   // Calculations for normal vector constraint experiment
   if (kOrthogonalityConstraintExperiment) {
-    Eigen::MatrixXf jacobian{Eigen::MatrixXf::Zero(NumberOfConstraints(), 6)};
+    jacobian->setZero(NumberOfConstraints(), 6);
     Eigen::Matrix3f body2joint2_rotation{body2joint2_pose.rotation().matrix()};
     for (int i = 0; i < NumberOfConstraints(); ++i) {
       if (i < 3) {
-        jacobian.row(i).head<3>() =
+        jacobian->row(i).head<3>() =
             joint22body_translation.cross(body2joint1_rotation.row(i));
-        jacobian.row(i).tail<3>() = body2joint1_rotation.row(i);
+        jacobian->row(i).tail<3>() = body2joint1_rotation.row(i);
       } else if (i < 6) {
         Eigen::Vector3f joint22joint1_rotation_row =
             joint22joint1_pose.rotation().matrix().row(i % 3);
         int i1 = (i + 2) % 3;
         int i2 = (i + 3) % 3;
-        jacobian.row(i).head<3>() =
+        jacobian->row(i).head<3>() =
             joint22joint1_rotation_row(i1) * body2joint2_rotation.row(i2) -
             joint22joint1_rotation_row(i2) * body2joint2_rotation.row(i1);
       } else {
@@ -246,31 +244,30 @@ Eigen::MatrixXf Constraint::UnprojectedConstraintJacobian(
             joint22joint1_pose.rotation().matrix().row(i % 3);
         int i1 = (i + 0) % 3;
         int i2 = (i + 1) % 3;
-        jacobian.row(i).head<3>() =
+        jacobian->row(i).head<3>() =
             joint22joint1_rotation_row(i1) * body2joint2_rotation.row(i2) -
             joint22joint1_rotation_row(i2) * body2joint2_rotation.row(i1);
       }
     }
-    return jacobian;
+    return;
   }
 
-  Eigen::MatrixXf jacobian{Eigen::MatrixXf::Zero(NumberOfConstraints(), 6)};
+  jacobian->setZero(NumberOfConstraints(), 6);
   int jacobian_idx = 0;
   for (int direction = 0; direction < 6; ++direction) {
     if (constraint_directions_[direction]) {
       if (direction < 3) {
-        jacobian.row(jacobian_idx).head<3>() =
+        jacobian->row(jacobian_idx).head<3>() =
             variation_matrix.row(direction) * body2joint1_rotation;
       } else {
-        jacobian.row(jacobian_idx).head<3>() = joint22body_translation.cross(
+        jacobian->row(jacobian_idx).head<3>() = joint22body_translation.cross(
             body2joint1_rotation.row(direction - 3));
-        jacobian.row(jacobian_idx).tail<3>() =
+        jacobian->row(jacobian_idx).tail<3>() =
             body2joint1_rotation.row(direction - 3);
       }
       jacobian_idx++;
     }
   }
-  return jacobian;
 }
 
 }  // namespace m3t
@@ -290,6 +290,7 @@ bool DepthModality::CalculateCorrespondences(int iteration,
               << data_model_points.size() << " < " << n_points << std::endl;
     n_points = data_model_points.size();
   }
+  n_considered_points_ = n_points;
 
   // Iterate over n_points
   for (int j = 0; j < 2; ++j) {
@@ -401,6 +402,27 @@ bool DepthModality::VisualizeResults(int save_idx) {
   return true;
 }
 
+bool DepthModality::CalculateScore(float *score) {
+  if (!IsSetup()) return false;
+
+  // Evaluate point-to-plane errors with respect to the standard deviation
+  PrecalculatePoseVariables();
+  float score_sum = 0.0f;
+  for (const auto &data_point : data_points_) {
+    Eigen::Vector3f correspondence_center_f_body{
+        camera2body_pose_ * data_point.correspondence_center_f_camera};
+    float epsilon = data_point.normal_f_body.dot(data_point.center_f_body -
+                                                 correspondence_center_f_body);
+    float weight = 1.0f / (standard_deviation_ *
+                           data_point.correspondence_center_f_camera(2));
+    score_sum += std::exp(-0.5f * epsilon * epsilon * weight * weight);
+  }
+  *score = n_considered_points_ > 0
+               ? score_sum / float(n_considered_points_)
+               : 0.0f;
+  return true;
+}
+
 const std::shared_ptr<DepthCamera> &DepthModality::depth_camera_ptr() const {
   return depth_camera_ptr_;
 }
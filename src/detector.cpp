@@ -16,6 +16,11 @@ void Detector::set_reset_joint_poses(bool reset_joint_poses) {
   reset_joint_poses_ = reset_joint_poses;
 }
 
+void Detector::AddPoseHypotheses(
+    const std::set<std::string> &names,
+    std::map<std::string, std::vector<Transform3fA>>
+        *link2world_pose_hypotheses) const {}
+
 const std::string &Detector::name() const { return name_; }
 
 const std::filesystem::path &Detector::metafile_path() const {
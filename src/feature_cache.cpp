@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/feature_cache.h>
+
+namespace m3t {
+
+FeatureCache::FeatureCache(const std::string &name,
+                           const std::shared_ptr<ColorCamera> &color_camera_ptr)
+    : name_{name}, color_camera_ptr_{color_camera_ptr} {}
+
+bool FeatureCache::SetUp() {
+  set_up_ = false;
+  if (!color_camera_ptr_->set_up()) {
+    std::cerr << "Color camera " << color_camera_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
+  image_data_ = nullptr;
+  set_up_ = true;
+  return true;
+}
+
+void FeatureCache::set_name(const std::string &name) { name_ = name; }
+
+void FeatureCache::set_color_camera_ptr(
+    const std::shared_ptr<ColorCamera> &color_camera_ptr) {
+  color_camera_ptr_ = color_camera_ptr;
+  set_up_ = false;
+}
+
+bool FeatureCache::AddRequest(const std::string &name,
+                              const std::shared_ptr<Body> &body_ptr,
+                              int focused_image_size,
+                              const cv::Ptr<cv::Feature2D> &feature_detector,
+                              const cv::Ptr<cv::Feature2D> &feature_descriptor) {
+  // Check if detector and descriptor are compatible with previous requests
+  auto request_it{std::find_if(
+      begin(requests_), end(requests_),
+      [&](const Request &request) { return request.name == name; })};
+  bool first_request = requests_.empty() ||
+                       (requests_.size() == 1 && request_it != end(requests_));
+  if (first_request) {
+    // Copy ORB detector to change the number of features without affecting
+    // the detector of the modality
+    auto orb_detector{feature_detector.dynamicCast<cv::ORB>()};
+    if (orb_detector) {
+      orb_detector_ = cv::ORB::create(
+          orb_detector->getMaxFeatures(), orb_detector->getScaleFactor(),
+          orb_detector->getNLevels(), orb_detector->getEdgeThreshold(),
+          orb_detector->getFirstLevel(), orb_detector->getWTA_K(),
+          orb_detector->getScoreType(), orb_detector->getPatchSize(),
+          orb_detector->getFastThreshold());
+      orb_n_features_ = orb_detector->getMaxFeatures();
+      feature_detector_ = orb_detector_;
+    } else {
+      orb_detector_.reset();
+      orb_n_features_ = 0;
+      feature_detector_ = feature_detector;
+    }
+    feature_descriptor_ = feature_descriptor == feature_detector
+                              ? feature_detector_
+                              : feature_descriptor;
+  } else if (feature_detector->getDefaultName() !=
+                 feature_detector_->getDefaultName() ||
+             feature_descriptor->getDefaultName() !=
+                 feature_descriptor_->getDefaultName()) {
+    std::cerr << "Feature detector or descriptor of request " << name
+              << " differs from those used by feature cache " << name_
+              << std::endl;
+    return false;
+  }
+
+  // Add or replace request
+  Request request{name, body_ptr, focused_image_size};
+  if (request_it != end(requests_))
+    *request_it = std::move(request);
+  else
+    requests_.push_back(std::move(request));
+  request_data_[name] = RequestData{};
+  image_data_ = nullptr;
+  return true;
+}
+
+bool FeatureCache::DeleteRequest(const std::string &name) {
+  auto request_it{std::find_if(
+      begin(requests_), end(requests_),
+      [&](const Request &request) { return request.name == name; })};
+  if (request_it == end(requests_)) {
+    std::cerr << "Request " << name << " not found" << std::endl;
+    return false;
+  }
+  requests_.erase(request_it);
+  request_data_.erase(name);
+  image_data_ = nullptr;
+  return true;
+}
+
+void FeatureCache::ClearRequests() {
+  requests_.clear();
+  request_data_.clear();
+  image_data_ = nullptr;
+}
+
+bool FeatureCache::GetFeatures(const std::string &name,
+                               std::vector<cv::KeyPoint> *keypoints,
+                               cv::Mat *descriptors) {
+  if (!set_up_) {
+    std::cerr << "Set up feature cache " << name_ << " first" << std::endl;
+    return false;
+  }
+  if (request_data_.find(name) == end(request_data_)) {
+    std::cerr << "Request " << name << " not found" << std::endl;
+    return false;
+  }
+
+  if (IsNewImage()) DetectAndComputeFeatures();
+  const RequestData &data{request_data_[name]};
+  *keypoints = data.keypoints;
+  *descriptors = data.descriptors;
+  return data.valid;
+}
+
+const std::string &FeatureCache::name() const { return name_; }
+
+const std::shared_ptr<ColorCamera> &FeatureCache::color_camera_ptr() const {
+  return color_camera_ptr_;
+}
+
+const cv::Mat &FeatureCache::gray_image() const { return gray_image_; }
+
+bool FeatureCache::set_up() const { return set_up_; }
+
+bool FeatureCache::IsNewImage() const {
+  return color_camera_ptr_->image_index() != image_index_ ||
+         color_camera_ptr_->image().data != image_data_;
+}
+
+void FeatureCache::DetectAndComputeFeatures() {
+  image_index_ = color_camera_ptr_->image_index();
+  image_data_ = color_camera_ptr_->image().data;
+  cv::cvtColor(color_camera_ptr_->image(), gray_image_, cv::COLOR_BGR2GRAY);
+
+  // Assign regions of interest to pyramid levels
+  std::map<int, std::vector<std::string>> level_names;
+  for (const auto &request : requests_) {
+    RequestData &data{request_data_[request.name]};
+    data = RequestData{};
+    float scale;
+    if (!CalculateScaleAndRegionOfInterest(request, &data.region_of_interest,
+                                           &scale))
+      continue;
+    data.valid = true;
+    data.level = int(std::round(std::log2(scale)));
+    level_names[data.level].push_back(request.name);
+  }
+
+  for (const auto &[level, names] : level_names) {
+    // Merge overlapping regions of interest
+    std::vector<cv::Rect> regions;
+    std::vector<int> n_requests;
+    for (const auto &name : names) {
+      regions.push_back(request_data_[name].region_of_interest);
+      n_requests.push_back(1);
+    }
+    for (bool merged = true; merged;) {
+      merged = false;
+      for (size_t i = 0; i < regions.size() && !merged; ++i) {
+        for (size_t j = i + 1; j < regions.size() && !merged; ++j) {
+          if ((regions[i] & regions[j]).area() == 0) continue;
+          regions[i] |= regions[j];
+          n_requests[i] += n_requests[j];
+          regions.erase(begin(regions) + j);
+          n_requests.erase(begin(n_requests) + j);
+          merged = true;
+        }
+      }
+    }
+
+    // Detect features once per region and distribute them to requests
+    float scale = std::ldexp(1.0f, level);
+    for (size_t i = 0; i < regions.size(); ++i) {
+      std::vector<cv::KeyPoint> keypoints;
+      cv::Mat descriptors;
+      DetectAndComputeRegion(regions[i], scale, n_requests[i], &keypoints,
+                             &descriptors);
+      for (const auto &name : names) {
+        RequestData &data{request_data_[name]};
+        if ((data.region_of_interest & regions[i]) != data.region_of_interest)
+          continue;
+        cv::Rect2f region_of_interest{data.region_of_interest};
+        std::vector<int> indexes;
+        for (int idx = 0; idx < int(keypoints.size()); ++idx) {
+          if (region_of_interest.contains(keypoints[idx].pt))
+            indexes.push_back(idx);
+        }
+        data.keypoints.resize(indexes.size());
+        data.descriptors.create(int(indexes.size()), descriptors.cols,
+                                descriptors.type());
+        for (size_t j = 0; j < indexes.size(); ++j) {
+          data.keypoints[j] = keypoints[indexes[j]];
+          descriptors.row(indexes[j]).copyTo(data.descriptors.row(int(j)));
+        }
+      }
+    }
+  }
+}
+
+bool FeatureCache::CalculateScaleAndRegionOfInterest(
+    const Request &request, cv::Rect *region_of_interest, float *scale) const {
+  Transform3fA body2camera_pose{color_camera_ptr_->world2camera_pose() *
+                                request.body_ptr->body2world_pose()};
+  return m3t::CalculateScaleAndRegionOfInterest(
+      body2camera_pose, 0.5f * request.body_ptr->maximum_body_diameter(),
+      color_camera_ptr_->intrinsics(), request.focused_image_size,
+      kRegionOfInterestMargin, region_of_interest, scale);
+}
+
+void FeatureCache::DetectAndComputeRegion(const cv::Rect &region_of_interest,
+                                          float scale, int n_requests,
+                                          std::vector<cv::KeyPoint> *keypoints,
+                                          cv::Mat *descriptors) {
+  cv::Mat image;
+  cv::resize(gray_image_(region_of_interest), image, cv::Size(), scale, scale);
+
+  // Scale number of ORB features with the number of merged requests
+  if (orb_detector_)
+    orb_detector_->setMaxFeatures(orb_n_features_ * n_requests);
+  feature_detector_->detect(image, *keypoints);
+  feature_descriptor_->compute(image, *keypoints, *descriptors);
+
+  // Add focus offset to keypoints
+  for (auto &keypoint : *keypoints) {
+    keypoint.pt.x = region_of_interest.x + keypoint.pt.x / scale;
+    keypoint.pt.y = region_of_interest.y + keypoint.pt.y / scale;
+  }
+}
+
+}  // namespace m3t
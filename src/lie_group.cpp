@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/lie_group.h>
+
+namespace m3t {
+
+void ApplyAdjointSE3(
+    const Transform3fA &pose,
+    const Eigen::Ref<const Eigen::Matrix<float, 6, Eigen::Dynamic>> &variations,
+    Eigen::Ref<Eigen::Matrix<float, 6, Eigen::Dynamic>> result) {
+  const Eigen::Matrix3f rotation{pose.linear()};
+  const Eigen::Matrix3f translation_rotation{
+      Vector2Skewsymmetric(pose.translation()) * rotation};
+  for (int i = 0; i < int(variations.cols()); ++i) {
+    const Eigen::Vector3f rotation_variation{variations.col(i).head<3>()};
+    const Eigen::Vector3f translation_variation{variations.col(i).tail<3>()};
+    result.col(i).head<3>().noalias() = rotation * rotation_variation;
+    result.col(i).tail<3>().noalias() =
+        rotation * translation_variation +
+        translation_rotation * rotation_variation;
+  }
+}
+
+}  // namespace m3t
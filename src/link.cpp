@@ -28,6 +28,8 @@ Link::Link(const std::string &name, const std::filesystem::path &metafile_path,
 bool Link::SetUp() {
   set_up_ = false;
   jacobian_defined_ = false;
+  joint_jacobian_valid_ = false;
+  parent2body_pose_valid_ = false;
   if (!metafile_path_.empty())
     if (!LoadMetaData()) return false;
 
@@ -128,11 +130,14 @@ void Link::set_body_ptr(const std::shared_ptr<Body> &body_ptr) {
 void Link::set_body2joint_pose(const Transform3fA &body2joint_pose) {
   body2joint_pose_ = body2joint_pose;
   default_body2joint_pose_ = body2joint_pose;
+  joint_jacobian_valid_ = false;
+  parent2body_pose_valid_ = false;
 }
 
 void Link::set_joint2parent_pose(const Transform3fA &joint2parent_pose) {
   joint2parent_pose_ = joint2parent_pose;
   default_joint2parent_pose_ = joint2parent_pose;
+  parent2body_pose_valid_ = false;
 }
 
 void Link::set_link2world_pose(const Transform3fA &link2world_pose) {
@@ -150,7 +155,12 @@ void Link::set_fixed_body2joint_pose(bool fixed_body2joint_pose) {
 
 bool Link::DefineJacobian(int jacobian_size, int first_jacobian_index) {
   if (!IsSetup(false)) return false;
-  jacobian_.resize(Eigen::NoChange, jacobian_size);
+  if (first_jacobian_index < 0 ||
+      first_jacobian_index + DegreesOfFreedom() > jacobian_size) {
+    std::cerr << "Free directions of link " << name_
+              << " are not within jacobian" << std::endl;
+    return false;
+  }
   first_jacobian_index_ = first_jacobian_index;
   jacobian_defined_ = true;
   return true;
@@ -159,25 +169,58 @@ bool Link::DefineJacobian(int jacobian_size, int first_jacobian_index) {
 bool Link::CalculateJacobian(const std::shared_ptr<Link> &parent_link_ptr) {
   if (!IsSetup(true)) return false;
 
-  // project parent Jacobian
+  // Calculate joint Jacobian if the body2joint pose changed
+  if (!joint_jacobian_valid_) {
+    auto joint2body_pose{body2joint_pose_.inverse(Eigen::Isometry)};
+    auto dtheta_body_dtheta_joint{AdjointSE3(joint2body_pose)};
+    joint_jacobian_.resize(Eigen::NoChange, DegreesOfFreedom());
+    int joint_idx = 0;
+    for (int direction = 0; direction < 6; ++direction) {
+      if (free_directions_[direction]) {
+        joint_jacobian_.col(joint_idx) =
+            dtheta_body_dtheta_joint.col(direction);
+        joint_idx++;
+      }
+    }
+    joint_jacobian_valid_ = true;
+  }
+  int joint_idx = int(joint_jacobian_.cols());
+
+  // Project columns of parent Jacobian and append joint Jacobian
+  int n_parent_columns = 0;
   if (parent_link_ptr) {
-    auto parent2body_pose{(joint2parent_pose_ * body2joint_pose_).inverse()};
-    auto dtheta_body_dtheta_parent{Adjoint(parent2body_pose)};
-    jacobian_ = dtheta_body_dtheta_parent * parent_link_ptr->jacobian_;
+    if (!parent2body_pose_valid_) {
+      parent2body_pose_ =
+          (joint2parent_pose_ * body2joint_pose_).inverse(Eigen::Isometry);
+      parent2body_pose_valid_ = true;
+      parent_adjoint_valid_ = false;
+    }
+    n_parent_columns = int(parent_link_ptr->jacobian_.cols());
+    jacobian_blocks_ = parent_link_ptr->jacobian_blocks_;
+    jacobian_.resize(Eigen::NoChange, n_parent_columns + joint_idx);
+    ApplyAdjointSE3(parent2body_pose_, parent_link_ptr->jacobian_,
+                    jacobian_.leftCols(n_parent_columns));
   } else {
-    jacobian_.setZero();
+    parent_adjoint_.setZero();
+    parent_adjoint_valid_ = true;
+    parent2body_pose_valid_ = false;
+    jacobian_blocks_.clear();
+    jacobian_.resize(Eigen::NoChange, joint_idx);
   }
-
-  // Add joint Jacobian
-  auto joint2body_pose{body2joint_pose_.inverse()};
-  auto dtheta_body_dtheta_joint{Adjoint(joint2body_pose)};
-  int jacobian_idx = first_jacobian_index_;
-  for (int direction = 0; direction < 6; ++direction) {
-    if (free_directions_[direction]) {
-      jacobian_.col(jacobian_idx) = dtheta_body_dtheta_joint.col(direction);
-      jacobian_idx++;
+  jacobian_.rightCols(joint_idx) = joint_jacobian_;
+
+  // Extend last block if free directions directly follow those of the parent
+  if (!joint_idx) return true;
+  if (!jacobian_blocks_.empty()) {
+    auto &last_block{jacobian_blocks_.back()};
+    if (last_block.first_jacobian_index + last_block.n_columns ==
+        first_jacobian_index_) {
+      last_block.n_columns += joint_idx;
+      return true;
     }
   }
+  jacobian_blocks_.push_back({first_jacobian_index_, n_parent_columns,
+                              joint_idx});
   return true;
 }
 
@@ -203,46 +246,47 @@ bool Link::AddToGradientAndHessian(
 }
 
 bool Link::UpdatePoses(const std::shared_ptr<Link> &parent_link_ptr,
-                       Eigen::VectorXf theta) {
+                       const Eigen::VectorXf &theta) {
   if (!IsSetup(true)) return false;
+  return ApplyJointVariation(parent_link_ptr, JointVariation(theta));
+}
 
-  // Extract variation vector for link
-  Eigen::Matrix<float, 6, 1> theta_link;
-  int jacobian_idx = first_jacobian_index_;
-  for (int direction = 0; direction < 6; ++direction) {
-    if (free_directions_[direction]) {
-      theta_link(direction) = theta(jacobian_idx);
-      jacobian_idx++;
-    } else {
-      theta_link(direction) = 0.0f;
-    }
-  }
+bool Link::ApplyJointVariation(
+    const std::shared_ptr<Link> &parent_link_ptr,
+    const Eigen::Matrix<float, 6, 1> &joint_variation) {
+  if (!IsSetup(true)) return false;
+  ApplyPoseVariation(parent_link_ptr, PoseVariation(joint_variation));
+  return true;
+}
 
-  // Calculate pose variation
-  Transform3fA pose_variation{Transform3fA::Identity()};
-  pose_variation.translate(theta_link.tail<3>());
-  pose_variation.rotate(Vector2Skewsymmetric(theta_link.head<3>()).exp());
+bool Link::RevertPoses(const std::shared_ptr<Link> &parent_link_ptr,
+                       const Eigen::VectorXf &theta) {
+  if (!IsSetup(true)) return false;
+  return RevertJointVariation(parent_link_ptr, JointVariation(theta));
+}
 
-  // Update poses
-  if (parent_link_ptr) {
-    if (fixed_body2joint_pose_)
-      joint2parent_pose_ = joint2parent_pose_ * pose_variation;
-    else
-      body2joint_pose_ = pose_variation * body2joint_pose_;
-    link2world_pose_ = parent_link_ptr->link2world_pose() * joint2parent_pose_ *
-                       body2joint_pose_;
-    if (body_ptr_) body_ptr_->set_body2world_pose(link2world_pose_);
-  } else {
-    link2world_pose_ = link2world_pose() * body2joint_pose_.inverse() *
-                       pose_variation * body2joint_pose_;
-    if (body_ptr_) body_ptr_->set_body2world_pose(link2world_pose_);
-  }
+bool Link::RevertJointVariation(
+    const std::shared_ptr<Link> &parent_link_ptr,
+    const Eigen::Matrix<float, 6, 1> &joint_variation) {
+  if (!IsSetup(true)) return false;
+  ApplyPoseVariation(parent_link_ptr,
+                     PoseVariation(joint_variation).inverse(Eigen::Isometry));
   return true;
 }
 
 void Link::ResetJointPoses() {
   body2joint_pose_ = default_body2joint_pose_;
   joint2parent_pose_ = default_joint2parent_pose_;
+  joint_jacobian_valid_ = false;
+  parent2body_pose_valid_ = false;
+}
+
+void Link::SetJointPoses(const Transform3fA &body2joint_pose,
+                         const Transform3fA &joint2parent_pose) {
+  body2joint_pose_ = body2joint_pose;
+  joint2parent_pose_ = joint2parent_pose;
+  joint_jacobian_valid_ = false;
+  parent2body_pose_valid_ = false;
 }
 
 int Link::DegreesOfFreedom() const {
@@ -257,6 +301,23 @@ const Eigen::Matrix<float, 6, Eigen::Dynamic> &Link::jacobian() {
   return jacobian_;
 }
 
+const std::vector<Link::JacobianBlock> &Link::jacobian_blocks() {
+  return jacobian_blocks_;
+}
+
+const Eigen::Matrix<float, 6, 6> &Link::parent_adjoint() {
+  if (!parent_adjoint_valid_) {
+    parent_adjoint_ = AdjointSE3(parent2body_pose_);
+    parent_adjoint_valid_ = true;
+  }
+  return parent_adjoint_;
+}
+
+const Eigen::Matrix<float, 6, Eigen::Dynamic, 0, 6, 6>
+    &Link::joint_jacobian() {
+  return joint_jacobian_;
+}
+
 const std::string &Link::name() const { return name_; }
 
 const std::filesystem::path &Link::metafile_path() const {
@@ -338,13 +399,49 @@ bool Link::IsSetup(bool check_jacobian_defined) {
   return true;
 }
 
-Eigen::Matrix<float, 6, 6> Link::Adjoint(const Transform3fA &pose) {
-  Eigen::Matrix<float, 6, 6> m{Eigen::Matrix<float, 6, 6>::Zero()};
-  m.topLeftCorner<3, 3>() = pose.rotation();
-  m.bottomLeftCorner<3, 3>() =
-      Vector2Skewsymmetric(pose.translation()) * pose.rotation();
-  m.bottomRightCorner<3, 3>() = pose.rotation();
-  return m;
+Eigen::Matrix<float, 6, 1> Link::JointVariation(
+    const Eigen::VectorXf &theta) const {
+  Eigen::Matrix<float, 6, 1> joint_variation;
+  int jacobian_idx = first_jacobian_index_;
+  for (int direction = 0; direction < 6; ++direction) {
+    if (free_directions_[direction]) {
+      joint_variation(direction) = theta(jacobian_idx);
+      jacobian_idx++;
+    } else {
+      joint_variation(direction) = 0.0f;
+    }
+  }
+  return joint_variation;
+}
+
+Transform3fA Link::PoseVariation(
+    const Eigen::Matrix<float, 6, 1> &joint_variation) {
+  Transform3fA pose_variation{Transform3fA::Identity()};
+  pose_variation.translate(joint_variation.tail<3>());
+  pose_variation.rotate(ExpSO3(joint_variation.head<3>()));
+  return pose_variation;
+}
+
+void Link::ApplyPoseVariation(const std::shared_ptr<Link> &parent_link_ptr,
+                              const Transform3fA &pose_variation) {
+  // Update poses and keep cached adjoints if joint poses do not change
+  if (parent_link_ptr) {
+    if (!pose_variation.matrix().isIdentity(0.0f)) {
+      if (fixed_body2joint_pose_) {
+        joint2parent_pose_ = joint2parent_pose_ * pose_variation;
+      } else {
+        body2joint_pose_ = pose_variation * body2joint_pose_;
+        joint_jacobian_valid_ = false;
+      }
+      parent2body_pose_valid_ = false;
+    }
+    link2world_pose_ = parent_link_ptr->link2world_pose() * joint2parent_pose_ *
+                       body2joint_pose_;
+  } else {
+    link2world_pose_ = link2world_pose() * body2joint_pose_.inverse() *
+                       pose_variation * body2joint_pose_;
+  }
+  if (body_ptr_) body_ptr_->set_body2world_pose(link2world_pose_);
 }
 
 }  // namespace m3t
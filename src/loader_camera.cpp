@@ -93,6 +93,7 @@ bool LoaderColorCamera::UpdateImage(bool synchronized) {
   }
 
   load_index_++;
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
@@ -242,6 +243,7 @@ bool LoaderDepthCamera::UpdateImage(bool synchronized) {
   }
 
   load_index_++;
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/mesh_simplification.h>
+
+namespace m3t {
+
+void MeshSimplifier::Simplify(
+    const std::vector<Eigen::Vector3f> &vertices,
+    const std::vector<std::array<int, 3>> &mesh_indices,
+    const std::vector<int> &target_n_triangles,
+    std::vector<LODMesh> *lod_meshes) {
+  lod_meshes->clear();
+  Initialize(vertices, mesh_indices);
+  InitializeQuadrics();
+  InitializeCollapses();
+
+  // Collapse edges and store meshes whenever a target is reached
+  double max_cost = 0.0;
+  size_t target_idx = 0;
+  while (target_idx < target_n_triangles.size()) {
+    if (n_triangles_ <= target_n_triangles[target_idx]) {
+      lod_meshes->emplace_back();
+      ExtractMesh(float(std::sqrt(max_cost)), &lod_meshes->back());
+      ++target_idx;
+      continue;
+    }
+    if (collapses_.empty()) break;
+    Collapse collapse{collapses_.top()};
+    collapses_.pop();
+    if (collapse.version_1 != versions_[collapse.vertex_1] ||
+        collapse.version_2 != versions_[collapse.vertex_2])
+      continue;
+    if (!IsCollapseValid(collapse)) continue;
+    max_cost = std::max(max_cost, collapse.cost);
+    ApplyCollapse(collapse);
+  }
+  collapses_ = {};
+}
+
+void MeshSimplifier::Initialize(
+    const std::vector<Eigen::Vector3f> &vertices,
+    const std::vector<std::array<int, 3>> &mesh_indices) {
+  // Merge vertices with identical positions
+  std::map<std::array<float, 3>, int> position_indices;
+  std::vector<int> vertex_indices(vertices.size());
+  positions_.clear();
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    std::array<float, 3> key{vertices[i](0), vertices[i](1), vertices[i](2)};
+    auto result{position_indices.insert({key, int(positions_.size())})};
+    if (result.second) positions_.push_back(vertices[i].cast<double>());
+    vertex_indices[i] = result.first->second;
+  }
+
+  // Assign triangles and skip degenerate ones
+  triangles_.clear();
+  vertex_triangles_.assign(positions_.size(), std::vector<int>{});
+  for (const auto &triangle_indices : mesh_indices) {
+    std::array<int, 3> triangle{vertex_indices[triangle_indices[0]],
+                                vertex_indices[triangle_indices[1]],
+                                vertex_indices[triangle_indices[2]]};
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+        triangle[2] == triangle[0])
+      continue;
+    for (int vertex : triangle)
+      vertex_triangles_[vertex].push_back(int(triangles_.size()));
+    triangles_.push_back(triangle);
+  }
+  triangle_removed_.assign(triangles_.size(), false);
+  versions_.assign(positions_.size(), 0);
+  n_triangles_ = int(triangles_.size());
+}
+
+void MeshSimplifier::InitializeQuadrics() {
+  quadrics_.assign(positions_.size(), Quadric::Zero());
+  std::map<std::pair<int, int>, std::pair<int, int>> edge_counts_triangles;
+  for (int t = 0; t < int(triangles_.size()); ++t) {
+    const auto &triangle{triangles_[t]};
+    Eigen::Vector3d normal{
+        (positions_[triangle[1]] - positions_[triangle[0]])
+            .cross(positions_[triangle[2]] - positions_[triangle[0]])};
+    if (normal.isZero(0.0)) continue;
+    Eigen::Vector4d plane{Plane(normal.normalized(), positions_[triangle[0]])};
+    Quadric quadric{plane * plane.transpose()};
+    for (int i = 0; i < 3; ++i) {
+      quadrics_[triangle[i]] += quadric;
+      int vertex_1 = triangle[i];
+      int vertex_2 = triangle[(i + 1) % 3];
+      auto &count_triangle{edge_counts_triangles[{
+          std::min(vertex_1, vertex_2), std::max(vertex_1, vertex_2)}]};
+      count_triangle.first++;
+      count_triangle.second = t;
+    }
+  }
+
+  // Add planes perpendicular to boundary edges
+  for (const auto &[edge, count_triangle] : edge_counts_triangles) {
+    if (count_triangle.first != 1) continue;
+    const auto &triangle{triangles_[count_triangle.second]};
+    Eigen::Vector3d normal{
+        (positions_[triangle[1]] - positions_[triangle[0]])
+            .cross(positions_[triangle[2]] - positions_[triangle[0]])};
+    Eigen::Vector3d boundary_normal{
+        (positions_[edge.second] - positions_[edge.first]).cross(normal)};
+    if (boundary_normal.isZero(0.0)) continue;
+    Eigen::Vector4d plane{
+        Plane(boundary_normal.normalized(), positions_[edge.first])};
+    Quadric quadric{kBoundaryWeight * plane * plane.transpose()};
+    quadrics_[edge.first] += quadric;
+    quadrics_[edge.second] += quadric;
+  }
+}
+
+void MeshSimplifier::InitializeCollapses() {
+  collapses_ = {};
+  for (int vertex_1 = 0; vertex_1 < int(positions_.size()); ++vertex_1) {
+    std::vector<int> neighbors;
+    for (int t : vertex_triangles_[vertex_1]) {
+      for (int vertex_2 : triangles_[t])
+        if (vertex_2 > vertex_1) neighbors.push_back(vertex_2);
+    }
+    std::sort(begin(neighbors), end(neighbors));
+    neighbors.erase(std::unique(begin(neighbors), end(neighbors)),
+                    end(neighbors));
+    for (int vertex_2 : neighbors) PushCollapse(vertex_1, vertex_2);
+  }
+}
+
+void MeshSimplifier::PushCollapse(int vertex_1, int vertex_2) {
+  Quadric quadric{quadrics_[vertex_1] + quadrics_[vertex_2]};
+  auto cost = [&](const Eigen::Vector3d &position) {
+    return position.homogeneous().dot(quadric * position.homogeneous());
+  };
+
+  // Use optimal position if it lies close to the edge
+  const Eigen::Vector3d &position_1{positions_[vertex_1]};
+  const Eigen::Vector3d &position_2{positions_[vertex_2]};
+  Eigen::Vector3d midpoint{0.5 * (position_1 + position_2)};
+  Eigen::FullPivLU<Eigen::Matrix3d> lu{quadric.topLeftCorner<3, 3>()};
+  Collapse collapse;
+  bool optimal_position_found = false;
+  if (lu.isInvertible()) {
+    collapse.position = lu.solve(-quadric.topRightCorner<3, 1>());
+    optimal_position_found = (collapse.position - midpoint).squaredNorm() <=
+                             (position_2 - position_1).squaredNorm();
+  }
+  if (!optimal_position_found) {
+    collapse.position = midpoint;
+    if (cost(position_1) < cost(collapse.position))
+      collapse.position = position_1;
+    if (cost(position_2) < cost(collapse.position))
+      collapse.position = position_2;
+  }
+  collapse.cost = std::max(cost(collapse.position), 0.0);
+  collapse.vertex_1 = vertex_1;
+  collapse.vertex_2 = vertex_2;
+  collapse.version_1 = versions_[vertex_1];
+  collapse.version_2 = versions_[vertex_2];
+  collapses_.push(std::move(collapse));
+}
+
+bool MeshSimplifier::IsCollapseValid(const Collapse &collapse) const {
+  int vertex_1 = collapse.vertex_1;
+  int vertex_2 = collapse.vertex_2;
+
+  // Check that common neighbors only belong to triangles of the edge
+  std::array<std::vector<int>, 2> neighbors;
+  int n_edge_triangles = 0;
+  for (int i = 0; i < 2; ++i) {
+    int vertex = i == 0 ? vertex_1 : vertex_2;
+    for (int t : vertex_triangles_[vertex]) {
+      if (triangle_removed_[t]) continue;
+      const auto &triangle{triangles_[t]};
+      bool edge_triangle =
+          Contains(triangle, vertex_1) && Contains(triangle, vertex_2);
+      if (edge_triangle && i == 0) n_edge_triangles++;
+      for (int neighbor : triangle)
+        if (neighbor != vertex_1 && neighbor != vertex_2)
+          neighbors[i].push_back(neighbor);
+    }
+    std::sort(begin(neighbors[i]), end(neighbors[i]));
+    neighbors[i].erase(std::unique(begin(neighbors[i]), end(neighbors[i])),
+                       end(neighbors[i]));
+  }
+  if (n_edge_triangles == 0) return false;
+  std::vector<int> common_neighbors;
+  std::set_intersection(begin(neighbors[0]), end(neighbors[0]),
+                        begin(neighbors[1]), end(neighbors[1]),
+                        std::back_inserter(common_neighbors));
+  if (int(common_neighbors.size()) != n_edge_triangles) return false;
+
+  // Check that remaining triangles do not flip or degenerate
+  for (int vertex : {vertex_1, vertex_2}) {
+    for (int t : vertex_triangles_[vertex]) {
+      if (triangle_removed_[t]) continue;
+      const auto &triangle{triangles_[t]};
+      std::array<Eigen::Vector3d, 3> points;
+      std::array<Eigen::Vector3d, 3> new_points;
+      bool edge_triangle = false;
+      for (int i = 0; i < 3; ++i) {
+        points[i] = positions_[triangle[i]];
+        new_points[i] = points[i];
+        if (triangle[i] == vertex_1 || triangle[i] == vertex_2) {
+          edge_triangle |= triangle[i] != vertex;
+          new_points[i] = collapse.position;
+        }
+      }
+      if (edge_triangle) continue;
+      Eigen::Vector3d normal{
+          (points[1] - points[0]).cross(points[2] - points[0])};
+      Eigen::Vector3d new_normal{
+          (new_points[1] - new_points[0]).cross(new_points[2] - new_points[0])};
+      if (new_normal.isZero(0.0) || normal.dot(new_normal) <= 0.0)
+        return false;
+    }
+  }
+  return true;
+}
+
+void MeshSimplifier::ApplyCollapse(const Collapse &collapse) {
+  int vertex_1 = collapse.vertex_1;
+  int vertex_2 = collapse.vertex_2;
+  positions_[vertex_1] = collapse.position;
+  quadrics_[vertex_1] += quadrics_[vertex_2];
+  versions_[vertex_1]++;
+  versions_[vertex_2]++;
+
+  // Remove triangles of the edge and move remaining ones to vertex 1
+  for (int t : vertex_triangles_[vertex_2]) {
+    if (triangle_removed_[t]) continue;
+    auto &triangle{triangles_[t]};
+    if (Contains(triangle, vertex_1)) {
+      triangle_removed_[t] = true;
+      n_triangles_--;
+    } else {
+      std::replace(begin(triangle), end(triangle), vertex_2, vertex_1);
+      vertex_triangles_[vertex_1].push_back(t);
+    }
+  }
+  vertex_triangles_[vertex_2].clear();
+  auto &triangles_1{vertex_triangles_[vertex_1]};
+  triangles_1.erase(
+      std::remove_if(begin(triangles_1), end(triangles_1),
+                     [&](int t) { return bool(triangle_removed_[t]); }),
+      end(triangles_1));
+
+  // Update collapses of all edges that are connected to vertex 1
+  std::vector<int> neighbors;
+  for (int t : triangles_1) {
+    for (int neighbor : triangles_[t])
+      if (neighbor != vertex_1) neighbors.push_back(neighbor);
+  }
+  std::sort(begin(neighbors), end(neighbors));
+  neighbors.erase(std::unique(begin(neighbors), end(neighbors)),
+                  end(neighbors));
+  for (int neighbor : neighbors) PushCollapse(vertex_1, neighbor);
+}
+
+void MeshSimplifier::ExtractMesh(float geometric_error,
+                                 LODMesh *lod_mesh) const {
+  std::vector<int> new_indices(positions_.size(), -1);
+  lod_mesh->vertices.clear();
+  lod_mesh->mesh_indices.clear();
+  lod_mesh->mesh_indices.reserve(n_triangles_);
+  for (size_t t = 0; t < triangles_.size(); ++t) {
+    if (triangle_removed_[t]) continue;
+    std::array<int, 3> triangle_indices;
+    for (int i = 0; i < 3; ++i) {
+      int &new_index{new_indices[triangles_[t][i]]};
+      if (new_index == -1) {
+        new_index = int(lod_mesh->vertices.size());
+        lod_mesh->vertices.push_back(
+            positions_[triangles_[t][i]].cast<float>());
+      }
+      triangle_indices[i] = new_index;
+    }
+    lod_mesh->mesh_indices.push_back(triangle_indices);
+  }
+  lod_mesh->geometric_error = geometric_error;
+}
+
+bool MeshSimplifier::Contains(const std::array<int, 3> &triangle,
+                              int vertex) {
+  return triangle[0] == vertex || triangle[1] == vertex ||
+         triangle[2] == vertex;
+}
+
+Eigen::Vector4d MeshSimplifier::Plane(const Eigen::Vector3d &normal,
+                                      const Eigen::Vector3d &point) {
+  return Eigen::Vector4d{normal(0), normal(1), normal(2), -normal.dot(point)};
+}
+
+}  // namespace m3t
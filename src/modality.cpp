@@ -45,6 +45,11 @@ void Modality::StartSavingVisualizations(
 
 void Modality::StopSavingVisualizations() { save_visualizations_ = false; }
 
+bool Modality::CalculateScore(float *score) {
+  *score = 0.0f;
+  return true;
+}
+
 const Eigen::Matrix<float, 6, 1> &Modality::gradient() const {
   return gradient_;
 }
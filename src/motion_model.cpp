@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/motion_model.h>
+
+namespace m3t {
+
+void MotionModel::Reset() {
+  pose_valid_ = false;
+  velocity_valid_ = false;
+  velocity_.setZero();
+  velocity_variance_.setZero();
+}
+
+void MotionModel::Update(const Transform3fA &pose, double timestamp) {
+  if (pose_valid_) {
+    float time_step = TimeStep(timestamp);
+    Eigen::Matrix<float, 6, 1> measured_velocity{
+        LogSE3(pose_.inverse(Eigen::Isometry) * pose) / time_step};
+    if (!use_kalman_filter_ || !velocity_valid_) {
+      velocity_ = measured_velocity;
+      velocity_variance_.setConstant(measurement_noise_);
+    } else {
+      velocity_variance_.array() += process_noise_ * time_step;
+      Eigen::Array<float, 6, 1> gain{
+          velocity_variance_.array() /
+          (velocity_variance_.array() + measurement_noise_)};
+      velocity_.array() += gain * (measured_velocity - velocity_).array();
+      velocity_variance_.array() *= 1.0f - gain;
+    }
+    velocity_valid_ = true;
+  }
+  pose_ = pose;
+  timestamp_ = timestamp;
+  pose_valid_ = true;
+}
+
+bool MotionModel::Predict(double timestamp, Transform3fA *pose) const {
+  if (!velocity_valid_) return false;
+  *pose = pose_ * ExpSE3(velocity_ * TimeStep(timestamp));
+  return true;
+}
+
+void MotionModel::set_use_kalman_filter(bool use_kalman_filter) {
+  use_kalman_filter_ = use_kalman_filter;
+}
+
+void MotionModel::set_process_noise(float process_noise) {
+  process_noise_ = process_noise;
+}
+
+void MotionModel::set_measurement_noise(float measurement_noise) {
+  measurement_noise_ = measurement_noise;
+}
+
+bool MotionModel::use_kalman_filter() const { return use_kalman_filter_; }
+
+float MotionModel::process_noise() const { return process_noise_; }
+
+float MotionModel::measurement_noise() const { return measurement_noise_; }
+
+const Eigen::Matrix<float, 6, 1> &MotionModel::velocity() const {
+  return velocity_;
+}
+
+bool MotionModel::velocity_valid() const { return velocity_valid_; }
+
+float MotionModel::TimeStep(double timestamp) const {
+  double time_step = timestamp - timestamp_;
+  if (time_step <= 0.0) return 1.0f;
+  return float(time_step);
+}
+
+}  // namespace m3t
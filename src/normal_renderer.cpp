@@ -13,12 +13,18 @@ std::string NormalRendererCore::vertex_shader_code_ =
     "layout(location = 0) in vec3 aPos;\n"
     "layout(location = 1) in vec3 aNormal;\n"
     "flat out vec3 Normal;\n"
-    "uniform mat4 Trans;\n"
-    "uniform mat3 Rot;\n"
+    "out float Depth;\n"
+    "uniform mat4 Trans[" +
+    std::to_string(kMaxNInstances) +
+    "];\n"
+    "uniform mat3 Rot[" +
+    std::to_string(kMaxNInstances) +
+    "];\n"
     "void main()\n"
     "{\n"
-    "  gl_Position = Trans * vec4(aPos, 1.0);\n"
-    "  Normal = Rot * aNormal;\n"
+    "  gl_Position = Trans[gl_InstanceID] * vec4(aPos, 1.0);\n"
+    "  Normal = Rot[gl_InstanceID] * aNormal;\n"
+    "  Depth = gl_Position.w;\n"
     "}";
 
 std::string NormalRendererCore::fragment_shader_code_ =
@@ -30,27 +36,58 @@ std::string NormalRendererCore::fragment_shader_code_ =
     "	 FragColor = vec4(0.5 - 0.5 * Normal, 1.0).zyxw;\n"
     "}";
 
+std::string NormalRendererCore::linear_fragment_shader_code_ =
+    "#version 330 core\n"
+    "flat in vec3 Normal;\n"
+    "in float Depth;\n"
+    "uniform float ZMin;\n"
+    "uniform float ZMax;\n"
+    "layout(location = 0) out vec4 FragColor;\n"
+    "layout(location = 1) out float LinearDepth;\n"
+    "void main()\n"
+    "{\n"
+    "  FragColor = vec4(0.5 - 0.5 * Normal, 1.0).zyxw;\n"
+    "  LinearDepth = (Depth - ZMin) / (ZMax - ZMin);\n"
+    "}";
+
 NormalRendererCore::~NormalRendererCore() {
   if (initial_set_up_) DeleteBufferObjects();
 }
 
 bool NormalRendererCore::SetUp(
     const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-    int image_width, int image_height) {
+    int image_width, int image_height, bool use_pixel_buffer_readback,
+    int context_id, bool use_linear_depth, float lod_max_pixel_error) {
+  if (context_id < 0 || context_id >= renderer_geometry_ptr->n_contexts()) {
+    std::cerr << "Context " << context_id << " of renderer geometry "
+              << renderer_geometry_ptr->name() << " does not exist"
+              << std::endl;
+    return false;
+  }
+  if (initial_set_up_) DeleteBufferObjects();
   renderer_geometry_ptr_ = renderer_geometry_ptr;
   image_width_ = image_width;
   image_height_ = image_height;
+  use_pixel_buffer_readback_ = use_pixel_buffer_readback;
+  context_id_ = context_id;
+  use_linear_depth_ = use_linear_depth;
+  lod_max_pixel_error_ = lod_max_pixel_error;
   image_rendered_ = false;
 
-  // Create shader program
+  // Create shader programs
   if (!initial_set_up_ &&
       !CreateShaderProgram(renderer_geometry_ptr_.get(),
                            vertex_shader_code_.c_str(),
                            fragment_shader_code_.c_str(), &shader_program_))
     return false;
+  if (use_linear_depth_ && !linear_shader_program_ &&
+      !CreateShaderProgram(renderer_geometry_ptr_.get(),
+                           vertex_shader_code_.c_str(),
+                           linear_fragment_shader_code_.c_str(),
+                           &linear_shader_program_))
+    return false;
 
   // Create buffer objects
-  if (initial_set_up_) DeleteBufferObjects();
   CreateBufferObjects();
   initial_set_up_ = true;
   return true;
@@ -60,42 +97,68 @@ bool NormalRendererCore::StartRendering(
     const Eigen::Matrix4f &projection_matrix,
     const Transform3fA &world2camera_pose) {
   if (!initial_set_up_) return false;
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glViewport(0, 0, image_width_, image_height_);
 
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if (use_linear_depth_) {
+    const float linear_depth_clear_value = 1.0f;
+    glClearBufferfv(GL_COLOR, 1, &linear_depth_clear_value);
+  }
   glEnable(GL_DEPTH_TEST);
   glFrontFace(GL_CCW);
   glCullFace(GL_FRONT);
 
-  glUseProgram(shader_program_);
-  for (const auto &render_data_body :
-       renderer_geometry_ptr_->render_data_bodies()) {
-    Transform3fA trans_without_projection{
-        world2camera_pose * render_data_body.body_ptr->geometry2world_pose()};
-    Eigen::Matrix4f trans{projection_matrix *
-                          trans_without_projection.matrix()};
-    Eigen::Matrix3f rot{trans_without_projection.rotation().matrix()};
+  unsigned shader_program =
+      use_linear_depth_ ? linear_shader_program_ : shader_program_;
+  glUseProgram(shader_program);
+  if (use_linear_depth_)
+    SetLinearDepthUniforms(shader_program, projection_matrix);
+  float focal_length = 0.5f * projection_matrix(0, 0) * float(image_width_);
+  AssignInstanceGroups(renderer_geometry_ptr_->render_data_bodies(),
+                       world2camera_pose, focal_length, lod_max_pixel_error_,
+                       &instance_groups_);
+  for (const auto &instance_group : instance_groups_) {
+    int n_instances = int(instance_group.body_ptrs.size());
+    for (int i = 0; i < n_instances; ++i) {
+      Transform3fA trans_without_projection{
+          world2camera_pose *
+          instance_group.body_ptrs[i]->geometry2world_pose()};
+      transs_[i] = projection_matrix * trans_without_projection.matrix();
+      rots_[i] = trans_without_projection.rotation().matrix();
+    }
 
     unsigned loc;
-    loc = glGetUniformLocation(shader_program_, "Trans");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, trans.data());
-    loc = glGetUniformLocation(shader_program_, "Rot");
-    glUniformMatrix3fv(loc, 1, GL_FALSE, rot.data());
+    loc = glGetUniformLocation(shader_program, "Trans");
+    glUniformMatrix4fv(loc, n_instances, GL_FALSE, transs_[0].data());
+    loc = glGetUniformLocation(shader_program, "Rot");
+    glUniformMatrix3fv(loc, n_instances, GL_FALSE, rots_[0].data());
 
-    if (render_data_body.body_ptr->geometry_enable_culling())
+    if (instance_group.enable_culling)
       glEnable(GL_CULL_FACE);
     else
       glDisable(GL_CULL_FACE);
 
-    glBindVertexArray(render_data_body.vao);
-    glDrawArrays(GL_TRIANGLES, 0, render_data_body.n_vertices);
+    const auto &render_data_body{*instance_group.render_data_body_ptr};
+    int lod_level = instance_group.lod_level;
+    glBindVertexArray(render_data_body.context_vao(context_id_));
+    glDrawArraysInstanced(GL_TRIANGLES,
+                          render_data_body.first_vertex(lod_level),
+                          render_data_body.vertex_count(lod_level),
+                          n_instances);
     glBindVertexArray(0);
   }
+  if (use_pixel_buffer_readback_) {
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    normal_reader_.StartReadback(GL_BGRA, GL_UNSIGNED_BYTE);
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT1);
+    depth_reader_.StartReadback(
+        use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT);
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 
   image_rendered_ = true;
   normal_image_fetched_ = false;
@@ -106,17 +169,24 @@ bool NormalRendererCore::StartRendering(
 bool NormalRendererCore::FetchNormalImage(cv::Mat *normal_image) {
   if (!initial_set_up_ || !image_rendered_) return false;
   if (normal_image_fetched_) return true;
-  renderer_geometry_ptr_->MakeContextCurrent();
-  glPixelStorei(GL_PACK_ALIGNMENT, (normal_image->step & 3) ? 1 : 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH,
-                GLint(normal_image->step / normal_image->elemSize()));
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-  glBindRenderbuffer(GL_RENDERBUFFER, rbo_normal_);
-  glReadPixels(0, 0, image_width_, image_height_, GL_BGRA, GL_UNSIGNED_BYTE,
-               normal_image->data);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  bool fetched = true;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
+  if (use_pixel_buffer_readback_) {
+    fetched = normal_reader_.Fetch(normal_image);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, (normal_image->step & 3) ? 1 : 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH,
+                  GLint(normal_image->step / normal_image->elemSize()));
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_normal_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, image_width_, image_height_, GL_BGRA, GL_UNSIGNED_BYTE,
+                 normal_image->data);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
+  if (!fetched) return false;
   normal_image_fetched_ = true;
   return true;
 }
@@ -124,23 +194,31 @@ bool NormalRendererCore::FetchNormalImage(cv::Mat *normal_image) {
 bool NormalRendererCore::FetchDepthImage(cv::Mat *depth_image) {
   if (!initial_set_up_ || !image_rendered_) return false;
   if (depth_image_fetched_) return true;
-  renderer_geometry_ptr_->MakeContextCurrent();
-  glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH,
-                GLint(depth_image->step / depth_image->elemSize()));
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-  glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-  glReadPixels(0, 0, image_width_, image_height_, GL_DEPTH_COMPONENT,
-               GL_UNSIGNED_SHORT, depth_image->data);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  bool fetched = true;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
+  if (use_pixel_buffer_readback_) {
+    fetched = depth_reader_.Fetch(depth_image);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH,
+                  GLint(depth_image->step / depth_image->elemSize()));
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(0, 0, image_width_, image_height_,
+                 use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT,
+                 GL_UNSIGNED_SHORT, depth_image->data);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
+  if (!fetched) return false;
   depth_image_fetched_ = true;
   return true;
 }
 
 void NormalRendererCore::CreateBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
 
   // Initialize renderbuffer bodies_render_data
   glGenRenderbuffers(1, &rbo_normal_);
@@ -148,12 +226,24 @@ void NormalRendererCore::CreateBufferObjects() {
   glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, image_width_, image_height_);
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
+  // Linear depth is written to a second color attachment and the depth
+  // attachment is only used for depth tests
   glGenRenderbuffers(1, &rbo_depth_);
   glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, image_width_,
-                        image_height_);
+  glRenderbufferStorage(
+      GL_RENDERBUFFER,
+      use_linear_depth_ ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16,
+      image_width_, image_height_);
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
+  if (use_linear_depth_) {
+    glGenRenderbuffers(1, &rbo_linear_depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_linear_depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R16, image_width_,
+                          image_height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
   // Initialize framebuffer bodies_render_data
   glGenFramebuffers(1, &fbo_);
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
@@ -161,16 +251,32 @@ void NormalRendererCore::CreateBufferObjects() {
                             GL_RENDERBUFFER, rbo_normal_);
   glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                             GL_RENDERBUFFER, rbo_depth_);
+  if (use_linear_depth_) {
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+                              GL_RENDERBUFFER, rbo_linear_depth_);
+    const GLenum draw_buffers[]{GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, draw_buffers);
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+
+  // Initialize pixel buffer objects for asynchronous readback
+  if (use_pixel_buffer_readback_) {
+    normal_reader_.Create(image_width_, image_height_, 4);
+    depth_reader_.Create(image_width_, image_height_, 2);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 void NormalRendererCore::DeleteBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glDeleteRenderbuffers(1, &rbo_normal_);
   glDeleteRenderbuffers(1, &rbo_depth_);
+  glDeleteRenderbuffers(1, &rbo_linear_depth_);
+  rbo_linear_depth_ = 0;
   glDeleteFramebuffers(1, &fbo_);
-  renderer_geometry_ptr_->DetachContext();
+  normal_reader_.Delete();
+  depth_reader_.Delete();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 FullNormalRenderer::FullNormalRenderer(
@@ -216,7 +322,8 @@ bool FullNormalRenderer::SetUp() {
   ClearDepthImage();
   ClearNormalImage();
   if (!core_.SetUp(renderer_geometry_ptr_, intrinsics_.width,
-                   intrinsics_.height))
+                   intrinsics_.height, use_pixel_buffer_readback_, context_id_,
+                   use_linear_depth_, lod_max_pixel_error_))
     return false;
 
   set_up_ = true;
@@ -282,6 +389,11 @@ bool FullNormalRenderer::LoadMetaData() {
   // Read parameters from yaml
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
   fs.release();
   return true;
 }
@@ -351,7 +463,10 @@ bool FocusedNormalRenderer::SetUp() {
   CalculateProjectionTerms();
   ClearDepthImage();
   ClearNormalImage();
-  if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_))
+  render_cache_valid_ = false;
+  if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_,
+                   use_pixel_buffer_readback_, context_id_, use_linear_depth_,
+                   lod_max_pixel_error_))
     return false;
 
   set_up_ = true;
@@ -364,8 +479,12 @@ bool FocusedNormalRenderer::StartRendering() {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (IsRenderCacheValid()) return true;
   CalculateProjectionMatrix();
-  return core_.StartRendering(projection_matrix_, world2camera_pose_);
+  if (!core_.StartRendering(projection_matrix_, world2camera_pose_))
+    return false;
+  UpdateRenderCache();
+  return true;
 }
 
 bool FocusedNormalRenderer::FetchNormalImage() {
@@ -422,7 +541,14 @@ bool FocusedNormalRenderer::LoadMetaData() {
   // Read parameters from yaml
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
   ReadOptionalValueFromYaml(fs, "image_size", &image_size_);
+  ReadOptionalValueFromYaml(fs, "render_cache_threshold",
+                            &render_cache_threshold_);
   fs.release();
   return true;
 }
@@ -55,9 +55,19 @@ bool Optimizer::SetUp() {
 
   // Initialize internal values and referenced links
   degrees_of_freedom_ = DegreesOfFreedom();
+  single_link_ = root_link_ptr_->child_link_ptrs().empty() &&
+                 degrees_of_freedom_ == 6 && constraint_ptrs_.empty() &&
+                 soft_constraint_ptrs_.empty();
   if (!DefineJacobians()) return false;
   if (!UpdatePoses(Eigen::VectorXf::Zero(degrees_of_freedom_))) return false;
   DefineTikhonovVector();
+  DefineConvergenceVector();
+  DefineWorkspaces();
+  if (use_tree_solver_ && !DefineTreeData()) return false;
+  motion_model_.set_use_kalman_filter(use_kalman_filter_);
+  motion_model_.set_process_noise(kalman_process_noise_);
+  motion_model_.set_measurement_noise(kalman_measurement_noise_);
+  motion_model_.Reset();
 
   set_up_ = true;
   return true;
@@ -132,6 +142,65 @@ void Optimizer::set_tikhonov_parameter_translation(
   set_up_ = false;
 }
 
+void Optimizer::set_use_tree_solver(bool use_tree_solver) {
+  use_tree_solver_ = use_tree_solver;
+  set_up_ = false;
+}
+
+void Optimizer::set_use_levenberg_marquardt(bool use_levenberg_marquardt) {
+  use_levenberg_marquardt_ = use_levenberg_marquardt;
+  set_up_ = false;
+}
+
+void Optimizer::set_step_acceptance_ratio(float step_acceptance_ratio) {
+  step_acceptance_ratio_ = step_acceptance_ratio;
+}
+
+void Optimizer::set_damping_adaption_factor(float damping_adaption_factor) {
+  damping_adaption_factor_ = damping_adaption_factor;
+}
+
+void Optimizer::set_min_damping_factor(float min_damping_factor) {
+  min_damping_factor_ = min_damping_factor;
+  set_up_ = false;
+}
+
+void Optimizer::set_max_damping_factor(float max_damping_factor) {
+  max_damping_factor_ = max_damping_factor;
+  set_up_ = false;
+}
+
+void Optimizer::set_convergence_threshold_rotation(
+    float convergence_threshold_rotation) {
+  convergence_threshold_rotation_ = convergence_threshold_rotation;
+  set_up_ = false;
+}
+
+void Optimizer::set_convergence_threshold_translation(
+    float convergence_threshold_translation) {
+  convergence_threshold_translation_ = convergence_threshold_translation;
+  set_up_ = false;
+}
+
+void Optimizer::set_use_motion_model(bool use_motion_model) {
+  use_motion_model_ = use_motion_model;
+}
+
+void Optimizer::set_use_kalman_filter(bool use_kalman_filter) {
+  use_kalman_filter_ = use_kalman_filter;
+  set_up_ = false;
+}
+
+void Optimizer::set_kalman_process_noise(float kalman_process_noise) {
+  kalman_process_noise_ = kalman_process_noise;
+  set_up_ = false;
+}
+
+void Optimizer::set_kalman_measurement_noise(float kalman_measurement_noise) {
+  kalman_measurement_noise_ = kalman_measurement_noise;
+  set_up_ = false;
+}
+
 bool Optimizer::CalculateConsistentPoses() {
   if (!set_up_) {
     std::cerr << "Set up optimizer " << name_ << " first" << std::endl;
@@ -147,25 +216,92 @@ bool Optimizer::CalculateOptimization(int iteration, int corr_iteration,
     std::cerr << "Set up optimizer " << name_ << " first" << std::endl;
     return false;
   }
+  converged_ = false;
+
+  if (single_link_) {
+    if (!root_link_ptr_->CalculateJacobian(nullptr)) return false;
+    if (!root_link_ptr_->CalculateGradientAndHessian()) return false;
+  } else {
+    if (!CalculateDataLinks()) return false;
+    if (!CalculateDataConstraints()) return false;
+  }
 
-  // Assamble coefficient matrix and column vector
-  int size{degrees_of_freedom_ + NumberOfConstraints()};
-  Eigen::VectorXf b{Eigen::VectorXf::Zero(size)};
-  Eigen::MatrixXf a{Eigen::MatrixXf::Zero(size, size)};
-  if (!CalculateDataLinks()) return false;
-  if (!CalculateDataConstraints()) return false;
-  AddProjectedGradientsAndHessians(&b, &a);
-  AddResidualsAndConstraintJacobians(&b, &a);
-  a.diagonal().topRows(degrees_of_freedom_) += tikhonov_vector_;
-
-  //// Optimize and update pose
-  Eigen::LDLT<Eigen::MatrixXf, Eigen::Lower> ldlt{a};
-  Eigen::VectorXf theta{ldlt.solve(b)};
-
-  if (theta.array().isNaN().isZero()) return UpdatePoses(theta);
+  // Evaluate and revert previous step
+  if (use_levenberg_marquardt_ && !EvaluateStep(corr_iteration, opt_iteration))
+    return RevertPoses(theta_);
+
+  // Optimize and update pose
+  if (single_link_) {
+    if (!SolveSingleLinkSystem(&theta_)) return true;
+  } else if (use_tree_solver_) {
+    SolveTreeSystem(&theta_);
+  } else {
+    SolveDenseSystem(&theta_);
+  }
+  if (!theta_.array().isNaN().isZero()) return true;
+
+  if (use_levenberg_marquardt_) {
+    PredictIncrease(theta_);
+    converged_ = (theta_.array().abs() <= convergence_vector_.array()).all();
+  }
+  if (single_link_)
+    return root_link_ptr_->ApplyJointVariation(nullptr, theta_.head<6>());
+  return UpdatePoses(theta_);
+}
+
+bool Optimizer::IsBatchable() const {
+  return set_up_ && single_link_ && !use_levenberg_marquardt_;
+}
+
+bool Optimizer::CalculateSingleLinkSystem(Eigen::Matrix<float, 6, 6> *a,
+                                          Eigen::Matrix<float, 6, 1> *b) {
+  if (!IsBatchable()) {
+    std::cerr << "Optimizer " << name_ << " is not batchable" << std::endl;
+    return false;
+  }
+  if (!root_link_ptr_->CalculateJacobian(nullptr)) return false;
+  if (!root_link_ptr_->CalculateGradientAndHessian()) return false;
+  AssembleSingleLinkSystem(a, b);
   return true;
 }
 
+bool Optimizer::ApplySingleLinkVariation(
+    const Eigen::Matrix<float, 6, 1> &theta) {
+  if (!IsBatchable()) {
+    std::cerr << "Optimizer " << name_ << " is not batchable" << std::endl;
+    return false;
+  }
+  if (theta.array().isNaN().any()) return true;
+  return root_link_ptr_->ApplyJointVariation(nullptr, theta);
+}
+
+bool Optimizer::PredictPoses(double timestamp) {
+  if (!set_up_) {
+    std::cerr << "Set up optimizer " << name_ << " first" << std::endl;
+    return false;
+  }
+  if (!use_motion_model_) return true;
+
+  Transform3fA link2world_pose;
+  if (!motion_model_.Predict(timestamp, &link2world_pose)) return true;
+  root_link_ptr_->set_link2world_pose(link2world_pose);
+  if (root_link_ptr_->body_ptr())
+    root_link_ptr_->body_ptr()->set_body2world_pose(link2world_pose);
+  return UpdatePoses(Eigen::VectorXf::Zero(degrees_of_freedom_));
+}
+
+bool Optimizer::UpdateMotionModel(double timestamp) {
+  if (!set_up_) {
+    std::cerr << "Set up optimizer " << name_ << " first" << std::endl;
+    return false;
+  }
+  if (!use_motion_model_) return true;
+  motion_model_.Update(root_link_ptr_->link2world_pose(), timestamp);
+  return true;
+}
+
+void Optimizer::ResetMotionModel() { motion_model_.Reset(); }
+
 std::vector<std::shared_ptr<Link>> Optimizer::ReferencedLinks() {
   std::vector<std::shared_ptr<Link>> referenced_links;
   AddReferencedLinks(root_link_ptr_, &referenced_links);
@@ -200,6 +336,48 @@ float Optimizer::tikhonov_parameter_translation() const {
   return tikhonov_parameter_translation_;
 }
 
+bool Optimizer::use_tree_solver() const { return use_tree_solver_; }
+
+bool Optimizer::use_levenberg_marquardt() const {
+  return use_levenberg_marquardt_;
+}
+
+float Optimizer::step_acceptance_ratio() const {
+  return step_acceptance_ratio_;
+}
+
+float Optimizer::damping_adaption_factor() const {
+  return damping_adaption_factor_;
+}
+
+float Optimizer::min_damping_factor() const { return min_damping_factor_; }
+
+float Optimizer::max_damping_factor() const { return max_damping_factor_; }
+
+float Optimizer::convergence_threshold_rotation() const {
+  return convergence_threshold_rotation_;
+}
+
+float Optimizer::convergence_threshold_translation() const {
+  return convergence_threshold_translation_;
+}
+
+bool Optimizer::use_motion_model() const { return use_motion_model_; }
+
+bool Optimizer::use_kalman_filter() const { return use_kalman_filter_; }
+
+float Optimizer::kalman_process_noise() const {
+  return kalman_process_noise_;
+}
+
+float Optimizer::kalman_measurement_noise() const {
+  return kalman_measurement_noise_;
+}
+
+float Optimizer::damping_factor() const { return damping_factor_; }
+
+bool Optimizer::converged() const { return converged_; }
+
 bool Optimizer::set_up() const { return set_up_; }
 
 bool Optimizer::LoadMetaData() {
@@ -212,6 +390,25 @@ bool Optimizer::LoadMetaData() {
                             &tikhonov_parameter_rotation_);
   ReadOptionalValueFromYaml(fs, "tikhonov_parameter_translation",
                             &tikhonov_parameter_translation_);
+  ReadOptionalValueFromYaml(fs, "use_tree_solver", &use_tree_solver_);
+  ReadOptionalValueFromYaml(fs, "use_levenberg_marquardt",
+                            &use_levenberg_marquardt_);
+  ReadOptionalValueFromYaml(fs, "step_acceptance_ratio",
+                            &step_acceptance_ratio_);
+  ReadOptionalValueFromYaml(fs, "damping_adaption_factor",
+                            &damping_adaption_factor_);
+  ReadOptionalValueFromYaml(fs, "min_damping_factor", &min_damping_factor_);
+  ReadOptionalValueFromYaml(fs, "max_damping_factor", &max_damping_factor_);
+  ReadOptionalValueFromYaml(fs, "convergence_threshold_rotation",
+                            &convergence_threshold_rotation_);
+  ReadOptionalValueFromYaml(fs, "convergence_threshold_translation",
+                            &convergence_threshold_translation_);
+  ReadOptionalValueFromYaml(fs, "use_motion_model", &use_motion_model_);
+  ReadOptionalValueFromYaml(fs, "use_kalman_filter", &use_kalman_filter_);
+  ReadOptionalValueFromYaml(fs, "kalman_process_noise",
+                            &kalman_process_noise_);
+  ReadOptionalValueFromYaml(fs, "kalman_measurement_noise",
+                            &kalman_measurement_noise_);
   fs.release();
   return true;
 }
@@ -251,23 +448,62 @@ bool Optimizer::DefineJacobians(const std::shared_ptr<Link> &link_ptr,
 
 void Optimizer::DefineTikhonovVector() {
   tikhonov_vector_.resize(degrees_of_freedom_);
-  DefineTikhonovVector(root_link_ptr_, &tikhonov_vector_);
+  DefineDirectionVector(root_link_ptr_, tikhonov_parameter_rotation_,
+                        tikhonov_parameter_translation_, &tikhonov_vector_);
+  damping_factor_ = 1.0f;
+  damping_vector_ = damping_factor_ * tikhonov_vector_;
+}
+
+void Optimizer::DefineConvergenceVector() {
+  convergence_vector_.resize(degrees_of_freedom_);
+  DefineDirectionVector(root_link_ptr_, convergence_threshold_rotation_,
+                        convergence_threshold_translation_,
+                        &convergence_vector_);
 }
 
-void Optimizer::DefineTikhonovVector(const std::shared_ptr<Link> &link_ptr,
-                                     Eigen::VectorXf *tikhonov_vector) const {
+void Optimizer::DefineDirectionVector(const std::shared_ptr<Link> &link_ptr,
+                                      float value_rotation,
+                                      float value_translation,
+                                      Eigen::VectorXf *direction_vector) const {
   int idx = link_ptr->first_jacobian_index();
   for (int direction = 0; direction < 6; ++direction) {
     if (link_ptr->free_directions()[direction]) {
       if (direction < 3)
-        (*tikhonov_vector)[idx] = tikhonov_parameter_rotation_;
+        (*direction_vector)[idx] = value_rotation;
       else
-        (*tikhonov_vector)[idx] = tikhonov_parameter_translation_;
+        (*direction_vector)[idx] = value_translation;
       idx++;
     }
   }
   for (auto &child_link_ptr : link_ptr->child_link_ptrs())
-    DefineTikhonovVector(child_link_ptr, tikhonov_vector);
+    DefineDirectionVector(child_link_ptr, value_rotation, value_translation,
+                          direction_vector);
+}
+
+void Optimizer::DefineWorkspaces() {
+  int n_constraints = NumberOfConstraints();
+  int max_n_constraints = 0;
+  for (auto &constraint_ptr : constraint_ptrs_)
+    max_n_constraints =
+        std::max(max_n_constraints, constraint_ptr->NumberOfConstraints());
+  int size = degrees_of_freedom_ + n_constraints;
+
+  theta_.setZero(degrees_of_freedom_);
+  b_.setZero(size);
+  a_.setZero(size, size);
+  ldlt_ = Eigen::LDLT<Eigen::MatrixXf, Eigen::Lower>{size};
+  hessian_jacobian_.setZero(Eigen::NoChange, degrees_of_freedom_);
+  constraint_jacobian_.setZero(max_n_constraints, degrees_of_freedom_);
+  residual_.setZero(n_constraints);
+  constraint_variations_.setZero(n_constraints);
+  column_variations_.setZero(n_constraints);
+  schur_complement_.setZero(n_constraints, n_constraints);
+  schur_complement_ldlt_ = Eigen::LDLT<Eigen::MatrixXf>{n_constraints};
+  lambda_.setZero(n_constraints);
+  link_variations_.assign(ReferencedLinks().size(),
+                          Eigen::Matrix<float, 6, 1>::Zero());
+  step_pending_ = false;
+  converged_ = false;
 }
 
 void Optimizer::AddReferencedLinks(
@@ -278,6 +514,43 @@ void Optimizer::AddReferencedLinks(
     AddReferencedLinks(child_link_ptr, referenced_links);
 }
 
+bool Optimizer::DefineTreeData() {
+  tree_link_data_.clear();
+  AddTreeLinkData(root_link_ptr_, -1);
+  tree_constraint_data_.clear();
+  for (auto &constraint_ptr : constraint_ptrs_) {
+    TreeConstraintData data;
+    data.link1_index = TreeLinkIndex(constraint_ptr->link1_ptr().get());
+    data.link2_index = TreeLinkIndex(constraint_ptr->link2_ptr().get());
+    if (data.link1_index < 0 || data.link2_index < 0) {
+      std::cerr << "Links of constraint " << constraint_ptr->name()
+                << " are not part of optimizer " << name_ << std::endl;
+      return false;
+    }
+    tree_constraint_data_.push_back(data);
+  }
+  return true;
+}
+
+void Optimizer::AddTreeLinkData(const std::shared_ptr<Link> &link_ptr,
+                                int parent_index) {
+  TreeLinkData data;
+  data.link_ptr = link_ptr.get();
+  data.parent_index = parent_index;
+  data.first_index = link_ptr->first_jacobian_index();
+  data.n_dofs = link_ptr->DegreesOfFreedom();
+  tree_link_data_.push_back(std::move(data));
+  int index = int(tree_link_data_.size()) - 1;
+  for (auto &child_link_ptr : link_ptr->child_link_ptrs())
+    AddTreeLinkData(child_link_ptr, index);
+}
+
+int Optimizer::TreeLinkIndex(const Link *link_ptr) const {
+  for (int i = 0; i < int(tree_link_data_.size()); ++i)
+    if (tree_link_data_[i].link_ptr == link_ptr) return i;
+  return -1;
+}
+
 bool Optimizer::CalculateDataLinks() {
   if (!CalculateDataLinks(root_link_ptr_, nullptr)) return false;
   for (auto &soft_constraint_ptr : soft_constraint_ptrs_)
@@ -302,32 +575,312 @@ bool Optimizer::CalculateDataConstraints() const {
 }
 
 void Optimizer::AddProjectedGradientsAndHessians(Eigen::VectorXf *b,
-                                                 Eigen::MatrixXf *a) const {
+                                                 Eigen::MatrixXf *a) {
   AddProjectedGradientsAndHessians(root_link_ptr_, b, a);
 }
 
 void Optimizer::AddProjectedGradientsAndHessians(
     const std::shared_ptr<Link> &link_ptr, Eigen::VectorXf *b,
-    Eigen::MatrixXf *a) const {
-  const auto &gradient{link_ptr->gradient()};
-  const auto &hessian{link_ptr->hessian()};
+    Eigen::MatrixXf *a) {
   const auto &jacobian{link_ptr->jacobian()};
-  b->topRows(degrees_of_freedom_) += jacobian.transpose() * gradient;
-  a->topLeftCorner(degrees_of_freedom_, degrees_of_freedom_)
-      .triangularView<Eigen::Lower>() -=
-      jacobian.transpose() * hessian * jacobian;
+  const auto &jacobian_blocks{link_ptr->jacobian_blocks()};
+  auto hessian_jacobian{hessian_jacobian_.leftCols(jacobian.cols())};
+  hessian_jacobian.noalias() = link_ptr->hessian() * jacobian;
+
+  // Only blocks of the link and its ancestors are nonzero
+  for (int i = 0; i < int(jacobian_blocks.size()); ++i) {
+    const auto &block_i{jacobian_blocks[i]};
+    const auto &jacobian_i{
+        jacobian.middleCols(block_i.first_column, block_i.n_columns)};
+    b->segment(block_i.first_jacobian_index, block_i.n_columns).noalias() +=
+        jacobian_i.transpose() * link_ptr->gradient();
+    a->block(block_i.first_jacobian_index, block_i.first_jacobian_index,
+             block_i.n_columns, block_i.n_columns)
+        .triangularView<Eigen::Lower>() -=
+        jacobian_i.transpose() *
+        hessian_jacobian.middleCols(block_i.first_column, block_i.n_columns);
+    for (int j = 0; j < i; ++j) {
+      const auto &block_j{jacobian_blocks[j]};
+      a->block(block_i.first_jacobian_index, block_j.first_jacobian_index,
+               block_i.n_columns, block_j.n_columns)
+          .noalias() -=
+          jacobian_i.transpose() *
+          hessian_jacobian.middleCols(block_j.first_column, block_j.n_columns);
+    }
+  }
   for (auto &child_link_ptr : link_ptr->child_link_ptrs())
     AddProjectedGradientsAndHessians(child_link_ptr, b, a);
 }
 
 void Optimizer::AddResidualsAndConstraintJacobians(Eigen::VectorXf *b,
-                                                   Eigen::MatrixXf *a) const {
+                                                   Eigen::MatrixXf *a) {
   int idx = degrees_of_freedom_;
   for (auto &constraint_ptr : constraint_ptrs_) {
     int size = constraint_ptr->NumberOfConstraints();
     b->segment(idx, size) = constraint_ptr->residual();
-    a->block(idx, 0, size, degrees_of_freedom_) =
-        -constraint_ptr->constraint_jacobian();
+    SubtractConstraintJacobian(idx,
+                               constraint_ptr->link1_constraint_jacobian(),
+                               constraint_ptr->link1_ptr(), a);
+    SubtractConstraintJacobian(idx,
+                               constraint_ptr->link2_constraint_jacobian(),
+                               constraint_ptr->link2_ptr(), a);
+    idx += size;
+  }
+}
+
+void Optimizer::SubtractConstraintJacobian(
+    int first_row, const Eigen::MatrixXf &link_constraint_jacobian,
+    const std::shared_ptr<Link> &link_ptr, Eigen::MatrixXf *a) {
+  const auto &jacobian{link_ptr->jacobian()};
+  int n_rows = int(link_constraint_jacobian.rows());
+  if (constraint_jacobian_.rows() < n_rows)
+    constraint_jacobian_.resize(n_rows, degrees_of_freedom_);
+  auto constraint_jacobian{
+      constraint_jacobian_.topLeftCorner(n_rows, jacobian.cols())};
+  constraint_jacobian.noalias() = link_constraint_jacobian * jacobian;
+  for (const auto &block : link_ptr->jacobian_blocks()) {
+    a->block(first_row, block.first_jacobian_index, n_rows, block.n_columns) -=
+        constraint_jacobian.middleCols(block.first_column, block.n_columns);
+  }
+}
+
+void Optimizer::SolveDenseSystem(Eigen::VectorXf *theta) {
+  // Assamble coefficient matrix and column vector
+  int size{degrees_of_freedom_ + NumberOfConstraints()};
+  b_.setZero(size);
+  a_.setZero(size, size);
+  AddProjectedGradientsAndHessians(&b_, &a_);
+  AddResidualsAndConstraintJacobians(&b_, &a_);
+  a_.diagonal().topRows(degrees_of_freedom_) += damping_vector_;
+
+  // Solve system and extract variation of degrees of freedom
+  ldlt_.compute(a_);
+  ldlt_.solveInPlace(b_);
+  *theta = b_.topRows(degrees_of_freedom_);
+}
+
+bool Optimizer::SolveSingleLinkSystem(Eigen::VectorXf *theta) {
+  Eigen::Matrix<float, 6, 6> a;
+  Eigen::Matrix<float, 6, 1> b;
+  AssembleSingleLinkSystem(&a, &b);
+  Eigen::LLT<Eigen::Matrix<float, 6, 6>> llt{a};
+  if (llt.info() != Eigen::Success) return false;
+  theta->head<6>() = llt.solve(b);
+  return true;
+}
+
+void Optimizer::AssembleSingleLinkSystem(Eigen::Matrix<float, 6, 6> *a,
+                                         Eigen::Matrix<float, 6, 1> *b) const {
+  // Assemble system with fixed-size matrices
+  const Eigen::Matrix<float, 6, 6> jacobian{root_link_ptr_->joint_jacobian()};
+  a->noalias() = -jacobian.transpose() * root_link_ptr_->hessian() * jacobian;
+  a->diagonal() += damping_vector_.head<6>();
+  b->noalias() = jacobian.transpose() * root_link_ptr_->gradient();
+}
+
+bool Optimizer::EvaluateStep(int corr_iteration, int opt_iteration) {
+  // Start each frame with the initial damping
+  if (corr_iteration == 0 && opt_iteration == 0) {
+    damping_factor_ = 1.0f;
+    damping_vector_ = tikhonov_vector_;
+  }
+  if (opt_iteration == 0) step_pending_ = false;
+  if (!step_pending_) return true;
+  step_pending_ = false;
+  if (predicted_increase_ <= 0.0f) return true;
+
+  // Compare actual and predicted increase and adapt damping
+  float actual_increase = 0.5f * (gradient_increase_ + GradientIncrease());
+  float ratio = actual_increase / predicted_increase_;
+  if (ratio < 0.25f)
+    damping_factor_ = std::min(damping_factor_ * damping_adaption_factor_,
+                               max_damping_factor_);
+  else if (ratio > 0.75f)
+    damping_factor_ = std::max(damping_factor_ / damping_adaption_factor_,
+                               min_damping_factor_);
+  damping_vector_ = damping_factor_ * tikhonov_vector_;
+  return ratio >= step_acceptance_ratio_;
+}
+
+void Optimizer::PredictIncrease(const Eigen::VectorXf &theta) {
+  predicted_increase_ = 0.0f;
+  gradient_increase_ = 0.0f;
+  int link_idx = 0;
+  PredictIncrease(root_link_ptr_, theta, &link_idx);
+  step_pending_ = true;
+}
+
+void Optimizer::PredictIncrease(const std::shared_ptr<Link> &link_ptr,
+                                const Eigen::VectorXf &theta, int *link_idx) {
+  // Calculate variation of body from variations of ancestor joints
+  const auto &jacobian{link_ptr->jacobian()};
+  auto &link_variation{link_variations_[(*link_idx)++]};
+  link_variation.setZero();
+  for (const auto &block : link_ptr->jacobian_blocks()) {
+    link_variation.noalias() +=
+        jacobian.middleCols(block.first_column, block.n_columns) *
+        theta.segment(block.first_jacobian_index, block.n_columns);
+  }
+
+  // Add increase of quadratic model and linear term
+  float gradient_increase = link_ptr->gradient().dot(link_variation);
+  gradient_increase_ += gradient_increase;
+  predicted_increase_ +=
+      gradient_increase +
+      0.5f * link_variation.dot(link_ptr->hessian() * link_variation);
+  for (auto &child_link_ptr : link_ptr->child_link_ptrs())
+    PredictIncrease(child_link_ptr, theta, link_idx);
+}
+
+float Optimizer::GradientIncrease() const {
+  int link_idx = 0;
+  return GradientIncrease(root_link_ptr_, &link_idx);
+}
+
+float Optimizer::GradientIncrease(const std::shared_ptr<Link> &link_ptr,
+                                  int *link_idx) const {
+  float gradient_increase =
+      link_ptr->gradient().dot(link_variations_[(*link_idx)++]);
+  for (auto &child_link_ptr : link_ptr->child_link_ptrs())
+    gradient_increase += GradientIncrease(child_link_ptr, link_idx);
+  return gradient_increase;
+}
+
+void Optimizer::SolveTreeSystem(Eigen::VectorXf *theta) {
+  theta->resize(degrees_of_freedom_);
+  FactorizeTree();
+  SetTreeGradients();
+  SolveTree(theta);
+  if (constraint_ptrs_.empty()) return;
+
+  // Calculate Schur complement of constraints using unit forces
+  int n_constraints = NumberOfConstraints();
+  residual_.resize(n_constraints);
+  constraint_variations_.resize(n_constraints);
+  column_variations_.resize(n_constraints);
+  schur_complement_.resize(n_constraints, n_constraints);
+  CalculateConstraintVariations(&constraint_variations_);
+  int idx = 0;
+  for (int i = 0; i < int(constraint_ptrs_.size()); ++i) {
+    int size = constraint_ptrs_[i]->NumberOfConstraints();
+    residual_.segment(idx, size) = constraint_ptrs_[i]->residual();
+    for (int row = 0; row < size; ++row) {
+      for (auto &data : tree_link_data_) data.articulated_gradient.setZero();
+      AddTreeConstraintForce(i, row, 1.0f);
+      SolveTree(nullptr);
+      CalculateConstraintVariations(&column_variations_);
+      schur_complement_.col(idx + row) = column_variations_;
+    }
+    idx += size;
+  }
+
+  // Calculate Lagrange multipliers and solve with constraint forces
+  lambda_ = -residual_ - constraint_variations_;
+  schur_complement_ldlt_.compute(schur_complement_);
+  schur_complement_ldlt_.solveInPlace(lambda_);
+  SetTreeGradients();
+  idx = 0;
+  for (int i = 0; i < int(constraint_ptrs_.size()); ++i) {
+    int size = constraint_ptrs_[i]->NumberOfConstraints();
+    for (int row = 0; row < size; ++row)
+      AddTreeConstraintForce(i, row, lambda_(idx + row));
+    idx += size;
+  }
+  SolveTree(theta);
+}
+
+void Optimizer::FactorizeTree() {
+  for (auto &data : tree_link_data_)
+    data.articulated_hessian = -data.link_ptr->hessian();
+
+  // Eliminate joint variations from leaves to root
+  for (int i = int(tree_link_data_.size()) - 1; i >= 0; --i) {
+    auto &data{tree_link_data_[i]};
+    if (data.n_dofs > 0) {
+      const auto &joint_jacobian{data.link_ptr->joint_jacobian()};
+      data.hessian_joint_jacobian = data.articulated_hessian * joint_jacobian;
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, 0, 6, 6> d{
+          joint_jacobian.transpose() * data.hessian_joint_jacobian};
+      d.diagonal() += damping_vector_.segment(data.first_index, data.n_dofs);
+      data.joint_ldlt.compute(d);
+      data.articulated_hessian -=
+          data.hessian_joint_jacobian *
+          data.joint_ldlt.solve(data.hessian_joint_jacobian.transpose());
+    }
+    if (data.parent_index >= 0) {
+      const auto &parent_adjoint{data.link_ptr->parent_adjoint()};
+      tree_link_data_[data.parent_index].articulated_hessian +=
+          parent_adjoint.transpose() * data.articulated_hessian *
+          parent_adjoint;
+    }
+  }
+}
+
+void Optimizer::SetTreeGradients() {
+  for (auto &data : tree_link_data_)
+    data.articulated_gradient = data.link_ptr->gradient();
+}
+
+void Optimizer::AddTreeConstraintForce(int constraint_idx, int row,
+                                       float force) {
+  const auto &constraint_ptr{constraint_ptrs_[constraint_idx]};
+  const auto &constraint_data{tree_constraint_data_[constraint_idx]};
+  tree_link_data_[constraint_data.link1_index].articulated_gradient +=
+      force * constraint_ptr->link1_constraint_jacobian().row(row).transpose();
+  tree_link_data_[constraint_data.link2_index].articulated_gradient +=
+      force * constraint_ptr->link2_constraint_jacobian().row(row).transpose();
+}
+
+void Optimizer::SolveTree(Eigen::VectorXf *theta) {
+  // Project gradients from leaves to root
+  for (int i = int(tree_link_data_.size()) - 1; i >= 0; --i) {
+    auto &data{tree_link_data_[i]};
+    if (data.n_dofs > 0) {
+      data.joint_variation = data.joint_ldlt.solve(
+          data.link_ptr->joint_jacobian().transpose() *
+          data.articulated_gradient);
+      data.articulated_gradient -=
+          data.hessian_joint_jacobian * data.joint_variation;
+    }
+    if (data.parent_index >= 0) {
+      tree_link_data_[data.parent_index].articulated_gradient +=
+          data.link_ptr->parent_adjoint().transpose() *
+          data.articulated_gradient;
+    }
+  }
+
+  // Calculate variations from root to leaves
+  for (auto &data : tree_link_data_) {
+    if (data.parent_index >= 0) {
+      data.variation = data.link_ptr->parent_adjoint() *
+                       tree_link_data_[data.parent_index].variation;
+    } else {
+      data.variation.setZero();
+    }
+    if (data.n_dofs > 0) {
+      data.joint_variation -= data.joint_ldlt.solve(
+          data.hessian_joint_jacobian.transpose() * data.variation);
+      data.variation += data.link_ptr->joint_jacobian() * data.joint_variation;
+      if (theta)
+        theta->segment(data.first_index, data.n_dofs) = data.joint_variation;
+    }
+  }
+}
+
+void Optimizer::CalculateConstraintVariations(
+    Eigen::VectorXf *variations) const {
+  int idx = 0;
+  for (int i = 0; i < int(constraint_ptrs_.size()); ++i) {
+    const auto &constraint_ptr{constraint_ptrs_[i]};
+    const auto &constraint_data{tree_constraint_data_[i]};
+    int size = constraint_ptr->NumberOfConstraints();
+    auto constraint_variations{variations->segment(idx, size)};
+    constraint_variations.noalias() =
+        constraint_ptr->link1_constraint_jacobian() *
+        tree_link_data_[constraint_data.link1_index].variation;
+    constraint_variations.noalias() +=
+        constraint_ptr->link2_constraint_jacobian() *
+        tree_link_data_[constraint_data.link2_index].variation;
     idx += size;
   }
 }
@@ -345,4 +898,17 @@ bool Optimizer::UpdatePoses(const std::shared_ptr<Link> &link_ptr,
   return true;
 }
 
+bool Optimizer::RevertPoses(const Eigen::VectorXf &theta) {
+  return RevertPoses(root_link_ptr_, nullptr, theta);
+}
+
+bool Optimizer::RevertPoses(const std::shared_ptr<Link> &link_ptr,
+                            const std::shared_ptr<Link> &parent_link_ptr,
+                            const Eigen::VectorXf &theta) {
+  if (!link_ptr->RevertPoses(parent_link_ptr, theta)) return false;
+  for (auto &child_link_ptr : link_ptr->child_link_ptrs())
+    if (!RevertPoses(child_link_ptr, link_ptr, theta)) return false;
+  return true;
+}
+
 }  // namespace m3t
@@ -161,7 +161,9 @@ bool RealSenseColorCamera::UpdateImage(bool synchronized) {
           (void *)realsense_.frameset().get_color_frame().get_data(),
           cv::Mat::AUTO_STEP}
       .copyTo(image_);
+  timestamp_ = realsense_.frameset().get_color_frame().get_timestamp() * 1.0e-3;
 
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
@@ -266,7 +268,9 @@ bool RealSenseDepthCamera::UpdateImage(bool synchronized) {
           (void *)realsense_.frameset().get_depth_frame().get_data(),
           cv::Mat::AUTO_STEP}
       .copyTo(image_);
+  timestamp_ = realsense_.frameset().get_depth_frame().get_timestamp() * 1.0e-3;
 
+  image_index_++;
   SaveImageIfDesired();
   return true;
 }
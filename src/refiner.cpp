@@ -95,6 +95,75 @@ bool Refiner::RefinePoses(const std::set<std::string> &names) {
   return ExecuteRefinementStep();
 }
 
+bool Refiner::RefinePoseHypotheses(
+    const std::set<std::string> &names,
+    const std::map<std::string, std::vector<Transform3fA>>
+        &link2world_pose_hypotheses) {
+  if (!set_up_) {
+    std::cerr << "Set up refiner " << name_ << " first" << std::endl;
+    return false;
+  }
+  AssambleInternallyUsedObjectPtrs(names);
+  if (used_optimizer_ptrs_.empty()) return true;
+
+  // Save initial poses and find maximum number of hypotheses
+  int n_optimizers = int(used_optimizer_ptrs_.size());
+  std::vector<OptimizerPoses> initial_poses(n_optimizers);
+  std::vector<OptimizerPoses> best_poses(n_optimizers);
+  std::vector<float> best_scores(n_optimizers, -1.0f);
+  int n_hypotheses = 1;
+  for (int i = 0; i < n_optimizers; ++i) {
+    SavePoses(used_optimizer_ptrs_[i], &initial_poses[i]);
+    auto it{link2world_pose_hypotheses.find(used_optimizer_ptrs_[i]->name())};
+    if (it != end(link2world_pose_hypotheses))
+      n_hypotheses = std::max(n_hypotheses, int(it->second.size()));
+  }
+
+  // Refine hypotheses and keep poses with highest score. Optimizers without
+  // remaining hypotheses are only refined in the first round and keep their
+  // best pose in later rounds
+  std::vector<std::shared_ptr<Optimizer>> optimizer_ptrs{used_optimizer_ptrs_};
+  std::vector<bool> refined(n_optimizers);
+  for (int hypothesis_idx = 0; hypothesis_idx < n_hypotheses;
+       ++hypothesis_idx) {
+    std::set<std::string> refined_names;
+    for (int i = 0; i < n_optimizers; ++i) {
+      const auto &optimizer_ptr{optimizer_ptrs[i]};
+      OptimizerPoses poses{hypothesis_idx == 0 ? initial_poses[i]
+                                               : best_poses[i]};
+      auto it{link2world_pose_hypotheses.find(optimizer_ptr->name())};
+      bool has_hypothesis = it != end(link2world_pose_hypotheses) &&
+                            hypothesis_idx < int(it->second.size());
+      if (has_hypothesis) {
+        poses = initial_poses[i];
+        poses.link2world_pose = it->second[hypothesis_idx];
+      }
+      refined[i] = hypothesis_idx == 0 || has_hypothesis;
+      if (refined[i]) refined_names.insert(optimizer_ptr->name());
+      if (!RestorePoses(poses, optimizer_ptr)) return false;
+    }
+    AssambleInternallyUsedObjectPtrs(refined_names);
+    if (!ExecuteRefinementStep()) return false;
+    if (!CalculateScores()) return false;
+    for (int i = 0; i < n_optimizers; ++i) {
+      if (!refined[i]) continue;
+      float score = scores_[optimizer_ptrs[i]->name()];
+      if (score > best_scores[i]) {
+        best_scores[i] = score;
+        SavePoses(optimizer_ptrs[i], &best_poses[i]);
+      }
+    }
+  }
+
+  // Set poses with highest score
+  AssambleInternallyUsedObjectPtrs(names);
+  for (int i = 0; i < n_optimizers; ++i) {
+    if (!RestorePoses(best_poses[i], optimizer_ptrs[i])) return false;
+    scores_[optimizer_ptrs[i]->name()] = best_scores[i];
+  }
+  return true;
+}
+
 bool Refiner::ExecuteRefinementStep() {
   for (int corr_iteration = 0; corr_iteration < n_corr_iterations_;
        ++corr_iteration) {
@@ -193,6 +262,27 @@ bool Refiner::VisualizeOptimization(int save_idx) {
   return true;
 }
 
+bool Refiner::CalculateScores() {
+  // Establish correspondences for the current poses
+  int corr_iteration = std::max(n_corr_iterations_ - 1, 0);
+  if (!StartModalities(corr_iteration)) return false;
+  if (!CalculateCorrespondences(corr_iteration)) return false;
+
+  // Sum scores of all modalities of an optimizer
+  for (auto &optimizer_ptr : used_optimizer_ptrs_) {
+    float optimizer_score = 0.0f;
+    for (auto &link_ptr : optimizer_ptr->ReferencedLinks()) {
+      for (auto &modality_ptr : link_ptr->modality_ptrs()) {
+        float score;
+        if (!modality_ptr->CalculateScore(&score)) return false;
+        optimizer_score += score;
+      }
+    }
+    scores_[optimizer_ptr->name()] = optimizer_score;
+  }
+  return true;
+}
+
 const std::string &Refiner::name() const { return name_; }
 
 const std::filesystem::path &Refiner::metafile_path() const {
@@ -250,6 +340,8 @@ int Refiner::n_update_iterations() const { return n_update_iterations_; }
 
 int Refiner::visualization_time() const { return visualization_time_; }
 
+const std::map<std::string, float> &Refiner::scores() const { return scores_; }
+
 bool Refiner::set_up() const { return set_up_; }
 
 bool Refiner::LoadMetaData() {
@@ -267,6 +359,11 @@ bool Refiner::LoadMetaData() {
 
 void Refiner::AssambleInternallyUsedObjectPtrs(
     const std::set<std::string> &names) {
+  used_optimizer_ptrs_.clear();
+  used_modality_ptrs_.clear();
+  used_start_modality_renderer_ptrs_.clear();
+  used_correspondence_renderer_ptrs_.clear();
+  used_color_histograms_ptrs_.clear();
   for (const auto &optimizer_ptr : optimizer_ptrs_) {
     if (names.find(optimizer_ptr->name()) != names.end()) {
       for (const auto &link_ptr : optimizer_ptr->ReferencedLinks()) {
@@ -372,4 +469,28 @@ bool Refiner::AreAllObjectsSetUp() {
          AreObjectPtrsSetUp(&optimizer_ptrs_);
 }
 
+void Refiner::SavePoses(const std::shared_ptr<Optimizer> &optimizer_ptr,
+                        OptimizerPoses *poses) {
+  poses->link2world_pose = optimizer_ptr->root_link_ptr()->link2world_pose();
+  poses->body2joint_poses.clear();
+  poses->joint2parent_poses.clear();
+  for (const auto &link_ptr : optimizer_ptr->ReferencedLinks()) {
+    poses->body2joint_poses.push_back(link_ptr->body2joint_pose());
+    poses->joint2parent_poses.push_back(link_ptr->joint2parent_pose());
+  }
+}
+
+bool Refiner::RestorePoses(const OptimizerPoses &poses,
+                           const std::shared_ptr<Optimizer> &optimizer_ptr) {
+  const auto &root_link_ptr{optimizer_ptr->root_link_ptr()};
+  root_link_ptr->set_link2world_pose(poses.link2world_pose);
+  if (root_link_ptr->body_ptr())
+    root_link_ptr->body_ptr()->set_body2world_pose(poses.link2world_pose);
+  auto link_ptrs{optimizer_ptr->ReferencedLinks()};
+  for (int i = 0; i < int(link_ptrs.size()); ++i)
+    link_ptrs[i]->SetJointPoses(poses.body2joint_poses[i],
+                                poses.joint2parent_poses[i]);
+  return optimizer_ptr->CalculateConsistentPoses();
+}
+
 }  // namespace m3t
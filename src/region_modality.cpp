@@ -428,6 +428,7 @@ bool RegionModality::CalculateCorrespondences(int iteration,
               << data_model_points.size() << " < " << n_lines << std::endl;
     n_lines = data_model_points.size();
   }
+  n_considered_lines_ = n_lines;
 
   // Differentiate cases with and without occlusion handling
   std::vector<float> segment_probabilities_f(line_length_in_segments_);
@@ -593,6 +594,34 @@ bool RegionModality::VisualizeResults(int save_idx) {
   return true;
 }
 
+bool RegionModality::CalculateScore(float *score) {
+  if (!IsSetup()) return false;
+
+  // Compare the measured contour distribution to the projected contour
+  PrecalculatePoseVariables();
+  float score_sum = 0.0f;
+  for (const auto &data_line : data_lines_) {
+    Eigen::Vector3f center_f_camera{body2camera_pose_ *
+                                    data_line.center_f_body};
+    float delta_cs =
+        (data_line.normal_u *
+             (center_f_camera(0) * fu_ / center_f_camera(2) + ppu_ -
+              data_line.center_u) +
+         data_line.normal_v *
+             (center_f_camera(1) * fv_ / center_f_camera(2) + ppv_ -
+              data_line.center_v) -
+         data_line.delta_r) *
+        data_line.normal_component_to_scale;
+    float error = data_line.mean - delta_cs;
+    score_sum +=
+        std::sqrt(min_expected_variance_ / data_line.measured_variance) *
+        std::exp(-0.5f * error * error / data_line.measured_variance);
+  }
+  *score = n_considered_lines_ > 0 ? score_sum / float(n_considered_lines_)
+                                   : 0.0f;
+  return true;
+}
+
 const std::shared_ptr<ColorCamera> &RegionModality::color_camera_ptr() const {
   return color_camera_ptr_;
 }
@@ -992,9 +1021,6 @@ void RegionModality::PrecalculateRendererVariables() {
   if (model_occlusions_) {
     depth_image_size_minus_1_ = depth_renderer_ptr_->image_size() - 1;
   }
-  if (use_region_checking_) {
-    fsilhouette_image_size_ = float(silhouette_renderer_ptr_->image_size());
-  }
 }
 
 void RegionModality::PrecalculatePoseVariables() {
@@ -1160,6 +1186,7 @@ void RegionModality::DynamicRegionDistance(
     float *dynamic_background_distance) const {
   const cv::Mat &silhouette_image{
       silhouette_renderer_ptr_->focused_silhouette_image()};
+  cv::Rect2f valid_region{silhouette_renderer_ptr_->valid_region()};
   uchar region_id = body_ptr_->region_id();
 
   // Precalculate variables in pixel coordinates of focused image
@@ -1191,8 +1218,7 @@ void RegionModality::DynamicRegionDistance(
   float u = focused_center_u - focused_offset_u;
   float v = focused_center_v - focused_offset_v;
   for (int i = i_start; i <= kNRegionStride; ++i) {
-    if (u >= fsilhouette_image_size_ || u < 0.0f ||
-        v >= fsilhouette_image_size_ || v < 0.0f) {
+    if (!valid_region.contains(cv::Point2f{u, v})) {
       *dynamic_foreground_distance = stride * float(i);
       break;
     }
@@ -1211,8 +1237,7 @@ void RegionModality::DynamicRegionDistance(
   u = focused_center_u + focused_offset_u;
   v = focused_center_v + focused_offset_v;
   for (int i = i_start; i <= kNRegionStride; ++i) {
-    if (u >= fsilhouette_image_size_ || u < 0.0f ||
-        v >= fsilhouette_image_size_ || v < 0.0f) {
+    if (!valid_region.contains(cv::Point2f{u, v})) {
       *dynamic_background_distance = max_considered_line_length_;
       break;
     }
@@ -1296,6 +1321,7 @@ bool RegionModality::IsDynamicLineRegionSufficient(float center_u,
                                                    float normal_v) const {
   const cv::Mat &silhouette_image{
       silhouette_renderer_ptr_->focused_silhouette_image()};
+  cv::Rect2f valid_region{silhouette_renderer_ptr_->valid_region()};
   uchar region_id = body_ptr_->region_id();
 
   // Precalculate variables in pixel coordinates of focused image
@@ -1330,9 +1356,7 @@ bool RegionModality::IsDynamicLineRegionSufficient(float center_u,
   u = focused_center_u + offset_u;
   v = focused_center_v + offset_v;
   for (int i = 0; i <= kNRegionStride; ++i) {
-    if (u >= fsilhouette_image_size_ || u < 0.0f ||
-        v >= fsilhouette_image_size_ || v < 0.0f)
-      break;
+    if (!valid_region.contains(cv::Point2f{u, v})) break;
     if (silhouette_image.at<uchar>(int(v), int(u)) == region_id) return false;
     u += stride_u;
     v += stride_v;
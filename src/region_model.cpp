@@ -131,6 +131,10 @@ bool RegionModel::GetClosestView(const Transform3fA &body2camera_pose,
 
 float RegionModel::max_contour_length() const { return max_contour_length_; }
 
+const std::vector<RegionModel::View> &RegionModel::views() const {
+  return views_;
+}
+
 const std::vector<std::shared_ptr<Body>> &RegionModel::associated_body_ptrs()
     const {
   return associated_body_ptrs_;
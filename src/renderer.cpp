@@ -2,6 +2,7 @@
 // Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
 
 #include <m3t/renderer.h>
+#include <m3t/renderer_atlas.h>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -98,6 +99,142 @@ bool CheckCompileErrors(unsigned shader, const std::string &type) {
   return true;
 }
 
+void SetLinearDepthUniforms(unsigned shader_program,
+                            const Eigen::Matrix4f &projection_matrix) {
+  float z_min = -projection_matrix(2, 3) / (projection_matrix(2, 2) + 1.0f);
+  float z_max = -projection_matrix(2, 3) / (projection_matrix(2, 2) - 1.0f);
+  glUniform1f(glGetUniformLocation(shader_program, "ZMin"), z_min);
+  glUniform1f(glGetUniformLocation(shader_program, "ZMax"), z_max);
+}
+
+int SelectLODLevel(const Body &body, const Transform3fA &world2camera_pose,
+                   float focal_length, float max_pixel_error) {
+  if (body.lod_meshes().empty() || max_pixel_error <= 0.0f) return 0;
+  float z = (world2camera_pose * body.body2world_pose().translation())(2) -
+            0.5f * body.maximum_body_diameter();
+  if (z <= 0.0f) return 0;
+  return body.SelectLODLevel(max_pixel_error * z / focal_length);
+}
+
+void AssignInstanceGroups(
+    const std::vector<RendererGeometry::RenderDataBody> &render_data_bodies,
+    const Transform3fA &world2camera_pose, float focal_length,
+    float max_pixel_error, std::vector<InstanceGroup> *instance_groups) {
+  size_t n_instance_groups = 0;
+  for (const auto &render_data_body : render_data_bodies) {
+    const Body &body{*render_data_body.body_ptr};
+    int lod_level = SelectLODLevel(body, world2camera_pose, focal_length,
+                                   max_pixel_error);
+    bool enable_culling = body.geometry_enable_culling();
+
+    // Find group with the same vertex objects that is not full
+    auto begin_groups{begin(*instance_groups)};
+    auto end_groups{begin_groups + n_instance_groups};
+    auto instance_group{std::find_if(
+        begin_groups, end_groups, [&](const InstanceGroup &group) {
+          return group.render_data_body_ptr->vbo == render_data_body.vbo &&
+                 group.lod_level == lod_level &&
+                 group.enable_culling == enable_culling &&
+                 group.body_ptrs.size() < size_t(kMaxNInstances);
+        })};
+
+    // Start new group and reuse memory of previous calls
+    if (instance_group == end_groups) {
+      if (n_instance_groups == instance_groups->size())
+        instance_groups->emplace_back();
+      instance_group = begin(*instance_groups) + n_instance_groups++;
+      instance_group->render_data_body_ptr = &render_data_body;
+      instance_group->lod_level = lod_level;
+      instance_group->enable_culling = enable_culling;
+      instance_group->body_ptrs.clear();
+    }
+    instance_group->body_ptrs.push_back(&body);
+  }
+  instance_groups->resize(n_instance_groups);
+}
+
+void FillOutsideRegion(const cv::Rect &region, const cv::Scalar &value,
+                       cv::Mat *image) {
+  cv::Rect image_rect{0, 0, image->cols, image->rows};
+  cv::Rect inside{region & image_rect};
+  if (inside == image_rect) return;
+  if (inside.empty()) {
+    image->setTo(value);
+    return;
+  }
+  int inside_bottom = inside.y + inside.height;
+  int inside_right = inside.x + inside.width;
+  (*image)(cv::Rect{0, 0, image->cols, inside.y}).setTo(value);
+  (*image)(cv::Rect{0, inside_bottom, image->cols, image->rows - inside_bottom})
+      .setTo(value);
+  (*image)(cv::Rect{0, inside.y, inside.x, inside.height}).setTo(value);
+  (*image)(cv::Rect{inside_right, inside.y, image->cols - inside_right,
+                    inside.height})
+      .setTo(value);
+}
+
+void PixelBufferReader::Create(int image_width, int image_height,
+                               int pixel_size) {
+  image_width_ = image_width;
+  image_height_ = image_height;
+  pixel_size_ = pixel_size;
+  glGenBuffers(1, &pbo_);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+  glBufferData(GL_PIXEL_PACK_BUFFER,
+               GLsizeiptr(image_width_) * image_height_ * pixel_size_, nullptr,
+               GL_STREAM_READ);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void PixelBufferReader::Delete() {
+  if (sync_) glDeleteSync(static_cast<GLsync>(sync_));
+  sync_ = nullptr;
+  if (pbo_) glDeleteBuffers(1, &pbo_);
+  pbo_ = 0;
+}
+
+void PixelBufferReader::StartReadback(unsigned format, unsigned type) {
+  StartReadback(format, type, cv::Rect{0, 0, image_width_, image_height_});
+}
+
+void PixelBufferReader::StartReadback(unsigned format, unsigned type,
+                                      const cv::Rect &region) {
+  region_ = region;
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+  glReadPixels(region_.x, region_.y, region_.width, region_.height, format,
+               type, nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (sync_) glDeleteSync(static_cast<GLsync>(sync_));
+  sync_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool PixelBufferReader::Fetch(cv::Mat *image) {
+  if (!sync_) return false;
+  glClientWaitSync(static_cast<GLsync>(sync_), GL_SYNC_FLUSH_COMMANDS_BIT,
+                   GL_TIMEOUT_IGNORED);
+  glDeleteSync(static_cast<GLsync>(sync_));
+  sync_ = nullptr;
+
+  // Copy rows from mapped buffer into region of image
+  if (region_.empty()) return true;
+  size_t row_size = size_t(region_.width) * pixel_size_;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_);
+  auto data{static_cast<const uchar *>(glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(row_size) * region_.height,
+      GL_MAP_READ_BIT))};
+  bool success = data != nullptr;
+  if (data) {
+    for (int v = 0; v < region_.height; ++v)
+      std::memcpy(image->ptr(region_.y + v) + size_t(region_.x) * pixel_size_,
+                  data + v * row_size, row_size);
+    success = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return success;
+}
+
 void Renderer::set_name(const std::string &name) {
   const std::lock_guard<std::mutex> lock{mutex_};
   name_ = name;
@@ -152,6 +289,30 @@ void Renderer::set_z_max(float z_max) {
   set_up_ = false;
 }
 
+void Renderer::set_use_pixel_buffer_readback(bool use_pixel_buffer_readback) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  use_pixel_buffer_readback_ = use_pixel_buffer_readback;
+  set_up_ = false;
+}
+
+void Renderer::set_context_id(int context_id) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  context_id_ = context_id;
+  set_up_ = false;
+}
+
+void Renderer::set_use_linear_depth(bool use_linear_depth) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  use_linear_depth_ = use_linear_depth;
+  set_up_ = false;
+}
+
+void Renderer::set_lod_max_pixel_error(float lod_max_pixel_error) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  lod_max_pixel_error_ = lod_max_pixel_error;
+  set_up_ = false;
+}
+
 const std::string &Renderer::name() const { return name_; }
 
 const std::filesystem::path &Renderer::metafile_path() const {
@@ -181,6 +342,16 @@ float Renderer::z_min() const { return z_min_; }
 
 float Renderer::z_max() const { return z_max_; }
 
+bool Renderer::use_pixel_buffer_readback() const {
+  return use_pixel_buffer_readback_;
+}
+
+int Renderer::context_id() const { return context_id_; }
+
+bool Renderer::use_linear_depth() const { return use_linear_depth_; }
+
+float Renderer::lod_max_pixel_error() const { return lod_max_pixel_error_; }
+
 bool Renderer::set_up() const { return set_up_; };
 
 const std::vector<std::shared_ptr<Body>> &Renderer::referenced_body_ptrs()
@@ -293,6 +464,17 @@ void FocusedRenderer::set_image_size(int image_size) {
   image_size_ = image_size;
 }
 
+void FocusedRenderer::set_render_cache_threshold(float render_cache_threshold) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  render_cache_threshold_ = render_cache_threshold;
+}
+
+void FocusedRenderer::set_use_region_readback(bool use_region_readback) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  use_region_readback_ = use_region_readback;
+  set_up_ = false;
+}
+
 bool FocusedRenderer::IsBodyReferenced(const std::string &body_name) const {
   return std::find_if(begin(referenced_body_ptrs_), end(referenced_body_ptrs_),
                       [&](const auto &body_ptr) {
@@ -312,12 +494,22 @@ const std::vector<std::shared_ptr<Body>>
 
 int FocusedRenderer::image_size() const { return image_size_; }
 
+float FocusedRenderer::render_cache_threshold() const {
+  return render_cache_threshold_;
+}
+
+bool FocusedRenderer::use_region_readback() const {
+  return use_region_readback_;
+}
+
 float FocusedRenderer::corner_u() const { return corner_u_; }
 
 float FocusedRenderer::corner_v() const { return corner_v_; }
 
 float FocusedRenderer::scale() const { return scale_; }
 
+const cv::Rect &FocusedRenderer::valid_region() const { return valid_region_; }
+
 FocusedRenderer::FocusedRenderer(
     const std::string &name,
     const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
@@ -402,6 +594,60 @@ void FocusedRenderer::CalculateProjectionMatrix() {
       2.0f * (ppv_scaled + 0.5f) / float(image_size_) - 1.0f, 0.0f, 0.0f, 0.0f,
       (z_max_ + z_min_) / (z_max_ - z_min_),
       -2.0f * z_max_ * z_min_ / (z_max_ - z_min_), 0.0f, 0.0f, 1.0f, 0.0f;
+
+  // Calculate region of focused image that contains referenced bodies
+  cv::Rect image_rect{0, 0, image_size_, image_size_};
+  if (!use_region_readback_) {
+    valid_region_ = image_rect;
+  } else if (visible_body_names_.empty()) {
+    valid_region_ = cv::Rect{};
+  } else {
+    int u_begin = int(std::floor((u_min - corner_u_) * scale_ - 0.5f));
+    int u_end = int(std::ceil((u_max - corner_u_) * scale_ + 0.5f)) + 1;
+    int v_begin = int(std::floor((v_min - corner_v_) * scale_ - 0.5f));
+    int v_end = int(std::ceil((v_max - corner_v_) * scale_ + 0.5f)) + 1;
+    valid_region_ =
+        cv::Rect{u_begin, v_begin, u_end - u_begin, v_end - v_begin} &
+        image_rect;
+  }
+}
+
+bool FocusedRenderer::IsRenderCacheValid() const {
+  if (!render_cache_valid_ || render_cache_threshold_ <= 0.0f) return false;
+  const auto body_ptrs{renderer_geometry_ptr_->CopyBodyPtrs()};
+  if (body_ptrs.size() != cached_body2world_poses_.size()) return false;
+  float f = std::max(intrinsics_.fu, intrinsics_.fv) * scale_;
+  for (size_t i = 0; i < body_ptrs.size(); ++i) {
+    Transform3fA body2camera_pose{world2camera_pose_ *
+                                  body_ptrs[i]->body2world_pose()};
+    Transform3fA cached_body2camera_pose{cached_world2camera_pose_ *
+                                         cached_body2world_poses_[i]};
+
+    // Bound displacement of points on bounding sphere of body
+    float r = 0.5f * body_ptrs[i]->maximum_body_diameter();
+    float z_near = std::min(body2camera_pose.translation()(2),
+                            cached_body2camera_pose.translation()(2)) -
+                   r;
+    if (z_near < z_min_) return false;
+    Eigen::AngleAxisf delta_rotation{
+        Eigen::Matrix3f{body2camera_pose.linear() *
+                        cached_body2camera_pose.linear().transpose()}};
+    float displacement = (body2camera_pose.translation() -
+                          cached_body2camera_pose.translation())
+                             .norm() +
+                         std::abs(delta_rotation.angle()) * r;
+    if (f * displacement / z_near > render_cache_threshold_) return false;
+  }
+  return true;
+}
+
+void FocusedRenderer::UpdateRenderCache() {
+  cached_world2camera_pose_ = world2camera_pose_;
+  const auto body_ptrs{renderer_geometry_ptr_->CopyBodyPtrs()};
+  cached_body2world_poses_.resize(body_ptrs.size());
+  for (size_t i = 0; i < body_ptrs.size(); ++i)
+    cached_body2world_poses_[i] = body_ptrs[i]->body2world_pose();
+  render_cache_valid_ = true;
 }
 
 cv::Mat FullDepthRenderer::NormalizedDepthImage(float min_depth,
@@ -417,8 +663,7 @@ cv::Mat FullDepthRenderer::NormalizedDepthImage(float min_depth,
     ptr_depth_image = depth_image_.ptr<ushort>(v);
     ptr_normalized_image = normalized_image.ptr<uchar>(v);
     for (u = 0; u < depth_image_.cols; ++u) {
-      depth = float(ptr_depth_image[u]);
-      depth = projection_term_a_ / (projection_term_b_ - depth);
+      depth = Depth(ptr_depth_image[u]);
       depth = std::min(std::max(depth - min_depth, 0.0f), delta_depth);
       ptr_normalized_image[u] = uchar(depth * scale);
     }
@@ -429,12 +674,13 @@ cv::Mat FullDepthRenderer::NormalizedDepthImage(float min_depth,
 const cv::Mat &FullDepthRenderer::depth_image() const { return depth_image_; }
 
 float FullDepthRenderer::Depth(ushort depth_image_value) const {
+  if (use_linear_depth_)
+    return projection_term_a_ + projection_term_b_ * float(depth_image_value);
   return projection_term_a_ / (projection_term_b_ - float(depth_image_value));
 }
 
 float FullDepthRenderer::Depth(const cv::Point2i &image_coordinate) const {
-  float depth_image_value = float(depth_image_.at<ushort>(image_coordinate));
-  return projection_term_a_ / (projection_term_b_ - depth_image_value);
+  return Depth(depth_image_.at<ushort>(image_coordinate));
 }
 
 ushort FullDepthRenderer::DepthImageValue(
@@ -444,8 +690,7 @@ ushort FullDepthRenderer::DepthImageValue(
 
 Eigen::Vector3f FullDepthRenderer::PointVector(
     const cv::Point2i &image_coordinate) const {
-  float depth_image_value = float(depth_image_.at<ushort>(image_coordinate));
-  float depth = projection_term_a_ / (projection_term_b_ - depth_image_value);
+  float depth = Depth(depth_image_.at<ushort>(image_coordinate));
   return Eigen::Vector3f{
       depth * (image_coordinate.x - intrinsics_.ppu) / intrinsics_.fu,
       depth * (image_coordinate.y - intrinsics_.ppv) / intrinsics_.fv, depth};
@@ -473,6 +718,11 @@ FullDepthRenderer::FullDepthRenderer(
     : FullRenderer{name, metafile_path, renderer_geometry_ptr, camera_ptr} {}
 
 void FullDepthRenderer::CalculateProjectionTerms() {
+  if (use_linear_depth_) {
+    projection_term_a_ = z_min_;
+    projection_term_b_ = (z_max_ - z_min_) / USHRT_MAX;
+    return;
+  }
   projection_term_a_ = z_max_ * z_min_ * USHRT_MAX / (z_max_ - z_min_);
   projection_term_b_ = z_max_ * USHRT_MAX / (z_max_ - z_min_);
 }
@@ -482,6 +732,27 @@ void FullDepthRenderer::ClearDepthImage() {
   depth_image_.setTo(cv::Scalar{0});
 }
 
+FocusedDepthRenderer::~FocusedDepthRenderer() {
+  if (atlas_ptr_) atlas_ptr_->DeleteRenderer(this);
+}
+
+void FocusedDepthRenderer::UseAtlas(
+    const std::shared_ptr<FocusedRendererAtlas> &atlas_ptr) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (atlas_ptr_ && atlas_ptr_ != atlas_ptr) atlas_ptr_->DeleteRenderer(this);
+  atlas_ptr_ = atlas_ptr;
+  use_atlas_ = true;
+  set_up_ = false;
+}
+
+void FocusedDepthRenderer::DoNotUseAtlas() {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (atlas_ptr_) atlas_ptr_->DeleteRenderer(this);
+  atlas_ptr_ = nullptr;
+  use_atlas_ = false;
+  set_up_ = false;
+}
+
 cv::Mat FocusedDepthRenderer::NormalizedFocusedDepthImage(
     float min_depth, float max_depth) const {
   cv::Mat normalized_image{focused_depth_image_.size(), CV_8UC1};
@@ -495,8 +766,7 @@ cv::Mat FocusedDepthRenderer::NormalizedFocusedDepthImage(
     ptr_depth_image = focused_depth_image_.ptr<ushort>(v);
     ptr_normalized_image = normalized_image.ptr<uchar>(v);
     for (u = 0; u < focused_depth_image_.cols; ++u) {
-      depth = float(ptr_depth_image[u]);
-      depth = projection_term_a_ / (projection_term_b_ - depth);
+      depth = Depth(ptr_depth_image[u]);
       depth = std::min(std::max(depth - min_depth, 0.0f), delta_depth);
       ptr_normalized_image[u] = uchar(depth * scale);
     }
@@ -508,15 +778,23 @@ const cv::Mat &FocusedDepthRenderer::focused_depth_image() const {
   return focused_depth_image_;
 }
 
+const std::shared_ptr<FocusedRendererAtlas> &FocusedDepthRenderer::atlas_ptr()
+    const {
+  return atlas_ptr_;
+}
+
+bool FocusedDepthRenderer::use_atlas() const { return use_atlas_; }
+
 float FocusedDepthRenderer::Depth(ushort depth_image_value) const {
+  if (use_linear_depth_)
+    return projection_term_a_ + projection_term_b_ * float(depth_image_value);
   return projection_term_a_ / (projection_term_b_ - float(depth_image_value));
 }
 
 float FocusedDepthRenderer::Depth(const cv::Point2i &image_coordinate) const {
   int u = int((image_coordinate.x - corner_u_) * scale_ + 0.5f);
   int v = int((image_coordinate.y - corner_v_) * scale_ + 0.5f);
-  float depth_image_value = float(focused_depth_image_.at<ushort>(v, u));
-  return projection_term_a_ / (projection_term_b_ - depth_image_value);
+  return Depth(focused_depth_image_.at<ushort>(v, u));
 }
 
 ushort FocusedDepthRenderer::DepthImageValue(
@@ -530,8 +808,7 @@ Eigen::Vector3f FocusedDepthRenderer::PointVector(
     const cv::Point2i &image_coordinate) const {
   int u = int((image_coordinate.x - corner_u_) * scale_ + 0.5f);
   int v = int((image_coordinate.y - corner_v_) * scale_ + 0.5f);
-  float depth_image_value = float(focused_depth_image_.at<ushort>(v, u));
-  float depth = projection_term_a_ / (projection_term_b_ - depth_image_value);
+  float depth = Depth(focused_depth_image_.at<ushort>(v, u));
   return Eigen::Vector3f{
       depth * (image_coordinate.x - intrinsics_.ppu) / intrinsics_.fu,
       depth * (image_coordinate.y - intrinsics_.ppv) / intrinsics_.fv, depth};
@@ -565,10 +842,34 @@ FocusedDepthRenderer::FocusedDepthRenderer(
     : FocusedRenderer{name, metafile_path, renderer_geometry_ptr, camera_ptr} {}
 
 void FocusedDepthRenderer::CalculateProjectionTerms() {
+  if (use_linear_depth_) {
+    projection_term_a_ = z_min_;
+    projection_term_b_ = (z_max_ - z_min_) / USHRT_MAX;
+    return;
+  }
   projection_term_a_ = z_max_ * z_min_ * USHRT_MAX / (z_max_ - z_min_);
   projection_term_b_ = z_max_ * USHRT_MAX / (z_max_ - z_min_);
 }
 
+bool FocusedDepthRenderer::SetUpAtlas(IDType id_type) {
+  if (!atlas_ptr_->set_up()) {
+    std::cerr << "Atlas " << atlas_ptr_->name() << " was not set up"
+              << std::endl;
+    return false;
+  }
+  if (atlas_ptr_->renderer_geometry_ptr() != renderer_geometry_ptr_) {
+    std::cerr << "Renderer geometry of atlas " << atlas_ptr_->name()
+              << " differs from that of renderer " << name_ << std::endl;
+    return false;
+  }
+  if (use_linear_depth_) {
+    std::cerr << "Renderer " << name_
+              << " cannot use linear depth together with an atlas" << std::endl;
+    return false;
+  }
+  return atlas_ptr_->AddRenderer(this, id_type);
+}
+
 void FocusedDepthRenderer::ClearDepthImage() {
   focused_depth_image_.create(cv::Size{image_size_, image_size_}, CV_16U);
   focused_depth_image_.setTo(cv::Scalar{0});
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/renderer_atlas.h>
+
+namespace m3t {
+
+FocusedRendererAtlas::FocusedRendererAtlas(
+    const std::string &name,
+    const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+    int max_width)
+    : name_{name},
+      renderer_geometry_ptr_{renderer_geometry_ptr},
+      max_width_{max_width} {}
+
+bool FocusedRendererAtlas::SetUp() {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  set_up_ = false;
+  if (!renderer_geometry_ptr_->set_up()) {
+    std::cerr << "Renderer geometry " << renderer_geometry_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
+  layout_changed_ = true;
+  rendered_ = false;
+  set_up_ = true;
+  return true;
+}
+
+void FocusedRendererAtlas::set_name(const std::string &name) { name_ = name; }
+
+void FocusedRendererAtlas::set_renderer_geometry_ptr(
+    const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  renderer_geometry_ptr_ = renderer_geometry_ptr;
+  set_up_ = false;
+}
+
+void FocusedRendererAtlas::set_max_width(int max_width) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  max_width_ = max_width;
+  layout_changed_ = true;
+}
+
+bool FocusedRendererAtlas::AddRenderer(FocusedDepthRenderer *renderer_ptr,
+                                       IDType id_type) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (renderer_ptr->image_size() > max_width_) {
+    std::cerr << "Image size of renderer " << renderer_ptr->name()
+              << " exceeds maximum width of atlas " << name_ << std::endl;
+    return false;
+  }
+  Tile *tile_ptr = FindTile(renderer_ptr);
+  if (tile_ptr) {
+    if (tile_ptr->rect.width != renderer_ptr->image_size())
+      layout_changed_ = true;
+    tile_ptr->id_type = id_type;
+  } else {
+    Tile tile;
+    tile.renderer_ptr = renderer_ptr;
+    tile.id_type = id_type;
+    tiles_.push_back(std::move(tile));
+    layout_changed_ = true;
+  }
+  rendered_ = false;
+  return true;
+}
+
+bool FocusedRendererAtlas::DeleteRenderer(
+    const FocusedDepthRenderer *renderer_ptr) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  size_t n_tiles = tiles_.size();
+  tiles_.erase(std::remove_if(begin(tiles_), end(tiles_),
+                              [&](const Tile &tile) {
+                                return tile.renderer_ptr == renderer_ptr;
+                              }),
+               end(tiles_));
+  if (tiles_.size() == n_tiles) return false;
+  layout_changed_ = true;
+  rendered_ = false;
+  return true;
+}
+
+bool FocusedRendererAtlas::StartRendering(
+    const FocusedDepthRenderer *renderer_ptr) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  if (!set_up_) {
+    std::cerr << "Set up atlas " << name_ << " first" << std::endl;
+    return false;
+  }
+  Tile *tile_ptr = FindTile(renderer_ptr);
+  if (!tile_ptr) {
+    std::cerr << "Renderer " << renderer_ptr->name()
+              << " was not added to atlas " << name_ << std::endl;
+    return false;
+  }
+  if (layout_changed_ && !UpdateLayout()) return false;
+  if (rendered_ && !IsTileOutdated(*tile_ptr)) return true;
+  RenderTiles(renderer_ptr);
+  return rendered_;
+}
+
+bool FocusedRendererAtlas::FetchSilhouetteImage(
+    const FocusedDepthRenderer *renderer_ptr,
+    cv::Mat *focused_silhouette_image) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  const Tile *tile_ptr = FindTile(renderer_ptr);
+  if (!rendered_ || !tile_ptr) return false;
+  if (!core_.FetchSilhouetteImage(&silhouette_image_)) return false;
+  silhouette_image_(tile_ptr->rect).copyTo(*focused_silhouette_image);
+  return true;
+}
+
+bool FocusedRendererAtlas::FetchDepthImage(
+    const FocusedDepthRenderer *renderer_ptr, cv::Mat *focused_depth_image) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  const Tile *tile_ptr = FindTile(renderer_ptr);
+  if (!rendered_ || !tile_ptr) return false;
+  if (!core_.FetchDepthImage(&depth_image_)) return false;
+  depth_image_(tile_ptr->rect).copyTo(*focused_depth_image);
+  return true;
+}
+
+const std::string &FocusedRendererAtlas::name() const { return name_; }
+
+const std::shared_ptr<RendererGeometry>
+    &FocusedRendererAtlas::renderer_geometry_ptr() const {
+  return renderer_geometry_ptr_;
+}
+
+int FocusedRendererAtlas::max_width() const { return max_width_; }
+
+int FocusedRendererAtlas::n_tiles() const { return int(tiles_.size()); }
+
+const cv::Mat &FocusedRendererAtlas::silhouette_image() const {
+  return silhouette_image_;
+}
+
+const cv::Mat &FocusedRendererAtlas::depth_image() const {
+  return depth_image_;
+}
+
+bool FocusedRendererAtlas::set_up() const { return set_up_; }
+
+FocusedRendererAtlas::Tile *FocusedRendererAtlas::FindTile(
+    const FocusedDepthRenderer *renderer_ptr) {
+  for (auto &tile : tiles_) {
+    if (tile.renderer_ptr == renderer_ptr) return &tile;
+  }
+  return nullptr;
+}
+
+bool FocusedRendererAtlas::UpdateLayout() {
+  // Pack tiles into rows, starting with the largest ones
+  std::vector<Tile *> tile_ptrs;
+  for (auto &tile : tiles_) tile_ptrs.push_back(&tile);
+  std::stable_sort(begin(tile_ptrs), end(tile_ptrs),
+                   [](const Tile *tile1, const Tile *tile2) {
+                     return tile1->renderer_ptr->image_size() >
+                            tile2->renderer_ptr->image_size();
+                   });
+  int width = 0;
+  int x = 0;
+  int y = 0;
+  int row_height = 0;
+  for (auto tile_ptr : tile_ptrs) {
+    int image_size = tile_ptr->renderer_ptr->image_size();
+    if (x + image_size > max_width_) {
+      x = 0;
+      y += row_height;
+      row_height = 0;
+    }
+    tile_ptr->rect = cv::Rect{x, y, image_size, image_size};
+    x += image_size;
+    width = std::max(width, x);
+    row_height = std::max(row_height, image_size);
+  }
+  int height = y + row_height;
+  if (width == 0 || height == 0) return false;
+
+  // Set up core and images with atlas size
+  if (!core_.SetUp(renderer_geometry_ptr_, width, height)) return false;
+  silhouette_image_.create(cv::Size{width, height}, CV_8U);
+  silhouette_image_.setTo(cv::Scalar{0});
+  depth_image_.create(cv::Size{width, height}, CV_16U);
+  depth_image_.setTo(cv::Scalar{0});
+  core_tiles_.resize(tiles_.size());
+  layout_changed_ = false;
+  rendered_ = false;
+  return true;
+}
+
+bool FocusedRendererAtlas::IsTileOutdated(const Tile &tile) const {
+  const auto &render_data_bodies{renderer_geometry_ptr_->render_data_bodies()};
+  if (render_data_bodies.size() != rendered_body2world_poses_.size())
+    return true;
+  for (size_t i = 0; i < render_data_bodies.size(); ++i) {
+    if (render_data_bodies[i].body_ptr->body2world_pose().matrix() !=
+        rendered_body2world_poses_[i].matrix())
+      return true;
+  }
+  return tile.projection_matrix != tile.renderer_ptr->projection_matrix_ ||
+         tile.world2camera_pose.matrix() !=
+             tile.renderer_ptr->world2camera_pose().matrix();
+}
+
+void FocusedRendererAtlas::RenderTiles(
+    const FocusedDepthRenderer *renderer_ptr) {
+  // Collect projections of all tiles. The calling renderer already holds its
+  // mutex. Renderers lock their mutex before the one of the atlas. Other
+  // renderers are therefore only locked if possible without waiting. Their
+  // projection is never recalculated, since it has to stay consistent with
+  // their previously fetched images. Only the projection they published
+  // during their last rendering is used. Busy renderers keep their previous
+  // tile and will find it outdated when they start rendering.
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    Tile &tile{tiles_[i]};
+    std::unique_lock<std::mutex> renderer_lock;
+    if (tile.renderer_ptr != renderer_ptr)
+      renderer_lock = std::unique_lock<std::mutex>{tile.renderer_ptr->mutex_,
+                                                   std::try_to_lock};
+    if (tile.renderer_ptr == renderer_ptr || renderer_lock.owns_lock()) {
+      tile.projection_matrix = tile.renderer_ptr->projection_matrix_;
+      tile.world2camera_pose = tile.renderer_ptr->world2camera_pose();
+    }
+    core_tiles_[i] = SilhouetteRendererCore::Tile{
+        tile.rect, tile.projection_matrix, tile.world2camera_pose,
+        tile.id_type};
+  }
+
+  // Save body poses used for rendering
+  const auto &render_data_bodies{renderer_geometry_ptr_->render_data_bodies()};
+  rendered_body2world_poses_.resize(render_data_bodies.size());
+  for (size_t i = 0; i < render_data_bodies.size(); ++i)
+    rendered_body2world_poses_[i] =
+        render_data_bodies[i].body_ptr->body2world_pose();
+
+  rendered_ = core_.StartRendering(core_tiles_);
+}
+
+}  // namespace m3t
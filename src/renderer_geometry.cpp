@@ -6,25 +6,30 @@
 namespace m3t {
 
 int RendererGeometry::n_instances_ = 0;
-
-RendererGeometry::RendererGeometry(const std::string &name) : name_{name} {}
+#ifdef USE_EGL
+int RendererGeometry::n_egl_instances_ = 0;
+EGLDisplay RendererGeometry::egl_display_ = EGL_NO_DISPLAY;
+EGLConfig RendererGeometry::egl_config_ = nullptr;
+bool RendererGeometry::egl_pbuffer_supported_ = false;
+std::mutex RendererGeometry::egl_mutex_{};
+#endif
+
+RendererGeometry::RendererGeometry(const std::string &name, int n_contexts,
+                                   ContextBackend backend)
+    : name_{name}, n_contexts_{n_contexts}, backend_{backend} {}
 
 RendererGeometry::~RendererGeometry() {
   if (initial_set_up_) {
-    glfwMakeContextCurrent(window_);
     for (auto &render_data_body : render_data_bodies_) {
       DeleteGLVertexObjects(&render_data_body);
     }
-    glfwMakeContextCurrent(0);
-    glfwDestroyWindow(window_);
-    window_ = nullptr;
-    n_instances_--;
-    if (n_instances_ == 0) glfwTerminate();
+    TerminateBackend();
   }
 }
 
 bool RendererGeometry::SetUp() {
   const std::lock_guard<std::mutex> lock{mutex_};
+  auto context_locks{LockAllContexts()};
   set_up_ = false;
 
   // Check if all required objects are set up
@@ -35,62 +40,62 @@ bool RendererGeometry::SetUp() {
       return false;
     }
   }
+  if (n_contexts_ < 1) {
+    std::cerr << "Number of contexts of renderer geometry " << name_
+              << " has to be at least 1" << std::endl;
+    return false;
+  }
 
-  // Set up GLFW
-  if (!initial_set_up_) {
-    if (!glfwInit()) {
-      std::cerr << "Failed to initialize GLFW" << std::endl;
-      return false;
-    }
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
-    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
-
-    window_ = glfwCreateWindow(640, 480, "window", nullptr, nullptr);
-    if (window_ == nullptr) {
-      std::cerr << "Failed to create GLFW window" << std::endl;
-      glfwTerminate();
-      return false;
-    }
-
-    glfwMakeContextCurrent(window_);
-    glewExperimental = true;
-    if (glewInit() != GLEW_OK) {
-      std::cerr << "Failed to initialize GLEW" << std::endl;
-      glfwDestroyWindow(window_);
-      window_ = nullptr;
-      glfwTerminate();
-      return false;
+  // Terminate previous backend if it was changed
+  if (initial_set_up_ && backend_ != initialized_backend_) {
+    for (auto &render_data_body : render_data_bodies_) {
+      DeleteGLVertexObjects(&render_data_body);
     }
-    glfwMakeContextCurrent(nullptr);
+    TerminateBackend();
+    initial_set_up_ = false;
+  }
 
-    n_instances_++;
+  // Set up backend and primary context
+  if (!initial_set_up_) {
+    if (!InitializeBackend()) return false;
     initial_set_up_ = true;
   }
 
-  // Set up bodies
-  glfwMakeContextCurrent(window_);
+  // Only add or remove shared contexts if their number changed since
+  // renderers keep framebuffer objects that belong to existing contexts
   for (auto &render_data_body : render_data_bodies_) {
-    // Assemble vertex data
-    std::vector<float> vertex_data;
-    AssembleVertexData(*render_data_body.body_ptr, &vertex_data);
-    render_data_body.n_vertices = unsigned(vertex_data.size()) / 6;
-
-    // Create GL Vertex objects
-    if (set_up_) DeleteGLVertexObjects(&render_data_body);
-    CreateGLVertexObjects(vertex_data, &render_data_body);
+    DeleteGLVertexObjects(&render_data_body);
+  }
+  while (int(context_mutexes_.size()) < n_contexts_)
+    context_mutexes_.push_back(std::make_unique<std::mutex>());
+  if (int(contexts_.size()) != n_contexts_) {
+    DestroySharedContexts(n_contexts_);
+    if (!CreateSharedContexts()) return false;
   }
-  glfwMakeContextCurrent(nullptr);
+
+  // Set up bodies
+  for (auto &render_data_body : render_data_bodies_)
+    SetUpGLVertexObjects(&render_data_body);
 
   set_up_ = true;
   return true;
 }
 
+void RendererGeometry::set_n_contexts(int n_contexts) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  n_contexts_ = n_contexts;
+  set_up_ = false;
+}
+
+void RendererGeometry::set_backend(ContextBackend backend) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  backend_ = backend;
+  set_up_ = false;
+}
+
 bool RendererGeometry::AddBody(const std::shared_ptr<Body> &body_ptr) {
   const std::lock_guard<std::mutex> lock{mutex_};
+  auto context_locks{LockAllContexts()};
 
   // Check if renderer geometry for body already exists
   for (auto &p : body_ptrs_) {
@@ -105,15 +110,7 @@ bool RendererGeometry::AddBody(const std::shared_ptr<Body> &body_ptr) {
   RenderDataBody render_data_body;
   render_data_body.body_ptr = body_ptr.get();
   if (set_up_ && body_ptr->set_up()) {
-    // Assemble vertex data
-    std::vector<float> vertex_data;
-    AssembleVertexData(*body_ptr.get(), &vertex_data);
-    render_data_body.n_vertices = unsigned(vertex_data.size()) / 6;
-
-    // Create GL Vertex objects
-    glfwMakeContextCurrent(window_);
-    CreateGLVertexObjects(vertex_data, &render_data_body);
-    glfwMakeContextCurrent(nullptr);
+    SetUpGLVertexObjects(&render_data_body);
   } else if (set_up_ && !body_ptr->set_up()) {
     set_up_ = false;
   }
@@ -126,14 +123,11 @@ bool RendererGeometry::AddBody(const std::shared_ptr<Body> &body_ptr) {
 
 bool RendererGeometry::DeleteBody(const std::string &name) {
   const std::lock_guard<std::mutex> lock{mutex_};
+  auto context_locks{LockAllContexts()};
   for (size_t i = 0; i < body_ptrs_.size(); ++i) {
     if (name == body_ptrs_[i]->name()) {
       body_ptrs_.erase(begin(body_ptrs_) + i);
-      if (set_up_) {
-        glfwMakeContextCurrent(window_);
-        DeleteGLVertexObjects(&render_data_bodies_[i]);
-        glfwMakeContextCurrent(nullptr);
-      }
+      if (initial_set_up_) DeleteGLVertexObjects(&render_data_bodies_[i]);
       render_data_bodies_.erase(begin(render_data_bodies_) + i);
       return true;
     }
@@ -144,40 +138,73 @@ bool RendererGeometry::DeleteBody(const std::string &name) {
 
 void RendererGeometry::ClearBodies() {
   const std::lock_guard<std::mutex> lock{mutex_};
-  if (set_up_) {
-    glfwMakeContextCurrent(window_);
+  auto context_locks{LockAllContexts()};
+  if (initial_set_up_) {
     for (auto &render_data_body : render_data_bodies_) {
       DeleteGLVertexObjects(&render_data_body);
     }
-    glfwMakeContextCurrent(nullptr);
   }
   render_data_bodies_.clear();
   body_ptrs_.clear();
 }
 
-bool RendererGeometry::MakeContextCurrent() {
-  mutex_.lock();
-  if (!initial_set_up_) {
-    std::cerr << "Set up renderer geometry " << name_ << " first" << std::endl;
-    mutex_.unlock();
+std::vector<std::shared_ptr<Body>> RendererGeometry::CopyBodyPtrs() {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  return body_ptrs_;
+}
+
+bool RendererGeometry::MakeContextCurrent(int context_id) {
+  std::mutex *context_mutex;
+  {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (!initial_set_up_) {
+      std::cerr << "Set up renderer geometry " << name_ << " first"
+                << std::endl;
+      return false;
+    }
+    if (context_id < 0 || context_id >= int(contexts_.size())) {
+      std::cerr << "Context " << context_id << " of renderer geometry "
+                << name_ << " does not exist" << std::endl;
+      return false;
+    }
+    context_mutex = context_mutexes_[context_id].get();
+  }
+
+  // Contexts are only changed while all context mutexes are locked. The
+  // context might have been removed before its mutex was obtained
+  context_mutex->lock();
+  if (context_id >= int(contexts_.size())) {
+    context_mutex->unlock();
+    std::cerr << "Context " << context_id << " of renderer geometry " << name_
+              << " does not exist" << std::endl;
     return false;
   }
-  glfwMakeContextCurrent(window_);
+  ActivateContext(&contexts_[context_id]);
   return true;
 }
 
-bool RendererGeometry::DetachContext() {
+bool RendererGeometry::DetachContext(int context_id) {
+  // Contexts cannot change while the context mutex is held by the caller
   if (!initial_set_up_) {
     std::cerr << "Set up renderer geometry " << name_ << " first" << std::endl;
     return false;
   }
-  glfwMakeContextCurrent(nullptr);
-  mutex_.unlock();
+  if (context_id < 0 || context_id >= int(contexts_.size())) {
+    std::cerr << "Context " << context_id << " of renderer geometry " << name_
+              << " does not exist" << std::endl;
+    return false;
+  }
+  ActivateContext(nullptr);
+  context_mutexes_[context_id]->unlock();
   return true;
 }
 
 const std::string &RendererGeometry::name() const { return name_; }
 
+int RendererGeometry::n_contexts() const { return n_contexts_; }
+
+ContextBackend RendererGeometry::backend() const { return backend_; }
+
 const std::vector<std::shared_ptr<Body>> &RendererGeometry::body_ptrs() const {
   return body_ptrs_;
 }
@@ -189,12 +216,70 @@ const std::vector<RendererGeometry::RenderDataBody>
 
 bool RendererGeometry::set_up() const { return set_up_; }
 
+void RendererGeometry::SetUpGLVertexObjects(RenderDataBody *render_data_body) {
+  if (ShareGLVertexObjects(render_data_body)) return;
+
+  // Assemble vertex data
+  std::vector<float> vertex_data;
+  AssembleVertexData(*render_data_body->body_ptr, &vertex_data,
+                     render_data_body);
+
+  // Create GL Vertex objects
+  CreateGLVertexObjects(vertex_data, render_data_body);
+}
+
+bool RendererGeometry::ShareGLVertexObjects(
+    RenderDataBody *render_data_body) const {
+  for (const auto &other : render_data_bodies_) {
+    if (&other == render_data_body || !other.vbo ||
+        !HasEqualGeometry(*other.body_ptr, *render_data_body->body_ptr))
+      continue;
+    render_data_body->vao = other.vao;
+    render_data_body->vbo = other.vbo;
+    render_data_body->n_vertices = other.n_vertices;
+    render_data_body->shared_vaos = other.shared_vaos;
+    render_data_body->lod_first_vertices = other.lod_first_vertices;
+    render_data_body->lod_n_vertices = other.lod_n_vertices;
+    return true;
+  }
+  return false;
+}
+
+bool RendererGeometry::HasEqualGeometry(const Body &body_1,
+                                        const Body &body_2) {
+  return body_1.geometry_path() == body_2.geometry_path() &&
+         body_1.geometry_unit_in_meter() == body_2.geometry_unit_in_meter() &&
+         body_1.geometry_counterclockwise() ==
+             body_2.geometry_counterclockwise() &&
+         body_1.n_lod_levels() == body_2.n_lod_levels() &&
+         body_1.lod_reduction_factor() == body_2.lod_reduction_factor();
+}
+
 void RendererGeometry::AssembleVertexData(const Body &body,
-                                          std::vector<float> *vertex_data) {
-  for (const auto &triangle_indices : body.mesh_indices()) {
+                                          std::vector<float> *vertex_data,
+                                          RenderDataBody *render_data_body) {
+  AppendVertexData(body.vertices(), body.mesh_indices(), vertex_data);
+  render_data_body->n_vertices = unsigned(vertex_data->size()) / 6;
+
+  // Append levels of detail
+  render_data_body->lod_first_vertices.clear();
+  render_data_body->lod_n_vertices.clear();
+  for (const auto &lod_mesh : body.lod_meshes()) {
+    unsigned first_vertex = unsigned(vertex_data->size()) / 6;
+    AppendVertexData(lod_mesh.vertices, lod_mesh.mesh_indices, vertex_data);
+    render_data_body->lod_first_vertices.push_back(first_vertex);
+    render_data_body->lod_n_vertices.push_back(
+        unsigned(vertex_data->size()) / 6 - first_vertex);
+  }
+}
+
+void RendererGeometry::AppendVertexData(
+    const std::vector<Eigen::Vector3f> &vertices,
+    const std::vector<std::array<int, 3>> &mesh_indices,
+    std::vector<float> *vertex_data) {
+  for (const auto &triangle_indices : mesh_indices) {
     std::array<Eigen::Vector3f, 3> points;
-    for (int i = 0; i < 3; ++i)
-      points[i] = body.vertices()[triangle_indices[i]];
+    for (int i = 0; i < 3; ++i) points[i] = vertices[triangle_indices[i]];
 
     Eigen::Vector3f normal{
         (points[2] - points[1]).cross(points[0] - points[1]).normalized()};
@@ -208,13 +293,53 @@ void RendererGeometry::AssembleVertexData(const Body &body,
 
 void RendererGeometry::CreateGLVertexObjects(const std::vector<float> &vertices,
                                              RenderDataBody *render_data_body) {
-  glGenVertexArrays(1, &render_data_body->vao);
-  glBindVertexArray(render_data_body->vao);
-
+  ActivateContext(&contexts_[0]);
   glGenBuffers(1, &render_data_body->vbo);
   glBindBuffer(GL_ARRAY_BUFFER, render_data_body->vbo);
   glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
                &vertices.front(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  CreateGLVertexArray(render_data_body->vbo, &render_data_body->vao);
+  glFinish();
+
+  // Vertex array objects are not shared and are created for each context
+  render_data_body->shared_vaos.resize(contexts_.size() - 1);
+  for (size_t i = 1; i < contexts_.size(); ++i) {
+    ActivateContext(&contexts_[i]);
+    CreateGLVertexArray(render_data_body->vbo,
+                        &render_data_body->shared_vaos[i - 1]);
+  }
+  ActivateContext(nullptr);
+}
+
+void RendererGeometry::DeleteGLVertexObjects(RenderDataBody *render_data_body) {
+  // Vertex objects are only deleted if no other body shares them
+  for (const auto &other : render_data_bodies_) {
+    if (&other != render_data_body && other.vbo == render_data_body->vbo) {
+      render_data_body->shared_vaos.clear();
+      render_data_body->vbo = 0;
+      render_data_body->vao = 0;
+      return;
+    }
+  }
+
+  for (size_t i = 0; i < render_data_body->shared_vaos.size(); ++i) {
+    ActivateContext(&contexts_[i + 1]);
+    glDeleteVertexArrays(1, &render_data_body->shared_vaos[i]);
+  }
+  render_data_body->shared_vaos.clear();
+  ActivateContext(&contexts_[0]);
+  glDeleteBuffers(1, &render_data_body->vbo);
+  glDeleteVertexArrays(1, &render_data_body->vao);
+  render_data_body->vbo = 0;
+  render_data_body->vao = 0;
+  ActivateContext(nullptr);
+}
+
+void RendererGeometry::CreateGLVertexArray(GLuint vbo, GLuint *vao) {
+  glGenVertexArrays(1, vao);
+  glBindVertexArray(*vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
   glEnableVertexAttribArray(0);
@@ -226,9 +351,237 @@ void RendererGeometry::CreateGLVertexObjects(const std::vector<float> &vertices,
   glBindVertexArray(0);
 }
 
-void RendererGeometry::DeleteGLVertexObjects(RenderDataBody *render_data_body) {
-  glDeleteBuffers(1, &render_data_body->vbo);
-  glDeleteVertexArrays(1, &render_data_body->vao);
+bool RendererGeometry::InitializeBackend() {
+  // Initialize library
+  if (backend_ == ContextBackend::GLFW) {
+    if (!glfwInit()) {
+      std::cerr << "Failed to initialize GLFW" << std::endl;
+      return false;
+    }
+    n_instances_++;
+  } else {
+#ifdef USE_EGL
+    const std::lock_guard<std::mutex> lock{egl_mutex_};
+    if (n_egl_instances_ == 0 && !InitializeEGLDisplay()) return false;
+    n_egl_instances_++;
+#else
+    std::cerr << "EGL backend is not available. Compile with USE_EGL"
+              << std::endl;
+    return false;
+#endif
+  }
+  initialized_backend_ = backend_;
+
+  // Create primary context and initialize GLEW
+  contexts_.resize(1);
+  if (!CreateContext(nullptr, &contexts_[0])) {
+    TerminateBackend();
+    return false;
+  }
+  ActivateContext(&contexts_[0]);
+  glewExperimental = true;
+  GLenum glew_error = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // GLEW built for GLX reports a missing display for EGL contexts
+  if (initialized_backend_ == ContextBackend::EGL &&
+      glew_error == GLEW_ERROR_NO_GLX_DISPLAY)
+    glew_error = GLEW_OK;
+#endif
+  ActivateContext(nullptr);
+  if (glew_error != GLEW_OK) {
+    std::cerr << "Failed to initialize GLEW" << std::endl;
+    TerminateBackend();
+    return false;
+  }
+  return true;
+}
+
+void RendererGeometry::TerminateBackend() {
+  for (auto &context : contexts_) DestroyContext(&context);
+  contexts_.clear();
+  if (initialized_backend_ == ContextBackend::GLFW) {
+    n_instances_--;
+    if (n_instances_ == 0) glfwTerminate();
+  } else {
+#ifdef USE_EGL
+    const std::lock_guard<std::mutex> lock{egl_mutex_};
+    n_egl_instances_--;
+    if (n_egl_instances_ == 0) {
+      eglTerminate(egl_display_);
+      egl_display_ = EGL_NO_DISPLAY;
+    }
+    eglReleaseThread();
+#endif
+  }
+}
+
+bool RendererGeometry::CreateContext(const Context *share_context,
+                                     Context *context) const {
+  if (initialized_backend_ == ContextBackend::GLFW) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    context->window =
+        glfwCreateWindow(640, 480, "window", nullptr,
+                         share_context ? share_context->window : nullptr);
+    if (context->window == nullptr) {
+      std::cerr << "Failed to create GLFW window" << std::endl;
+      return false;
+    }
+    return true;
+  }
+#ifdef USE_EGL
+  const EGLint context_attributes[]{EGL_CONTEXT_MAJOR_VERSION,
+                                    3,
+                                    EGL_CONTEXT_MINOR_VERSION,
+                                    3,
+                                    EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                    EGL_NONE};
+  eglBindAPI(EGL_OPENGL_API);
+  context->egl_context = eglCreateContext(
+      egl_display_, egl_config_,
+      share_context ? share_context->egl_context : EGL_NO_CONTEXT,
+      context_attributes);
+  if (context->egl_context == EGL_NO_CONTEXT) {
+    std::cerr << "Failed to create EGL context" << std::endl;
+    return false;
+  }
+
+  // Contexts only render into framebuffer objects and use a minimal pbuffer
+  // surface if surfaceless contexts are not supported
+  if (egl_pbuffer_supported_) {
+    const EGLint surface_attributes[]{EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    context->egl_surface =
+        eglCreatePbufferSurface(egl_display_, egl_config_, surface_attributes);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RendererGeometry::DestroyContext(Context *context) const {
+  if (initialized_backend_ == ContextBackend::GLFW) {
+    if (context->window) glfwDestroyWindow(context->window);
+    context->window = nullptr;
+    return;
+  }
+#ifdef USE_EGL
+  if (context->egl_surface != EGL_NO_SURFACE)
+    eglDestroySurface(egl_display_, context->egl_surface);
+  if (context->egl_context != EGL_NO_CONTEXT)
+    eglDestroyContext(egl_display_, context->egl_context);
+  context->egl_surface = EGL_NO_SURFACE;
+  context->egl_context = EGL_NO_CONTEXT;
+#endif
+}
+
+void RendererGeometry::ActivateContext(const Context *context) const {
+  if (initialized_backend_ == ContextBackend::GLFW) {
+    glfwMakeContextCurrent(context ? context->window : nullptr);
+    return;
+  }
+#ifdef USE_EGL
+  eglBindAPI(EGL_OPENGL_API);
+  if (context)
+    eglMakeCurrent(egl_display_, context->egl_surface, context->egl_surface,
+                   context->egl_context);
+  else
+    eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+#endif
+}
+
+bool RendererGeometry::CreateSharedContexts() {
+  while (int(contexts_.size()) < n_contexts_) {
+    Context context;
+    if (!CreateContext(&contexts_[0], &context)) return false;
+    contexts_.push_back(context);
+  }
+  return true;
+}
+
+void RendererGeometry::DestroySharedContexts(int n_remaining_contexts) {
+  n_remaining_contexts = std::max(n_remaining_contexts, 1);
+  while (int(contexts_.size()) > n_remaining_contexts) {
+    DestroyContext(&contexts_.back());
+    contexts_.pop_back();
+  }
+}
+
+std::vector<std::unique_lock<std::mutex>> RendererGeometry::LockAllContexts() {
+  std::vector<std::unique_lock<std::mutex>> locks;
+  for (auto &context_mutex : context_mutexes_)
+    locks.emplace_back(*context_mutex);
+  return locks;
+}
+
+#ifdef USE_EGL
+bool RendererGeometry::InitializeEGLDisplay() {
+  auto egl_query_devices{reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+      eglGetProcAddress("eglQueryDevicesEXT"))};
+  auto egl_get_platform_display{
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"))};
+
+  // Prefer displays of GPU devices that do not require a window system
+  egl_display_ = EGL_NO_DISPLAY;
+  if (egl_query_devices && egl_get_platform_display) {
+    constexpr EGLint kMaxNDevices = 16;
+    EGLDeviceEXT devices[kMaxNDevices];
+    EGLint n_devices = 0;
+    if (egl_query_devices(kMaxNDevices, devices, &n_devices)) {
+      for (int i = 0; i < n_devices && egl_display_ == EGL_NO_DISPLAY; ++i) {
+        EGLDisplay display = egl_get_platform_display(EGL_PLATFORM_DEVICE_EXT,
+                                                      devices[i], nullptr);
+        if (display != EGL_NO_DISPLAY &&
+            eglInitialize(display, nullptr, nullptr))
+          egl_display_ = display;
+      }
+    }
+  }
+
+  // Fall back to surfaceless Mesa platform that also supports llvmpipe
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  if (egl_display_ == EGL_NO_DISPLAY && egl_get_platform_display) {
+    EGLDisplay display = egl_get_platform_display(
+        EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+      egl_display_ = display;
+  }
+#endif
+  if (egl_display_ == EGL_NO_DISPLAY) {
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr))
+      egl_display_ = display;
+  }
+  if (egl_display_ == EGL_NO_DISPLAY) {
+    std::cerr << "Failed to initialize EGL display" << std::endl;
+    return false;
+  }
+
+  // Choose config, preferably with support for pbuffer surfaces
+  EGLint config_attributes[]{EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                             EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+  EGLint n_configs = 0;
+  egl_pbuffer_supported_ = eglChooseConfig(egl_display_, config_attributes,
+                                           &egl_config_, 1, &n_configs) &&
+                           n_configs > 0;
+  if (!egl_pbuffer_supported_) {
+    if (!eglChooseConfig(egl_display_, config_attributes + 2, &egl_config_, 1,
+                         &n_configs) ||
+        n_configs == 0) {
+      std::cerr << "Failed to choose EGL config" << std::endl;
+      eglTerminate(egl_display_);
+      egl_display_ = EGL_NO_DISPLAY;
+      return false;
+    }
+  }
+  return true;
 }
+#endif
 
 }  // namespace m3t
@@ -32,6 +32,7 @@ void RosColorCamera::set_ros_color_image(cv::Mat &ros_color_image) {
   const std::lock_guard<std::mutex> lock{mutex_};
   //ros_color_image_ = ros_color_image;
   image_ = ros_color_image;
+  image_index_++;
 }
 
 void RosColorCamera::set_intrinsics(const Intrinsics &intrinsics) {
@@ -121,6 +122,7 @@ void RosDepthCamera::set_ros_depth_image(cv::Mat &ros_depth_image) {
   // THIS NEEDS TO BE DONE BETTER...
   const std::lock_guard<std::mutex> lock{mutex_};
   image_ = ros_depth_image;
+  image_index_++;
 }
 
 bool RosDepthCamera::UpdateImage(bool synchronized) {
@@ -3,6 +3,8 @@
 
 #include "m3t/silhouette_renderer.h"
 
+#include <m3t/renderer_atlas.h>
+
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
@@ -11,42 +13,82 @@ namespace m3t {
 std::string SilhouetteRendererCore::vertex_shader_code_ =
     "#version 330 core\n"
     "layout(location = 0) in vec3 aPos;\n"
-    "uniform mat4 Trans;\n"
+    "uniform mat4 Trans[" +
+    std::to_string(kMaxNInstances) +
+    "];\n"
+    "uniform float SilhouetteIDs[" +
+    std::to_string(kMaxNInstances) +
+    "];\n"
+    "out float Depth;\n"
+    "flat out float SilhouetteID;\n"
     "void main()\n"
     "{\n"
-    "  gl_Position = Trans * vec4(aPos, 1.0);\n"
+    "  gl_Position = Trans[gl_InstanceID] * vec4(aPos, 1.0);\n"
+    "  Depth = gl_Position.w;\n"
+    "  SilhouetteID = SilhouetteIDs[gl_InstanceID];\n"
     "}";
 
 std::string SilhouetteRendererCore::fragment_shader_code_ =
     "#version 330 core\n"
-    "uniform float SilhouetteID;\n"
+    "flat in float SilhouetteID;\n"
     "out float FragColor;\n"
     "void main()\n"
     "{\n"
     "  FragColor = SilhouetteID;\n"
     "}";
 
+std::string SilhouetteRendererCore::linear_fragment_shader_code_ =
+    "#version 330 core\n"
+    "in float Depth;\n"
+    "flat in float SilhouetteID;\n"
+    "uniform float ZMin;\n"
+    "uniform float ZMax;\n"
+    "layout(location = 0) out float FragColor;\n"
+    "layout(location = 1) out float LinearDepth;\n"
+    "void main()\n"
+    "{\n"
+    "  FragColor = SilhouetteID;\n"
+    "  LinearDepth = (Depth - ZMin) / (ZMax - ZMin);\n"
+    "}";
+
 SilhouetteRendererCore::~SilhouetteRendererCore() {
   if (initial_set_up_) DeleteBufferObjects();
 }
 
 bool SilhouetteRendererCore::SetUp(
     const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
-    int image_width, int image_height) {
+    int image_width, int image_height, bool use_pixel_buffer_readback,
+    int context_id, bool use_linear_depth, float lod_max_pixel_error) {
+  if (context_id < 0 || context_id >= renderer_geometry_ptr->n_contexts()) {
+    std::cerr << "Context " << context_id << " of renderer geometry "
+              << renderer_geometry_ptr->name() << " does not exist"
+              << std::endl;
+    return false;
+  }
+  if (initial_set_up_) DeleteBufferObjects();
   renderer_geometry_ptr_ = renderer_geometry_ptr;
   image_width_ = image_width;
   image_height_ = image_height;
+  use_pixel_buffer_readback_ = use_pixel_buffer_readback;
+  context_id_ = context_id;
+  use_linear_depth_ = use_linear_depth;
+  lod_max_pixel_error_ = lod_max_pixel_error;
   image_rendered_ = false;
 
-  // Create shader program
+  // Create shader programs
   if (!initial_set_up_ &&
       !CreateShaderProgram(renderer_geometry_ptr_.get(),
                            vertex_shader_code_.c_str(),
                            fragment_shader_code_.c_str(), &shader_program_))
     return false;
+  if (use_linear_depth_ && !linear_shader_program_ &&
+      !CreateShaderProgram(renderer_geometry_ptr_.get(),
+                           vertex_shader_code_.c_str(),
+                           linear_fragment_shader_code_.c_str(),
+                           &linear_shader_program_))
+    return false;
 
   // Create buffer objects
-  if (initial_set_up_) DeleteBufferObjects();
   CreateBufferObjects();
   initial_set_up_ = true;
   return true;
@@ -55,44 +97,101 @@ bool SilhouetteRendererCore::SetUp(
 bool SilhouetteRendererCore::StartRendering(
     const Eigen::Matrix4f &projection_matrix,
     const Transform3fA &world2camera_pose, IDType id_type) {
+  return StartRendering(projection_matrix, world2camera_pose, id_type,
+                        cv::Rect{0, 0, image_width_, image_height_});
+}
+
+bool SilhouetteRendererCore::StartRendering(
+    const Eigen::Matrix4f &projection_matrix,
+    const Transform3fA &world2camera_pose, IDType id_type,
+    const cv::Rect &region) {
+  Tile tile{cv::Rect{0, 0, image_width_, image_height_}, projection_matrix,
+            world2camera_pose, id_type};
+  return RenderTiles(&tile, 1, region);
+}
+
+bool SilhouetteRendererCore::StartRendering(const std::vector<Tile> &tiles) {
+  return RenderTiles(tiles.data(), tiles.size(),
+                     cv::Rect{0, 0, image_width_, image_height_});
+}
+
+bool SilhouetteRendererCore::RenderTiles(const Tile *tiles, size_t n_tiles,
+                                         const cv::Rect &region) {
   if (!initial_set_up_) return false;
-  renderer_geometry_ptr_->MakeContextCurrent();
+  region_ = region;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glViewport(0, 0, image_width_, image_height_);
 
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(region_.x, region_.y, region_.width, region_.height);
   glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if (use_linear_depth_) {
+    const float linear_depth_clear_value = 1.0f;
+    glClearBufferfv(GL_COLOR, 1, &linear_depth_clear_value);
+  }
   glEnable(GL_DEPTH_TEST);
   glFrontFace(GL_CCW);
   glCullFace(GL_FRONT);
 
-  glUseProgram(shader_program_);
-  for (const auto &render_data_body :
-       renderer_geometry_ptr_->render_data_bodies()) {
-    Eigen::Matrix4f trans{
-        projection_matrix *
-        (world2camera_pose * render_data_body.body_ptr->geometry2world_pose())
-            .matrix()};
-
-    unsigned loc;
-    loc = glGetUniformLocation(shader_program_, "Trans");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, trans.data());
-    loc = glGetUniformLocation(shader_program_, "SilhouetteID");
-    // Map silhouette id from uchar [0, 255] to float [0.0, 1.0]
-    glUniform1f(loc,
-                float(render_data_body.body_ptr->get_id(id_type)) / 255.0f);
-
-    if (render_data_body.body_ptr->geometry_enable_culling())
-      glEnable(GL_CULL_FACE);
-    else
-      glDisable(GL_CULL_FACE);
-
-    glBindVertexArray(render_data_body.vao);
-    glDrawArrays(GL_TRIANGLES, 0, render_data_body.n_vertices);
-    glBindVertexArray(0);
+  unsigned shader_program =
+      use_linear_depth_ ? linear_shader_program_ : shader_program_;
+  glUseProgram(shader_program);
+  for (const Tile *tile_ptr = tiles; tile_ptr != tiles + n_tiles; ++tile_ptr) {
+    const Tile &tile{*tile_ptr};
+    glViewport(tile.viewport.x, tile.viewport.y, tile.viewport.width,
+               tile.viewport.height);
+    if (use_linear_depth_)
+      SetLinearDepthUniforms(shader_program, tile.projection_matrix);
+    float focal_length =
+        0.5f * tile.projection_matrix(0, 0) * float(tile.viewport.width);
+    AssignInstanceGroups(renderer_geometry_ptr_->render_data_bodies(),
+                         tile.world2camera_pose, focal_length,
+                         lod_max_pixel_error_, &instance_groups_);
+    for (const auto &instance_group : instance_groups_) {
+      int n_instances = int(instance_group.body_ptrs.size());
+      for (int i = 0; i < n_instances; ++i) {
+        const Body &body{*instance_group.body_ptrs[i]};
+        transs_[i] =
+            tile.projection_matrix *
+            (tile.world2camera_pose * body.geometry2world_pose()).matrix();
+        // Map silhouette id from uchar [0, 255] to float [0.0, 1.0]
+        silhouette_ids_[i] = float(body.get_id(tile.id_type)) / 255.0f;
+      }
+
+      unsigned loc;
+      loc = glGetUniformLocation(shader_program, "Trans");
+      glUniformMatrix4fv(loc, n_instances, GL_FALSE, transs_[0].data());
+      loc = glGetUniformLocation(shader_program, "SilhouetteIDs");
+      glUniform1fv(loc, n_instances, silhouette_ids_.data());
+
+      if (instance_group.enable_culling)
+        glEnable(GL_CULL_FACE);
+      else
+        glDisable(GL_CULL_FACE);
+
+      const auto &render_data_body{*instance_group.render_data_body_ptr};
+      int lod_level = instance_group.lod_level;
+      glBindVertexArray(render_data_body.context_vao(context_id_));
+      glDrawArraysInstanced(GL_TRIANGLES,
+                            render_data_body.first_vertex(lod_level),
+                            render_data_body.vertex_count(lod_level),
+                            n_instances);
+      glBindVertexArray(0);
+    }
+  }
+  glDisable(GL_SCISSOR_TEST);
+  if (use_pixel_buffer_readback_) {
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    silhouette_reader_.StartReadback(GL_RED, GL_UNSIGNED_BYTE, region_);
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT1);
+    depth_reader_.StartReadback(
+        use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT,
+        region_);
   }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 
   image_rendered_ = true;
   silhouette_image_fetched_ = false;
@@ -103,17 +202,25 @@ bool SilhouetteRendererCore::StartRendering(
 bool SilhouetteRendererCore::FetchSilhouetteImage(cv::Mat *silhouette_image) {
   if (!initial_set_up_ || !image_rendered_) return false;
   if (silhouette_image_fetched_) return true;
-  renderer_geometry_ptr_->MakeContextCurrent();
-  glPixelStorei(GL_PACK_ALIGNMENT, (silhouette_image->step & 3) ? 1 : 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH,
-                GLint(silhouette_image->step / silhouette_image->elemSize()));
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-  glBindRenderbuffer(GL_RENDERBUFFER, rbo_silhouette_);
-  glReadPixels(0, 0, image_width_, image_height_, GL_RED, GL_UNSIGNED_BYTE,
-               silhouette_image->data);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  bool fetched = true;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
+  if (use_pixel_buffer_readback_) {
+    fetched = silhouette_reader_.Fetch(silhouette_image);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, (silhouette_image->step & 3) ? 1 : 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH,
+                  GLint(silhouette_image->step / silhouette_image->elemSize()));
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_silhouette_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(region_.x, region_.y, region_.width, region_.height, GL_RED,
+                 GL_UNSIGNED_BYTE, (*silhouette_image)(region_).data);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
+  if (!fetched) return false;
+  FillOutsideRegion(region_, cv::Scalar{0}, silhouette_image);
   silhouette_image_fetched_ = true;
   return true;
 }
@@ -121,23 +228,32 @@ bool SilhouetteRendererCore::FetchSilhouetteImage(cv::Mat *silhouette_image) {
 bool SilhouetteRendererCore::FetchDepthImage(cv::Mat *depth_image) {
   if (!initial_set_up_ || !image_rendered_) return false;
   if (depth_image_fetched_) return true;
-  renderer_geometry_ptr_->MakeContextCurrent();
-  glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
-  glPixelStorei(GL_PACK_ROW_LENGTH,
-                GLint(depth_image->step / depth_image->elemSize()));
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
-  glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-  glReadPixels(0, 0, image_width_, image_height_, GL_DEPTH_COMPONENT,
-               GL_UNSIGNED_SHORT, depth_image->data);
-  glBindRenderbuffer(GL_RENDERBUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+  bool fetched = true;
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
+  if (use_pixel_buffer_readback_) {
+    fetched = depth_reader_.Fetch(depth_image);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, (depth_image->step & 3) ? 1 : 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH,
+                  GLint(depth_image->step / depth_image->elemSize()));
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
+    if (use_linear_depth_) glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(region_.x, region_.y, region_.width, region_.height,
+                 use_linear_depth_ ? GL_RED : GL_DEPTH_COMPONENT,
+                 GL_UNSIGNED_SHORT, (*depth_image)(region_).data);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
+  if (!fetched) return false;
+  FillOutsideRegion(region_, cv::Scalar{USHRT_MAX}, depth_image);
   depth_image_fetched_ = true;
   return true;
 }
 
 void SilhouetteRendererCore::CreateBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
 
   // Initialize renderbuffer bodies_render_data
   glGenRenderbuffers(1, &rbo_silhouette_);
@@ -145,12 +261,24 @@ void SilhouetteRendererCore::CreateBufferObjects() {
   glRenderbufferStorage(GL_RENDERBUFFER, GL_R8, image_width_, image_height_);
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
+  // Linear depth is written to a second color attachment and the depth
+  // attachment is only used for depth tests
   glGenRenderbuffers(1, &rbo_depth_);
   glBindRenderbuffer(GL_RENDERBUFFER, rbo_depth_);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, image_width_,
-                        image_height_);
+  glRenderbufferStorage(
+      GL_RENDERBUFFER,
+      use_linear_depth_ ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT16,
+      image_width_, image_height_);
   glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
+  if (use_linear_depth_) {
+    glGenRenderbuffers(1, &rbo_linear_depth_);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo_linear_depth_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R16, image_width_,
+                          image_height_);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
   // Initialize framebuffer bodies_render_data
   glGenFramebuffers(1, &fbo_);
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
@@ -158,16 +286,32 @@ void SilhouetteRendererCore::CreateBufferObjects() {
                             GL_RENDERBUFFER, rbo_silhouette_);
   glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                             GL_RENDERBUFFER, rbo_depth_);
+  if (use_linear_depth_) {
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+                              GL_RENDERBUFFER, rbo_linear_depth_);
+    const GLenum draw_buffers[]{GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, draw_buffers);
+  }
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  renderer_geometry_ptr_->DetachContext();
+
+  // Initialize pixel buffer objects for asynchronous readback
+  if (use_pixel_buffer_readback_) {
+    silhouette_reader_.Create(image_width_, image_height_, 1);
+    depth_reader_.Create(image_width_, image_height_, 2);
+  }
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 void SilhouetteRendererCore::DeleteBufferObjects() {
-  renderer_geometry_ptr_->MakeContextCurrent();
+  renderer_geometry_ptr_->MakeContextCurrent(context_id_);
   glDeleteRenderbuffers(1, &rbo_silhouette_);
   glDeleteRenderbuffers(1, &rbo_depth_);
+  glDeleteRenderbuffers(1, &rbo_linear_depth_);
+  rbo_linear_depth_ = 0;
   glDeleteFramebuffers(1, &fbo_);
-  renderer_geometry_ptr_->DetachContext();
+  silhouette_reader_.Delete();
+  depth_reader_.Delete();
+  renderer_geometry_ptr_->DetachContext(context_id_);
 }
 
 FullSilhouetteRenderer::FullSilhouetteRenderer(
@@ -218,7 +362,8 @@ bool FullSilhouetteRenderer::SetUp() {
   ClearDepthImage();
   ClearSilhouetteImage();
   if (!core_.SetUp(renderer_geometry_ptr_, intrinsics_.width,
-                   intrinsics_.height))
+                   intrinsics_.height, use_pixel_buffer_readback_, context_id_,
+                   use_linear_depth_, lod_max_pixel_error_))
     return false;
 
   set_up_ = true;
@@ -273,6 +418,11 @@ bool FullSilhouetteRenderer::LoadMetaData() {
   // Read parameters from yaml
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
   ReadOptionalValueFromYaml(fs, "id_type", &id_type_);
   fs.release();
   return true;
@@ -322,11 +472,17 @@ bool FocusedSilhouetteRenderer::SetUp() {
     if (!LoadMetaData()) return false;
 
   // Check if all required objects are set up
-  if (!renderer_geometry_ptr_->set_up()) {
+  if (!use_software_rendering_ && !renderer_geometry_ptr_->set_up()) {
     std::cerr << "Renderer geometry " << renderer_geometry_ptr_->name()
               << " was not set up" << std::endl;
     return false;
   }
+  if (use_software_rendering_ && use_atlas_) {
+    std::cerr << "Renderer " << name_
+              << " cannot use both software rendering and an atlas"
+              << std::endl;
+    return false;
+  }
   if (camera_ptr_ && !InitParametersFromCamera()) return false;
   if (referenced_body_ptrs_.empty()) {
     std::cerr << "No referenced bodies were assigned to renderer " << name_
@@ -346,8 +502,17 @@ bool FocusedSilhouetteRenderer::SetUp() {
   CalculateProjectionTerms();
   ClearDepthImage();
   ClearSilhouetteImage();
-  if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_))
+  render_cache_valid_ = false;
+  if (use_software_rendering_) {
+    software_core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_,
+                         use_linear_depth_, lod_max_pixel_error_);
+  } else if (use_atlas_) {
+    if (!SetUpAtlas(id_type_)) return false;
+  } else if (!core_.SetUp(renderer_geometry_ptr_, image_size_, image_size_,
+                          use_pixel_buffer_readback_, context_id_,
+                          use_linear_depth_, lod_max_pixel_error_)) {
     return false;
+  }
 
   set_up_ = true;
   return true;
@@ -355,6 +520,15 @@ bool FocusedSilhouetteRenderer::SetUp() {
 
 void FocusedSilhouetteRenderer::set_id_type(IDType id_type) {
   id_type_ = id_type;
+  render_cache_valid_ = false;
+  if (use_atlas_ && set_up_) atlas_ptr_->AddRenderer(this, id_type_);
+}
+
+void FocusedSilhouetteRenderer::set_use_software_rendering(
+    bool use_software_rendering) {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  use_software_rendering_ = use_software_rendering;
+  set_up_ = false;
 }
 
 bool FocusedSilhouetteRenderer::StartRendering() {
@@ -363,8 +537,22 @@ bool FocusedSilhouetteRenderer::StartRendering() {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (use_atlas_) {
+    CalculateProjectionMatrix();
+    return atlas_ptr_->StartRendering(this);
+  }
+  if (IsRenderCacheValid()) return true;
   CalculateProjectionMatrix();
-  return core_.StartRendering(projection_matrix_, world2camera_pose_, id_type_);
+  if (use_software_rendering_) {
+    if (!software_core_.StartRendering(projection_matrix_, world2camera_pose_,
+                                       id_type_))
+      return false;
+  } else if (!core_.StartRendering(projection_matrix_, world2camera_pose_,
+                                   id_type_, valid_region_)) {
+    return false;
+  }
+  UpdateRenderCache();
+  return true;
 }
 
 bool FocusedSilhouetteRenderer::FetchSilhouetteImage() {
@@ -373,6 +561,10 @@ bool FocusedSilhouetteRenderer::FetchSilhouetteImage() {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (use_software_rendering_)
+    return software_core_.FetchSilhouetteImage(&focused_silhouette_image_);
+  if (use_atlas_)
+    return atlas_ptr_->FetchSilhouetteImage(this, &focused_silhouette_image_);
   return core_.FetchSilhouetteImage(&focused_silhouette_image_);
 }
 
@@ -382,11 +574,19 @@ bool FocusedSilhouetteRenderer::FetchDepthImage() {
     std::cerr << "Set up renderer " << name_ << " first" << std::endl;
     return false;
   }
+  if (use_software_rendering_)
+    return software_core_.FetchDepthImage(&focused_depth_image_);
+  if (use_atlas_)
+    return atlas_ptr_->FetchDepthImage(this, &focused_depth_image_);
   return core_.FetchDepthImage(&focused_depth_image_);
 }
 
 IDType FocusedSilhouetteRenderer::id_type() const { return id_type_; }
 
+bool FocusedSilhouetteRenderer::use_software_rendering() const {
+  return use_software_rendering_;
+}
+
 const cv::Mat &FocusedSilhouetteRenderer::focused_silhouette_image() const {
   return focused_silhouette_image_;
 }
@@ -408,6 +608,16 @@ bool FocusedSilhouetteRenderer::LoadMetaData() {
   ReadOptionalValueFromYaml(fs, "image_size", &image_size_);
   ReadOptionalValueFromYaml(fs, "z_min", &z_min_);
   ReadOptionalValueFromYaml(fs, "z_max", &z_max_);
+  ReadOptionalValueFromYaml(fs, "use_pixel_buffer_readback",
+                            &use_pixel_buffer_readback_);
+  ReadOptionalValueFromYaml(fs, "context_id", &context_id_);
+  ReadOptionalValueFromYaml(fs, "use_linear_depth", &use_linear_depth_);
+  ReadOptionalValueFromYaml(fs, "lod_max_pixel_error", &lod_max_pixel_error_);
+  ReadOptionalValueFromYaml(fs, "use_software_rendering",
+                            &use_software_rendering_);
+  ReadOptionalValueFromYaml(fs, "render_cache_threshold",
+                            &render_cache_threshold_);
+  ReadOptionalValueFromYaml(fs, "use_region_readback", &use_region_readback_);
   fs.release();
   return true;
 }
@@ -224,7 +224,7 @@ void SoftConstraint::AddGradientsAndHessiansToLink(
   Eigen::Matrix<float, 6, 1> gradient{Eigen::Matrix<float, 6, 1>::Zero()};
   Eigen::Matrix<float, 6, 6> hessian{Eigen::Matrix<float, 6, 6>::Zero()};
   if (n_constraints_rotation_) {
-    const auto &identity_matrix{Eigen::MatrixXf::Identity(
+    const auto &identity_matrix{ConsideredMatrix::Identity(
         n_constraints_rotation_, n_constraints_rotation_)};
     const auto &rotation_vector{ConsideredRotationVector(joint22joint1_pose)};
     float distance_rotation = rotation_vector.norm();
@@ -246,7 +246,7 @@ void SoftConstraint::AddGradientsAndHessiansToLink(
     }
   }
   if (n_constraints_translation_) {
-    const auto &identity_matrix{Eigen::MatrixXf::Identity(
+    const auto &identity_matrix{ConsideredMatrix::Identity(
         n_constraints_translation_, n_constraints_translation_)};
     const auto &translation_vector{
         ConsideredTranslationVector(joint22joint1_pose)};
@@ -271,13 +271,12 @@ void SoftConstraint::AddGradientsAndHessiansToLink(
   link_ptr->AddToGradientAndHessian(gradient, hessian);
 }
 
-Eigen::VectorXf SoftConstraint::ConsideredRotationVector(
+SoftConstraint::ConsideredVector SoftConstraint::ConsideredRotationVector(
     const Transform3fA &joint22joint1_pose) const {
-  Eigen::AngleAxisf angle_axis{joint22joint1_pose.rotation()};
-  Eigen::Vector3f vector{angle_axis.angle() * angle_axis.axis()};
+  Eigen::Vector3f vector{LogSO3(joint22joint1_pose.linear())};
 
-  Eigen::VectorXf considered_vector{
-      Eigen::VectorXf::Zero(n_constraints_rotation_)};
+  ConsideredVector considered_vector{
+      ConsideredVector::Zero(n_constraints_rotation_)};
   for (int direction = 0, residual_idx = 0; direction < 3; ++direction) {
     if (constraint_directions_[direction]) {
       considered_vector(residual_idx) = vector(direction);
@@ -287,12 +286,12 @@ Eigen::VectorXf SoftConstraint::ConsideredRotationVector(
   return considered_vector;
 }
 
-Eigen::VectorXf SoftConstraint::ConsideredTranslationVector(
+SoftConstraint::ConsideredVector SoftConstraint::ConsideredTranslationVector(
     const Transform3fA &joint22joint1_pose) const {
   Eigen::Vector3f vector{joint22joint1_pose.translation()};
 
-  Eigen::VectorXf considered_vector{
-      Eigen::VectorXf::Zero(n_constraints_translation_)};
+  ConsideredVector considered_vector{
+      ConsideredVector::Zero(n_constraints_translation_)};
   for (int direction = 0, residual_idx = 0; direction < 3; ++direction) {
     if (constraint_directions_[direction + 3]) {
       considered_vector(residual_idx) = vector(direction);
@@ -302,19 +301,16 @@ Eigen::VectorXf SoftConstraint::ConsideredTranslationVector(
   return considered_vector;
 }
 
-Eigen::MatrixXf SoftConstraint::UnprojectedConstraintJacobianRotation(
+SoftConstraint::ConsideredJacobian
+SoftConstraint::UnprojectedConstraintJacobianRotation(
     const Transform3fA &joint22joint1_pose,
     const Transform3fA &body2joint1_pose) const {
-  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.rotation().matrix()};
-  Eigen::AngleAxisf angle_axis{joint22joint1_pose.rotation()};
-  Eigen::Vector3f axis{angle_axis.axis()};
-  float angle_half = 0.5f * angle_axis.angle();
+  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.linear()};
   Eigen::Matrix3f variation_matrix{
-      xcotx(angle_half) * Eigen::Matrix3f::Identity() -
-      angle_half * Vector2Skewsymmetric(axis) +
-      (1.0f - xcotx(angle_half)) * axis * axis.transpose()};
+      InverseLeftJacobianSO3(LogSO3(joint22joint1_pose.linear()))};
 
-  Eigen::MatrixXf jacobian{Eigen::MatrixXf::Zero(n_constraints_rotation_, 6)};
+  ConsideredJacobian jacobian{
+      ConsideredJacobian::Zero(n_constraints_rotation_, 6)};
   for (int direction = 0, jacobian_idx = 0; direction < 3; ++direction) {
     if (constraint_directions_[direction]) {
       jacobian.row(jacobian_idx).head<3>() =
@@ -325,17 +321,18 @@ Eigen::MatrixXf SoftConstraint::UnprojectedConstraintJacobianRotation(
   return jacobian;
 }
 
-Eigen::MatrixXf SoftConstraint::UnprojectedConstraintJacobianTranslation(
+SoftConstraint::ConsideredJacobian
+SoftConstraint::UnprojectedConstraintJacobianTranslation(
     const Transform3fA &joint22joint1_pose,
     const Transform3fA &body2joint1_pose) const {
   Transform3fA body2joint2_pose{joint22joint1_pose.inverse() *
                                 body2joint1_pose};
   Eigen::Vector3f joint22body_translation{
       body2joint2_pose.inverse().translation().matrix()};
-  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.rotation().matrix()};
+  Eigen::Matrix3f body2joint1_rotation{body2joint1_pose.linear()};
 
-  Eigen::MatrixXf jacobian{
-      Eigen::MatrixXf::Zero(n_constraints_translation_, 6)};
+  ConsideredJacobian jacobian{
+      ConsideredJacobian::Zero(n_constraints_translation_, 6)};
   for (int direction = 0, jacobian_idx = 0; direction < 3; ++direction) {
     if (constraint_directions_[direction + 3]) {
       jacobian.row(jacobian_idx).head<3>() =
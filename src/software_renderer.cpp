@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/software_renderer.h>
+
+namespace m3t {
+
+bool SoftwareRendererCore::SetUp(
+    const std::shared_ptr<RendererGeometry> &renderer_geometry_ptr,
+    int image_width, int image_height, bool use_linear_depth,
+    float lod_max_pixel_error) {
+  renderer_geometry_ptr_ = renderer_geometry_ptr;
+  image_width_ = image_width;
+  image_height_ = image_height;
+  use_linear_depth_ = use_linear_depth;
+  lod_max_pixel_error_ = lod_max_pixel_error;
+  silhouette_buffer_.create(cv::Size{image_width_, image_height_}, CV_8U);
+  depth_buffer_.create(cv::Size{image_width_, image_height_}, CV_32F);
+  image_rendered_ = false;
+  initial_set_up_ = true;
+  return true;
+}
+
+bool SoftwareRendererCore::StartRendering(
+    const Eigen::Matrix4f &projection_matrix,
+    const Transform3fA &world2camera_pose, IDType id_type) {
+  if (!initial_set_up_) return false;
+  z_min_ = -projection_matrix(2, 3) / (projection_matrix(2, 2) + 1.0f);
+  z_max_ = -projection_matrix(2, 3) / (projection_matrix(2, 2) - 1.0f);
+  silhouette_buffer_.setTo(cv::Scalar{0});
+  depth_buffer_.setTo(cv::Scalar{1.0f});
+  float focal_length = 0.5f * projection_matrix(0, 0) * float(image_width_);
+  for (const auto &body_ptr : renderer_geometry_ptr_->CopyBodyPtrs()) {
+    if (!body_ptr->set_up()) continue;
+    Eigen::Matrix4f trans{
+        projection_matrix *
+        (world2camera_pose * body_ptr->geometry2world_pose()).matrix()};
+    int lod_level = SelectLODLevel(*body_ptr, world2camera_pose, focal_length,
+                                   lod_max_pixel_error_);
+    RasterizeBody(*body_ptr, lod_level, trans, body_ptr->get_id(id_type));
+  }
+  image_rendered_ = true;
+  return true;
+}
+
+bool SoftwareRendererCore::FetchSilhouetteImage(cv::Mat *silhouette_image) {
+  if (!initial_set_up_ || !image_rendered_) return false;
+  silhouette_buffer_.copyTo(*silhouette_image);
+  return true;
+}
+
+bool SoftwareRendererCore::FetchDepthImage(cv::Mat *depth_image) {
+  if (!initial_set_up_ || !image_rendered_) return false;
+  if (!use_linear_depth_) {
+    depth_buffer_.convertTo(*depth_image, CV_16U, double(USHRT_MAX));
+    return true;
+  }
+
+  // Convert window depth values into values that are linear in z
+  float a = 2.0f * z_max_ * z_min_ / (z_max_ - z_min_);
+  float b = (z_max_ + z_min_) / (z_max_ - z_min_) + 1.0f;
+  float scale = float(USHRT_MAX) / (z_max_ - z_min_);
+  depth_image->create(depth_buffer_.size(), CV_16U);
+  for (int v = 0; v < depth_buffer_.rows; ++v) {
+    const float *depth_row = depth_buffer_.ptr<float>(v);
+    ushort *image_row = depth_image->ptr<ushort>(v);
+    for (int u = 0; u < depth_buffer_.cols; ++u) {
+      float z = a / (b - 2.0f * depth_row[u]);
+      image_row[u] = cv::saturate_cast<ushort>((z - z_min_) * scale);
+    }
+  }
+  return true;
+}
+
+void SoftwareRendererCore::RasterizeBody(const Body &body, int lod_level,
+                                         const Eigen::Matrix4f &trans,
+                                         uchar id) {
+  // Transform vertices of level of detail into clip space
+  const auto &vertices{lod_level == 0
+                           ? body.vertices()
+                           : body.lod_meshes()[lod_level - 1].vertices};
+  const auto &mesh_indices{lod_level == 0
+                               ? body.mesh_indices()
+                               : body.lod_meshes()[lod_level - 1].mesh_indices};
+  clip_vertices_.resize(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i)
+    clip_vertices_[i] = trans * vertices[i].homogeneous();
+
+  bool enable_culling = body.geometry_enable_culling();
+  for (const auto &triangle_indices : mesh_indices) {
+    ClipAndRasterizeTriangle({clip_vertices_[triangle_indices[0]],
+                              clip_vertices_[triangle_indices[1]],
+                              clip_vertices_[triangle_indices[2]]},
+                             enable_culling, id);
+  }
+}
+
+void SoftwareRendererCore::ClipAndRasterizeTriangle(
+    const std::array<Eigen::Vector4f, 3> &triangle, bool enable_culling,
+    uchar id) {
+  // Clip triangle at near plane, resulting in a polygon with up to 4 vertices
+  std::array<Eigen::Vector4f, 4> polygon;
+  int n_vertices = 0;
+  for (int i = 0; i < 3; ++i) {
+    const Eigen::Vector4f &vertex_1{triangle[i]};
+    const Eigen::Vector4f &vertex_2{triangle[(i + 1) % 3]};
+    float distance_1 = vertex_1(2) + vertex_1(3);
+    float distance_2 = vertex_2(2) + vertex_2(3);
+    if (distance_1 >= 0.0f) polygon[n_vertices++] = vertex_1;
+    if ((distance_1 >= 0.0f) != (distance_2 >= 0.0f))
+      polygon[n_vertices++] =
+          vertex_1 +
+          (vertex_2 - vertex_1) * (distance_1 / (distance_1 - distance_2));
+  }
+  if (n_vertices < 3) return;
+
+  // Transform polygon into window coordinates with depth in [0, 1]
+  std::array<Eigen::Vector3f, 4> window_vertices;
+  for (int i = 0; i < n_vertices; ++i) {
+    float w_inv = 1.0f / polygon[i](3);
+    window_vertices[i] = Eigen::Vector3f{
+        (polygon[i](0) * w_inv * 0.5f + 0.5f) * float(image_width_),
+        (polygon[i](1) * w_inv * 0.5f + 0.5f) * float(image_height_),
+        polygon[i](2) * w_inv * 0.5f + 0.5f};
+  }
+  for (int i = 1; i < n_vertices - 1; ++i) {
+    RasterizeTriangle(window_vertices[0], window_vertices[i],
+                      window_vertices[i + 1], enable_culling, id);
+  }
+}
+
+void SoftwareRendererCore::RasterizeTriangle(const Eigen::Vector3f &vertex_a,
+                                             const Eigen::Vector3f &vertex_b,
+                                             const Eigen::Vector3f &vertex_c,
+                                             bool enable_culling, uchar id) {
+  // Cull front faces, which are counterclockwise in window coordinates, and
+  // bring all remaining triangles into counterclockwise order
+  float area = (vertex_b.x() - vertex_a.x()) * (vertex_c.y() - vertex_a.y()) -
+               (vertex_c.x() - vertex_a.x()) * (vertex_b.y() - vertex_a.y());
+  if (area == 0.0f) return;
+  if (area > 0.0f && enable_culling) return;
+  const Eigen::Vector3f &vertex_1{vertex_a};
+  const Eigen::Vector3f &vertex_2{area > 0.0f ? vertex_b : vertex_c};
+  const Eigen::Vector3f &vertex_3{area > 0.0f ? vertex_c : vertex_b};
+  float inv_area = 1.0f / std::abs(area);
+
+  // Calculate edge functions and plane of depth values
+  std::array<Edge, 3> edges{CalculateEdge(vertex_2, vertex_3),
+                            CalculateEdge(vertex_3, vertex_1),
+                            CalculateEdge(vertex_1, vertex_2)};
+  Eigen::Vector3f depth_plane{
+      (edges[0].a * vertex_1.z() + edges[1].a * vertex_2.z() +
+       edges[2].a * vertex_3.z()) *
+          inv_area,
+      (edges[0].b * vertex_1.z() + edges[1].b * vertex_2.z() +
+       edges[2].b * vertex_3.z()) *
+          inv_area,
+      (edges[0].c * vertex_1.z() + edges[1].c * vertex_2.z() +
+       edges[2].c * vertex_3.z()) *
+          inv_area};
+
+  // Calculate bounding box of pixel centers
+  float x_min = std::min({vertex_1.x(), vertex_2.x(), vertex_3.x()});
+  float x_max = std::max({vertex_1.x(), vertex_2.x(), vertex_3.x()});
+  float y_min = std::min({vertex_1.y(), vertex_2.y(), vertex_3.y()});
+  float y_max = std::max({vertex_1.y(), vertex_2.y(), vertex_3.y()});
+  int u_min = std::max(int(std::ceil(x_min - 0.5f)), 0);
+  int u_max = std::min(int(std::floor(x_max - 0.5f)), image_width_ - 1);
+  int v_min = std::max(int(std::ceil(y_min - 0.5f)), 0);
+  int v_max = std::min(int(std::floor(y_max - 0.5f)), image_height_ - 1);
+  if (u_min > u_max || v_min > v_max) return;
+
+  // Iterate over tiles, rejecting tiles outside and detecting covered tiles
+  for (int y_tile = v_min - v_min % kTileSize; y_tile <= v_max;
+       y_tile += kTileSize) {
+    int y_begin = std::max(y_tile, v_min);
+    int y_end = std::min(y_tile + kTileSize, v_max + 1);
+    for (int x_tile = u_min - u_min % kTileSize; x_tile <= u_max;
+         x_tile += kTileSize) {
+      int x_begin = std::max(x_tile, u_min);
+      int x_end = std::min(x_tile + kTileSize, u_max + 1);
+      float px_min = float(x_begin) + 0.5f;
+      float px_max = float(x_end) - 0.5f;
+      float py_min = float(y_begin) + 0.5f;
+      float py_max = float(y_end) - 0.5f;
+      bool outside = false;
+      bool covered = true;
+      for (const auto &edge : edges) {
+        float max_value = edge.a * (edge.a > 0.0f ? px_max : px_min) +
+                          edge.b * (edge.b > 0.0f ? py_max : py_min) + edge.c;
+        float min_value = edge.a * (edge.a > 0.0f ? px_min : px_max) +
+                          edge.b * (edge.b > 0.0f ? py_min : py_max) + edge.c;
+        outside |= max_value < 0.0f;
+        covered &= min_value > 0.0f;
+      }
+      if (outside) continue;
+      RasterizeTile(edges, depth_plane, covered, x_begin, x_end, y_begin,
+                    y_end, id);
+    }
+  }
+}
+
+void SoftwareRendererCore::RasterizeTile(const std::array<Edge, 3> &edges,
+                                         const Eigen::Vector3f &depth_plane,
+                                         bool covered, int x_begin, int x_end,
+                                         int y_begin, int y_end, uchar id) {
+  // Branch-free inner loop that is vectorized over pixels of a row
+  for (int y = y_begin; y < y_end; ++y) {
+    float py = float(y) + 0.5f;
+    float *depth_row = depth_buffer_.ptr<float>(y);
+    uchar *silhouette_row = silhouette_buffer_.ptr<uchar>(y);
+#ifndef _DEBUG
+#pragma omp simd
+#endif
+    for (int x = x_begin; x < x_end; ++x) {
+      float px = float(x) + 0.5f;
+      bool inside = covered;
+      if (!covered) {
+        inside = CoversPixel(edges[0].a * px + edges[0].b * py + edges[0].c,
+                             edges[0].top_left) &
+                 CoversPixel(edges[1].a * px + edges[1].b * py + edges[1].c,
+                             edges[1].top_left) &
+                 CoversPixel(edges[2].a * px + edges[2].b * py + edges[2].c,
+                             edges[2].top_left);
+      }
+      float depth = depth_plane(0) * px + depth_plane(1) * py + depth_plane(2);
+      bool write = inside & (depth >= 0.0f) & (depth <= 1.0f) &
+                   (depth < depth_row[x]);
+      depth_row[x] = write ? depth : depth_row[x];
+      silhouette_row[x] = write ? id : silhouette_row[x];
+    }
+  }
+}
+
+SoftwareRendererCore::Edge SoftwareRendererCore::CalculateEdge(
+    const Eigen::Vector3f &vertex_1, const Eigen::Vector3f &vertex_2) {
+  Edge edge;
+  edge.a = vertex_1.y() - vertex_2.y();
+  edge.b = vertex_2.x() - vertex_1.x();
+  edge.c = -(edge.a * vertex_1.x() + edge.b * vertex_1.y());
+  // Top-left fill rule for counterclockwise triangles with y pointing upward
+  edge.top_left = edge.a > 0.0f || (edge.a == 0.0f && edge.b < 0.0f);
+  return edge;
+}
+
+bool SoftwareRendererCore::CoversPixel(float edge_value, bool top_left) {
+  return edge_value > 0.0f || (edge_value == 0.0f && top_left);
+}
+
+}  // namespace m3t
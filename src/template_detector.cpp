@@ -0,0 +1,534 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <m3t/template_detector.h>
+
+namespace m3t {
+
+TemplateDetector::TemplateDetector(
+    const std::string &name, const std::shared_ptr<Optimizer> &optimizer_ptr,
+    const std::shared_ptr<ColorCamera> &color_camera_ptr,
+    const std::shared_ptr<RegionModel> &region_model_ptr,
+    bool reset_joint_poses)
+    : Detector{name, reset_joint_poses},
+      optimizer_ptr_{optimizer_ptr},
+      color_camera_ptr_{color_camera_ptr},
+      region_model_ptr_{region_model_ptr} {}
+
+TemplateDetector::TemplateDetector(
+    const std::string &name, const std::filesystem::path &metafile_path,
+    const std::shared_ptr<Optimizer> &optimizer_ptr,
+    const std::shared_ptr<ColorCamera> &color_camera_ptr,
+    const std::shared_ptr<RegionModel> &region_model_ptr)
+    : Detector{name, metafile_path},
+      optimizer_ptr_{optimizer_ptr},
+      color_camera_ptr_{color_camera_ptr},
+      region_model_ptr_{region_model_ptr} {}
+
+bool TemplateDetector::SetUp() {
+  set_up_ = false;
+  if (!metafile_path_.empty())
+    if (!LoadMetaData()) return false;
+
+  // Check parameters
+  if (n_pyramid_levels_ < 1 || n_rolls_ < 1 || distances_.empty()) {
+    std::cerr << "Template detector " << name_
+              << " requires at least one pyramid level, roll, and distance"
+              << std::endl;
+    return false;
+  }
+
+  // Check if all required objects are set up
+  if (!optimizer_ptr_->set_up()) {
+    std::cerr << "Optimizer " << optimizer_ptr_->name() << " was not set up"
+              << std::endl;
+    return false;
+  }
+  if (!color_camera_ptr_->set_up()) {
+    std::cerr << "Color camera " << color_camera_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
+  if (!region_model_ptr_->set_up()) {
+    std::cerr << "Region model " << region_model_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
+
+  // Check if region model belongs to root link
+  const auto &body_ptr{optimizer_ptr_->root_link_ptr()->body_ptr()};
+  if (!body_ptr || body_ptr->name() != region_model_ptr_->body_ptr()->name()) {
+    std::cerr << "Body of region model " << region_model_ptr_->name()
+              << " is not the body of the root link of optimizer "
+              << optimizer_ptr_->name() << std::endl;
+    return false;
+  }
+
+  GenerateResponseLUTs();
+  GenerateTemplates();
+  set_up_ = true;
+  return true;
+}
+
+void TemplateDetector::set_optimizer_ptr(
+    const std::shared_ptr<Optimizer> &optimizer_ptr) {
+  optimizer_ptr_ = optimizer_ptr;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_color_camera_ptr(
+    const std::shared_ptr<ColorCamera> &color_camera_ptr) {
+  color_camera_ptr_ = color_camera_ptr;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_region_model_ptr(
+    const std::shared_ptr<RegionModel> &region_model_ptr) {
+  region_model_ptr_ = region_model_ptr;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_distances(const std::vector<float> &distances) {
+  distances_ = distances;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_n_rolls(int n_rolls) {
+  n_rolls_ = n_rolls;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_min_view_angle(float min_view_angle) {
+  min_view_angle_ = min_view_angle;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_n_features(int n_features) {
+  n_features_ = n_features;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_n_pyramid_levels(int n_pyramid_levels) {
+  n_pyramid_levels_ = n_pyramid_levels;
+  set_up_ = false;
+}
+
+void TemplateDetector::set_min_magnitude(float min_magnitude) {
+  min_magnitude_ = min_magnitude;
+}
+
+void TemplateDetector::set_min_similarity(float min_similarity) {
+  min_similarity_ = min_similarity;
+}
+
+void TemplateDetector::set_n_hypotheses(int n_hypotheses) {
+  n_hypotheses_ = n_hypotheses;
+}
+
+bool TemplateDetector::DetectPoses(const std::set<std::string> &names,
+                                   std::set<std::string> *detected_names) {
+  if (!set_up_) {
+    std::cerr << "Set up template detector " << name_ << " first"
+              << std::endl;
+    return false;
+  }
+  if (names.find(optimizer_ptr_->name()) == names.end()) return true;
+
+  // Match templates on coarsest level and keep best candidates
+  CalculateResponseMaps();
+  std::vector<Match> matches;
+  MatchTemplatesOnCoarsestLevel(&matches);
+  auto compare{[](const Match &a, const Match &b) {
+    return a.similarity > b.similarity;
+  }};
+  int n_candidates = std::min(int(matches.size()),
+                              n_hypotheses_ * kNCandidatesPerHypothesis);
+  std::partial_sort(begin(matches), begin(matches) + n_candidates,
+                    end(matches), compare);
+  matches.resize(n_candidates);
+
+  // Refine candidates on finer levels
+#pragma omp parallel for
+  for (int i = 0; i < n_candidates; ++i) {
+    for (int level = n_pyramid_levels_ - 2; level >= 0; --level)
+      RefineMatch(level, &matches[i]);
+  }
+  std::sort(begin(matches), end(matches), compare);
+
+  // Calculate pose hypotheses
+  int n_hypotheses = std::min(n_candidates, n_hypotheses_);
+  link2world_pose_hypotheses_.resize(n_hypotheses);
+  similarities_.resize(n_hypotheses);
+  for (int i = 0; i < n_hypotheses; ++i) {
+    CalculatePose(matches[i], &link2world_pose_hypotheses_[i]);
+    similarities_[i] = matches[i].similarity;
+  }
+
+  // Update pose
+  if (n_hypotheses == 0 || similarities_[0] < min_similarity_) return true;
+  UpdatePoses(link2world_pose_hypotheses_[0], optimizer_ptr_);
+  if (detected_names) detected_names->insert(optimizer_ptr_->name());
+  return true;
+}
+
+void TemplateDetector::AddPoseHypotheses(
+    const std::set<std::string> &names,
+    std::map<std::string, std::vector<Transform3fA>>
+        *link2world_pose_hypotheses) const {
+  if (!set_up_ || names.find(optimizer_ptr_->name()) == names.end()) return;
+  std::vector<Transform3fA> hypotheses;
+  for (size_t i = 0; i < link2world_pose_hypotheses_.size(); ++i) {
+    if (similarities_[i] >= min_similarity_)
+      hypotheses.push_back(link2world_pose_hypotheses_[i]);
+  }
+  if (!hypotheses.empty())
+    (*link2world_pose_hypotheses)[optimizer_ptr_->name()] =
+        std::move(hypotheses);
+}
+
+const std::shared_ptr<Optimizer> &TemplateDetector::optimizer_ptr() const {
+  return optimizer_ptr_;
+}
+
+const std::shared_ptr<ColorCamera> &TemplateDetector::color_camera_ptr()
+    const {
+  return color_camera_ptr_;
+}
+
+const std::shared_ptr<RegionModel> &TemplateDetector::region_model_ptr()
+    const {
+  return region_model_ptr_;
+}
+
+const std::vector<float> &TemplateDetector::distances() const {
+  return distances_;
+}
+
+int TemplateDetector::n_rolls() const { return n_rolls_; }
+
+float TemplateDetector::min_view_angle() const { return min_view_angle_; }
+
+int TemplateDetector::n_features() const { return n_features_; }
+
+int TemplateDetector::n_pyramid_levels() const { return n_pyramid_levels_; }
+
+float TemplateDetector::min_magnitude() const { return min_magnitude_; }
+
+float TemplateDetector::min_similarity() const { return min_similarity_; }
+
+int TemplateDetector::n_hypotheses() const { return n_hypotheses_; }
+
+int TemplateDetector::n_templates() const { return int(templates_.size()); }
+
+const std::vector<Transform3fA> &TemplateDetector::link2world_pose_hypotheses()
+    const {
+  return link2world_pose_hypotheses_;
+}
+
+const std::vector<float> &TemplateDetector::similarities() const {
+  return similarities_;
+}
+
+std::vector<std::shared_ptr<Optimizer>> TemplateDetector::optimizer_ptrs()
+    const {
+  return {optimizer_ptr_};
+}
+
+std::shared_ptr<Camera> TemplateDetector::camera_ptr() const {
+  return color_camera_ptr_;
+}
+
+bool TemplateDetector::LoadMetaData() {
+  // Open file storage from yaml
+  cv::FileStorage fs;
+  if (!OpenYamlFileStorage(metafile_path_, &fs)) return false;
+
+  // Read parameters from yaml
+  ReadOptionalValueFromYaml(fs, "reset_joint_poses", &reset_joint_poses_);
+  ReadOptionalValueFromYaml(fs, "distances", &distances_);
+  ReadOptionalValueFromYaml(fs, "n_rolls", &n_rolls_);
+  ReadOptionalValueFromYaml(fs, "min_view_angle", &min_view_angle_);
+  ReadOptionalValueFromYaml(fs, "n_features", &n_features_);
+  ReadOptionalValueFromYaml(fs, "n_pyramid_levels", &n_pyramid_levels_);
+  ReadOptionalValueFromYaml(fs, "min_magnitude", &min_magnitude_);
+  ReadOptionalValueFromYaml(fs, "min_similarity", &min_similarity_);
+  ReadOptionalValueFromYaml(fs, "n_hypotheses", &n_hypotheses_);
+  fs.release();
+  return true;
+}
+
+void TemplateDetector::GenerateTemplates() {
+  std::vector<const RegionModel::View *> view_ptrs;
+  SelectViews(&view_ptrs);
+
+  // Generate templates for all views, rolls, and distances
+  templates_.clear();
+  Eigen::Vector3f downwards{0.0f, 1.0f, 0.0f};  // direction in body frame
+  for (const auto view_ptr : view_ptrs) {
+    const Eigen::Vector3f &orientation{view_ptr->orientation};
+    Eigen::Matrix3f camera2body_rotation;
+    camera2body_rotation.col(2) = orientation;
+    if (orientation[0] == 0.0f && orientation[2] == 0.0f)
+      camera2body_rotation.col(0) = Eigen::Vector3f{1.0f, 0.0f, 0.0f};
+    else
+      camera2body_rotation.col(0) = downwards.cross(orientation).normalized();
+    camera2body_rotation.col(1) =
+        orientation.cross(camera2body_rotation.col(0));
+
+    for (int i = 0; i < n_rolls_; ++i) {
+      Eigen::AngleAxisf roll{2.0f * kPi * float(i) / float(n_rolls_),
+                             Eigen::Vector3f::UnitZ()};
+      Eigen::Matrix3f body2camera_rotation{
+          (camera2body_rotation * roll).transpose()};
+      for (float distance : distances_) {
+        Template templ;
+        GenerateTemplate(*view_ptr, body2camera_rotation, distance, &templ);
+        if (!templ.level_features[0].empty())
+          templates_.push_back(std::move(templ));
+      }
+    }
+  }
+}
+
+void TemplateDetector::SelectViews(
+    std::vector<const RegionModel::View *> *view_ptrs) const {
+  float max_dot = std::cos(min_view_angle_);
+  view_ptrs->clear();
+  for (const auto &view : region_model_ptr_->views()) {
+    if (std::none_of(begin(*view_ptrs), end(*view_ptrs),
+                     [&](const RegionModel::View *view_ptr) {
+                       return view_ptr->orientation.dot(view.orientation) >
+                              max_dot;
+                     }))
+      view_ptrs->push_back(&view);
+  }
+}
+
+void TemplateDetector::GenerateTemplate(
+    const RegionModel::View &view, const Eigen::Matrix3f &body2camera_rotation,
+    float distance, Template *templ) const {
+  const auto &intrinsics{color_camera_ptr_->intrinsics()};
+  templ->level_features.assign(n_pyramid_levels_, {});
+  templ->body2camera_rotation = body2camera_rotation;
+  templ->distance = distance;
+
+  // Project evenly distributed contour points
+  int n_data_points = int(view.data_points.size());
+  int n_features = std::min(n_features_, n_data_points);
+  for (int i = 0; i < n_features; ++i) {
+    const auto &data_point{view.data_points[i * n_data_points / n_features]};
+    Eigen::Vector3f center{body2camera_rotation * data_point.center_f_body};
+    center.z() += distance;
+    if (center.z() <= 0.0f) continue;
+    Eigen::Vector3f normal{body2camera_rotation * data_point.normal_f_body};
+    float u = intrinsics.fu * center.x() / center.z();
+    float v = intrinsics.fv * center.y() / center.z();
+    int orientation = QuantizeAngle(
+        std::atan2(intrinsics.fv * normal.y(), intrinsics.fu * normal.x()));
+
+    // Scale offsets for each pyramid level
+    for (int level = 0; level < n_pyramid_levels_; ++level) {
+      float scale = 1.0f / float(1 << level);
+      templ->level_features[level].push_back(
+          Feature{int(std::round(u * scale)), int(std::round(v * scale)),
+                  orientation});
+    }
+  }
+}
+
+void TemplateDetector::GenerateResponseLUTs() {
+  // Response considers the angle between the template orientation and the
+  // most similar orientation that is spread to a pixel
+  for (int orientation = 0; orientation < kNOrientations; ++orientation) {
+    auto &response_lut{response_luts_[orientation]};
+    response_lut.create(1, 256, CV_8UC1);
+    for (int mask = 0; mask < 256; ++mask) {
+      int response = 0;
+      for (int i = 0; i < kNOrientations; ++i) {
+        if (!(mask & (1 << i))) continue;
+        int difference = std::abs(orientation - i);
+        difference = std::min(difference, kNOrientations - difference);
+        float cos_angle =
+            std::abs(std::cos(float(difference) * kPi / kNOrientations));
+        response =
+            std::max(response, int(std::round(kMaxResponse * cos_angle)));
+      }
+      response_lut.at<uchar>(mask) = uchar(response);
+    }
+  }
+}
+
+void TemplateDetector::CalculateResponseMaps() {
+  cv::Mat image;
+  cv::cvtColor(color_camera_ptr_->image(), image, cv::COLOR_BGR2GRAY);
+  level_response_maps_.resize(n_pyramid_levels_);
+  cv::Mat quantized_image, spread_image;
+  for (int level = 0; level < n_pyramid_levels_; ++level) {
+    if (level > 0) {
+      cv::Mat downsampled_image;
+      cv::pyrDown(image, downsampled_image);
+      image = downsampled_image;
+    }
+    QuantizeOrientations(image, &quantized_image);
+    SpreadOrientations(quantized_image, &spread_image);
+    auto &response_maps{level_response_maps_[level]};
+    response_maps.resize(kNOrientations);
+    for (int i = 0; i < kNOrientations; ++i)
+      cv::LUT(spread_image, response_luts_[i], response_maps[i]);
+  }
+}
+
+void TemplateDetector::QuantizeOrientations(const cv::Mat &image,
+                                            cv::Mat *quantized_image) const {
+  cv::Mat dx, dy, magnitude, angle;
+  cv::Sobel(image, dx, CV_32F, 1, 0);
+  cv::Sobel(image, dy, CV_32F, 0, 1);
+  cv::cartToPolar(dx, dy, magnitude, angle);
+
+  // Store quantized orientation as bit for strong gradients
+  *quantized_image = cv::Mat::zeros(image.size(), CV_8UC1);
+#pragma omp parallel for
+  for (int v = 0; v < image.rows; ++v) {
+    const auto *magnitude_row = magnitude.ptr<float>(v);
+    const auto *angle_row = angle.ptr<float>(v);
+    auto *quantized_row = quantized_image->ptr<uchar>(v);
+    for (int u = 0; u < image.cols; ++u) {
+      if (magnitude_row[u] < min_magnitude_) continue;
+      quantized_row[u] = uchar(1 << QuantizeAngle(angle_row[u]));
+    }
+  }
+}
+
+void TemplateDetector::SpreadOrientations(const cv::Mat &quantized_image,
+                                          cv::Mat *spread_image) const {
+  // Spreading is separable and computed first along rows and then along
+  // columns
+  int rows = quantized_image.rows;
+  int cols = quantized_image.cols;
+  cv::Mat row_spread_image{quantized_image.clone()};
+  for (int d = 1; d <= kSpreadRadius && d < cols; ++d) {
+    cv::Mat left{row_spread_image.colRange(0, cols - d)};
+    cv::Mat right{row_spread_image.colRange(d, cols)};
+    cv::bitwise_or(left, quantized_image.colRange(d, cols), left);
+    cv::bitwise_or(right, quantized_image.colRange(0, cols - d), right);
+  }
+  *spread_image = row_spread_image.clone();
+  for (int d = 1; d <= kSpreadRadius && d < rows; ++d) {
+    cv::Mat top{spread_image->rowRange(0, rows - d)};
+    cv::Mat bottom{spread_image->rowRange(d, rows)};
+    cv::bitwise_or(top, row_spread_image.rowRange(d, rows), top);
+    cv::bitwise_or(bottom, row_spread_image.rowRange(0, rows - d), bottom);
+  }
+}
+
+void TemplateDetector::MatchTemplatesOnCoarsestLevel(
+    std::vector<Match> *matches) const {
+  int level = n_pyramid_levels_ - 1;
+  const auto &response_maps{level_response_maps_[level]};
+  int rows = response_maps[0].rows;
+  int cols = response_maps[0].cols;
+  int n_templates = int(templates_.size());
+  matches->resize(n_templates);
+
+#pragma omp parallel
+  {
+    cv::Mat scores{rows, cols, CV_16UC1};
+#pragma omp for schedule(dynamic)
+    for (int i = 0; i < n_templates; ++i) {
+      // Accumulate responses of all features for all body origins
+      const auto &features{templates_[i].level_features[level]};
+      scores.setTo(0);
+      for (const auto &feature : features) {
+        const auto &response_map{response_maps[feature.orientation]};
+        int v_begin = std::max(0, -feature.v);
+        int v_end = std::min(rows, rows - feature.v);
+        int u_begin = std::max(0, -feature.u);
+        int u_end = std::min(cols, cols - feature.u);
+        for (int v = v_begin; v < v_end; ++v) {
+          const auto *response_row = response_map.ptr<uchar>(v + feature.v);
+          auto *score_row = scores.ptr<ushort>(v);
+#pragma omp simd
+          for (int u = u_begin; u < u_end; ++u)
+            score_row[u] += response_row[u + feature.u];
+        }
+      }
+
+      // Find best body origin
+      double max_score;
+      cv::Point max_location;
+      cv::minMaxLoc(scores, nullptr, &max_score, nullptr, &max_location);
+      (*matches)[i] = Match{
+          i, max_location.x, max_location.y,
+          float(max_score) / float(kMaxResponse * int(features.size()))};
+    }
+  }
+}
+
+void TemplateDetector::RefineMatch(int level, Match *match) const {
+  const auto &features{templates_[match->template_idx].level_features[level]};
+  const auto &response_maps{level_response_maps_[level]};
+  int u_center = 2 * match->u;
+  int v_center = 2 * match->v;
+
+  // Search best location in window around upsampled location
+  int max_score = -1;
+  for (int v = v_center - kRefinementRadius; v <= v_center + kRefinementRadius;
+       ++v) {
+    for (int u = u_center - kRefinementRadius;
+         u <= u_center + kRefinementRadius; ++u) {
+      int score = CalculateScore(features, response_maps, u, v);
+      if (score > max_score) {
+        max_score = score;
+        match->u = u;
+        match->v = v;
+      }
+    }
+  }
+  match->similarity =
+      float(max_score) / float(kMaxResponse * int(features.size()));
+}
+
+int TemplateDetector::CalculateScore(const std::vector<Feature> &features,
+                                     const std::vector<cv::Mat> &response_maps,
+                                     int u, int v) const {
+  int rows = response_maps[0].rows;
+  int cols = response_maps[0].cols;
+  int score = 0;
+  for (const auto &feature : features) {
+    int feature_u = u + feature.u;
+    int feature_v = v + feature.v;
+    if (feature_u < 0 || feature_u >= cols || feature_v < 0 ||
+        feature_v >= rows)
+      continue;
+    score += response_maps[feature.orientation].at<uchar>(feature_v,
+                                                          feature_u);
+  }
+  return score;
+}
+
+void TemplateDetector::CalculatePose(const Match &match,
+                                     Transform3fA *link2world_pose) const {
+  // Rotate template from optical axis to the ray of the detected origin
+  const auto &templ{templates_[match.template_idx]};
+  const auto &intrinsics{color_camera_ptr_->intrinsics()};
+  Eigen::Vector3f ray{(float(match.u) - intrinsics.ppu) / intrinsics.fu,
+                      (float(match.v) - intrinsics.ppv) / intrinsics.fv, 1.0f};
+  Eigen::Matrix3f ray_rotation{
+      Eigen::Quaternionf::FromTwoVectors(Eigen::Vector3f::UnitZ(), ray)
+          .toRotationMatrix()};
+
+  Transform3fA body2camera_pose{Transform3fA::Identity()};
+  body2camera_pose.translation() = ray.normalized() * templ.distance;
+  body2camera_pose.linear() = ray_rotation * templ.body2camera_rotation;
+  *link2world_pose = color_camera_ptr_->camera2world_pose() * body2camera_pose;
+}
+
+int TemplateDetector::QuantizeAngle(float angle) {
+  // Orientations are quantized independent of the gradient sign
+  float normalized_angle = std::fmod(angle, kPi);
+  if (normalized_angle < 0.0f) normalized_angle += kPi;
+  int orientation = int(normalized_angle * float(kNOrientations) / kPi);
+  return std::min(orientation, kNOrientations - 1);
+}
+
+}  // namespace m3t
@@ -54,6 +54,11 @@ bool TextureModality::SetUp() {
               << " was not set up" << std::endl;
     return false;
   }
+  if (use_feature_cache_ && !feature_cache_ptr_->set_up()) {
+    std::cerr << "Feature cache " << feature_cache_ptr_->name()
+              << " was not set up" << std::endl;
+    return false;
+  }
 
   // Check if all required objects are correctly configured
   if (silhouette_renderer_ptr_->id_type() != IDType::BODY) {
@@ -62,7 +67,28 @@ bool TextureModality::SetUp() {
               << " does not use id_type BODY" << std::endl;
   }
 
+  if (use_feature_cache_) {
+    if (feature_cache_ptr_->color_camera_ptr()->name() !=
+        color_camera_ptr_->name()) {
+      std::cerr << "Feature cache " << feature_cache_ptr_->name()
+                << " does not use color camera " << color_camera_ptr_->name()
+                << std::endl;
+      return false;
+    }
+#ifdef USE_CUDA
+    if (descriptor_type_ == DescriptorType::ORB_CUDA) {
+      std::cerr << "Feature cache " << feature_cache_ptr_->name()
+                << " does not support descriptor type ORB_CUDA" << std::endl;
+      return false;
+    }
+#endif
+  }
+
   SetUpFeatureDetectorAndMatcher();
+  if (use_feature_cache_ &&
+      !feature_cache_ptr_->AddRequest(name_, body_ptr_, focused_image_size_,
+                                      feature_detector_, feature_descriptor_))
+    return false;
   PrecalculateCameraVariables();
   PrecalculateRendererVariables();
   SetImshowVariables();
@@ -102,6 +128,10 @@ void TextureModality::set_descriptor_distance_threshold(
   descriptor_distance_threshold_ = descriptor_distance_threshold;
 }
 
+void TextureModality::set_max_hamming_distance(int max_hamming_distance) {
+  max_hamming_distance_ = max_hamming_distance;
+}
+
 void TextureModality::set_standard_deviations(
     const std::vector<float> &standard_deviations) {
   standard_deviations_ = standard_deviations;
@@ -217,6 +247,45 @@ void TextureModality::set_sift_sigma(double sift_sigma) {
   set_up_ = false;
 }
 
+void TextureModality::set_use_silhouette_mask(bool use_silhouette_mask) {
+  use_silhouette_mask_ = use_silhouette_mask;
+}
+
+void TextureModality::set_silhouette_mask_dilation(
+    int silhouette_mask_dilation) {
+  silhouette_mask_dilation_ = silhouette_mask_dilation;
+}
+
+void TextureModality::set_use_klt_propagation(bool use_klt_propagation) {
+  use_klt_propagation_ = use_klt_propagation;
+  propagation_image_.release();
+}
+
+void TextureModality::set_klt_detection_interval(int klt_detection_interval) {
+  klt_detection_interval_ = klt_detection_interval;
+}
+
+void TextureModality::set_klt_min_n_points(int klt_min_n_points) {
+  klt_min_n_points_ = klt_min_n_points;
+}
+
+void TextureModality::set_klt_window_size(int klt_window_size) {
+  klt_window_size_ = klt_window_size;
+}
+
+void TextureModality::set_klt_n_pyramid_levels(int klt_n_pyramid_levels) {
+  klt_n_pyramid_levels_ = klt_n_pyramid_levels;
+}
+
+void TextureModality::set_klt_max_error(float klt_max_error) {
+  klt_max_error_ = klt_max_error;
+}
+
+void TextureModality::set_klt_max_forward_backward_error(
+    float klt_max_forward_backward_error) {
+  klt_max_forward_backward_error_ = klt_max_forward_backward_error;
+}
+
 void TextureModality::MeasureOcclusions(
     const std::shared_ptr<DepthCamera> &depth_camera_ptr) {
   depth_camera_ptr_ = depth_camera_ptr;
@@ -262,6 +331,20 @@ void TextureModality::set_modeled_occlusion_threshold(
   modeled_occlusion_threshold_ = modeled_occlusion_threshold;
 }
 
+void TextureModality::UseFeatureCache(
+    const std::shared_ptr<FeatureCache> &feature_cache_ptr) {
+  feature_cache_ptr_ = feature_cache_ptr;
+  use_feature_cache_ = true;
+  set_up_ = false;
+}
+
+void TextureModality::DoNotUseFeatureCache() {
+  if (feature_cache_ptr_) feature_cache_ptr_->DeleteRequest(name_);
+  feature_cache_ptr_ = nullptr;
+  use_feature_cache_ = false;
+  set_up_ = false;
+}
+
 void TextureModality::set_visualize_correspondences_correspondence(
     bool visualize_correspondences_correspondence) {
   visualize_correspondences_correspondence_ =
@@ -318,6 +401,7 @@ bool TextureModality::StartModality(int iteration, int corr_iteration) {
   PrecalculatePoseVariables();
   DetectAndComputeCorrKeypoints();
   ComputeKeyframeData();
+  propagation_image_.release();
   return true;
 }
 
@@ -329,8 +413,11 @@ bool TextureModality::CalculateCorrespondences(int iteration,
   PrecalculateIterationDependentVariables(corr_iteration);
 
   // Calculate matches and reconstruct data points
-  if (corr_iteration == 0) {
+  if (corr_iteration == 0)
+    data_points_propagated_ = use_klt_propagation_ && PropagateDataPoints();
+  if (corr_iteration == 0 && !data_points_propagated_) {
     // Match descriptors
+    n_frames_since_detection_ = 0;
     DetectAndComputeCorrKeypoints();
     std::vector<std::vector<std::vector<cv::DMatch>>> knn_matches_keyframes;
 #ifdef USE_CUDA
@@ -345,7 +432,9 @@ bool TextureModality::CalculateCorrespondences(int iteration,
       }
     } else
 #endif
-    {
+    if (use_binary_matcher_) {
+      MatchBinaryDescriptors();
+    } else {
       for (const auto &descriptors_keyframe : descriptors_keyframes_) {
         std::vector<std::vector<cv::DMatch>> knn_matches;
         if (!descriptors_keyframe.empty() && !descriptors_.empty())
@@ -357,6 +446,15 @@ bool TextureModality::CalculateCorrespondences(int iteration,
 
     // Compute data points
     data_points_.clear();
+    for (const auto &binary_match : binary_matches_) {
+      DataPoint data_point;
+      data_point.correspondence_center =
+          Eigen::Vector2f{keypoints_[binary_match.idx].pt.x,
+                          keypoints_[binary_match.idx].pt.y};
+      data_point.center_f_body = points_keyframes_[binary_match.keyframe_id]
+                                                  [binary_match.keyframe_idx];
+      data_points_.push_back(std::move(data_point));
+    }
     for (size_t i = 0; i < knn_matches_keyframes.size(); ++i) {
       const std::vector<std::vector<cv::DMatch>> &knn_matches{knn_matches_keyframes[i]};
       const std::vector<Eigen::Vector3f> &points_keyframe{points_keyframes_[i]};
@@ -375,6 +473,7 @@ bool TextureModality::CalculateCorrespondences(int iteration,
       }
     }
   }
+  if (corr_iteration == 0 && use_klt_propagation_) UpdatePropagationImage();
 
   // Compute iteration dependent data points
   for (auto &data_point : data_points_) {
@@ -464,10 +563,15 @@ bool TextureModality::CalculateResults(int iteration) {
       acos(orientation.transpose() * orientation_last_keyframe_);
   keyframe_age_++;
 
+  // Remove propagated correspondences that drifted away
+  if (use_klt_propagation_) RemoveInconsistentDataPoints();
+
   // Compute new data if difference is above threshold
   if (rotation_difference > max_keyframe_rotation_difference_ ||
-      keyframe_age_ > max_keyframe_age_)
+      keyframe_age_ > max_keyframe_age_) {
+    if (!keypoints_current_) DetectAndComputeCorrKeypoints();
     ComputeKeyframeData();
+  }
   return true;
 }
 
@@ -507,6 +611,17 @@ TextureModality::depth_renderer_ptr() const {
   return depth_renderer_ptr_;
 }
 
+const std::shared_ptr<FeatureCache> &TextureModality::feature_cache_ptr()
+    const {
+  return feature_cache_ptr_;
+}
+
+int TextureModality::n_data_points() const { return int(data_points_.size()); }
+
+bool TextureModality::data_points_propagated() const {
+  return data_points_propagated_;
+}
+
 std::shared_ptr<Model> TextureModality::model_ptr() const { return {}; }
 
 std::vector<std::shared_ptr<Camera>> TextureModality::camera_ptrs() const {
@@ -533,6 +648,10 @@ float TextureModality::descriptor_distance_threshold() const {
   return descriptor_distance_threshold_;
 }
 
+int TextureModality::max_hamming_distance() const {
+  return max_hamming_distance_;
+}
+
 float TextureModality::tukey_norm_constant() const {
   return tukey_norm_constant_;
 }
@@ -601,6 +720,36 @@ double TextureModality::sift_edge_threshold() const {
 
 double TextureModality::sift_sigma() const { return sift_sigma_; }
 
+bool TextureModality::use_silhouette_mask() const {
+  return use_silhouette_mask_;
+}
+
+int TextureModality::silhouette_mask_dilation() const {
+  return silhouette_mask_dilation_;
+}
+
+bool TextureModality::use_klt_propagation() const {
+  return use_klt_propagation_;
+}
+
+int TextureModality::klt_detection_interval() const {
+  return klt_detection_interval_;
+}
+
+int TextureModality::klt_min_n_points() const { return klt_min_n_points_; }
+
+int TextureModality::klt_window_size() const { return klt_window_size_; }
+
+int TextureModality::klt_n_pyramid_levels() const {
+  return klt_n_pyramid_levels_;
+}
+
+float TextureModality::klt_max_error() const { return klt_max_error_; }
+
+float TextureModality::klt_max_forward_backward_error() const {
+  return klt_max_forward_backward_error_;
+}
+
 bool TextureModality::measure_occlusions() const { return measure_occlusions_; }
 
 float TextureModality::measured_occlusion_radius() const {
@@ -621,6 +770,8 @@ float TextureModality::modeled_occlusion_threshold() const {
   return modeled_occlusion_threshold_;
 }
 
+bool TextureModality::use_feature_cache() const { return use_feature_cache_; }
+
 bool TextureModality::visualize_correspondences_correspondence() const {
   return visualize_correspondences_correspondence_;
 }
@@ -663,6 +814,7 @@ bool TextureModality::LoadMetaData() {
   ReadOptionalValueFromYaml(fs, "focused_image_size", &focused_image_size_);
   ReadOptionalValueFromYaml(fs, "descriptor_distance_threshold",
                             &descriptor_distance_threshold_);
+  ReadOptionalValueFromYaml(fs, "max_hamming_distance", &max_hamming_distance_);
   ReadOptionalValueFromYaml(fs, "tukey_norm_constant", &tukey_norm_constant_);
   ReadOptionalValueFromYaml(fs, "standard_deviations", &standard_deviations_);
   ReadOptionalValueFromYaml(fs, "max_keyframe_rotation_difference",
@@ -690,6 +842,21 @@ bool TextureModality::LoadMetaData() {
                             &sift_contrast_threshold_);
   ReadOptionalValueFromYaml(fs, "sift_edge_threshold", &sift_edge_threshold_);
   ReadOptionalValueFromYaml(fs, "sift_sigma", &sift_sigma_);
+  ReadOptionalValueFromYaml(fs, "use_silhouette_mask", &use_silhouette_mask_);
+  ReadOptionalValueFromYaml(fs, "silhouette_mask_dilation",
+                            &silhouette_mask_dilation_);
+
+  // Read parameters from yaml file for feature propagation
+  ReadOptionalValueFromYaml(fs, "use_klt_propagation", &use_klt_propagation_);
+  ReadOptionalValueFromYaml(fs, "klt_detection_interval",
+                            &klt_detection_interval_);
+  ReadOptionalValueFromYaml(fs, "klt_min_n_points", &klt_min_n_points_);
+  ReadOptionalValueFromYaml(fs, "klt_window_size", &klt_window_size_);
+  ReadOptionalValueFromYaml(fs, "klt_n_pyramid_levels",
+                            &klt_n_pyramid_levels_);
+  ReadOptionalValueFromYaml(fs, "klt_max_error", &klt_max_error_);
+  ReadOptionalValueFromYaml(fs, "klt_max_forward_backward_error",
+                            &klt_max_forward_backward_error_);
 
   // Read parameters from yaml file for occlusion handling
   ReadOptionalValueFromYaml(fs, "measured_occlusion_radius",
@@ -797,6 +964,15 @@ void TextureModality::SetUpFeatureDetectorAndMatcher() {
     else
       descriptor_matcher_ = cv::BFMatcher::create(cv::NORM_HAMMING);
   }
+
+  // Binary descriptors are matched with the internal Hamming matcher
+  use_binary_matcher_ = descriptor_type_ == DescriptorType::BRISK ||
+                        descriptor_type_ == DescriptorType::FREAK ||
+                        descriptor_type_ == DescriptorType::ORB;
+  binary_descriptors_keyframes_.release();
+  binary_keyframe_ids_.clear();
+  binary_keyframe_idxs_.clear();
+  binary_matches_.clear();
 }
 
 void TextureModality::SetImshowVariables() {
@@ -817,8 +993,6 @@ void TextureModality::PrecalculateCameraVariables() {
   fv_ = color_camera_ptr_->intrinsics().fv;
   ppu_ = color_camera_ptr_->intrinsics().ppu;
   ppv_ = color_camera_ptr_->intrinsics().ppv;
-  image_width_minus_1_ = color_camera_ptr_->intrinsics().width - 1;
-  image_height_minus_1_ = color_camera_ptr_->intrinsics().height - 1;
   if (measure_occlusions_) {
     depth_fu_ = depth_camera_ptr_->intrinsics().fu;
     depth_fv_ = depth_camera_ptr_->intrinsics().fv;
@@ -858,30 +1032,42 @@ void TextureModality::PrecalculateIterationDependentVariables(
 void TextureModality::DetectAndComputeCorrKeypoints() {
   keypoints_.clear();
 
+  // Obtain shared keypoints and descriptors
+  if (use_feature_cache_) {
+    feature_cache_ptr_->GetFeatures(name_, &keypoints_, &descriptors_);
+    if (use_silhouette_mask_) FilterKeypointsWithSilhouetteMask();
+    keypoints_current_ = true;
+    return;
+  }
+
   // Compute focused image
   cv::Mat focused_image;
   cv::Rect region_of_interest;
   float scale;
   if (!CalculateScaleAndRegionOfInterest(&region_of_interest, &scale)) return;
 
-  //My_debug
-  // cv::Mat debug_image = color_camera_ptr_->image();
-  // std::cout << "Debug image TextureModality::DetectAndComputeCorrKeypoints" << debug_image << std::endl; 
-
   cv::cvtColor(color_camera_ptr_->image(), focused_image, cv::COLOR_BGR2GRAY);
   cv::resize(focused_image(region_of_interest), focused_image, cv::Size(),
              scale, scale);
 
+  // Compute mask from silhouette rendering
+  cv::Mat mask;
+  if (use_silhouette_mask_)
+    CalculateSilhouetteMask(region_of_interest, scale, focused_image.size(),
+                            &mask);
+
   // Detect features and compute descriptors
 #ifdef USE_CUDA
   if (descriptor_type_ == DescriptorType::ORB_CUDA) {
     cv::cuda::GpuMat focused_image_cuda{focused_image};
+    cv::cuda::GpuMat mask_cuda;
+    if (!mask.empty()) mask_cuda.upload(mask);
     feature_detector_orb_cuda_->detectAndCompute(
-        focused_image_cuda, cv::noArray(), keypoints_, descriptors_cuda_);
+        focused_image_cuda, mask_cuda, keypoints_, descriptors_cuda_);
   } else
 #endif
   {
-    feature_detector_->detect(focused_image, keypoints_);
+    feature_detector_->detect(focused_image, keypoints_, mask);
     feature_descriptor_->compute(focused_image, keypoints_, descriptors_);
   }
 
@@ -890,84 +1076,77 @@ void TextureModality::DetectAndComputeCorrKeypoints() {
     corr_keypoint.pt.x = region_of_interest.x + corr_keypoint.pt.x / scale;
     corr_keypoint.pt.y = region_of_interest.y + corr_keypoint.pt.y / scale;
   }
+  keypoints_current_ = true;
 }
 
 bool TextureModality::CalculateScaleAndRegionOfInterest(
     cv::Rect *region_of_interest, float *scale) const {
-  // Project sphere into image
-  float r = 0.5f * body_ptr_->maximum_body_diameter();
-  auto translation{body2camera_pose_.translation()};
-  float x = translation(0);
-  float y = translation(1);
-  float z = translation(2);
-  if (z < r * 1.5f) return false;
-  float abs_x = std::abs(x);
-  float abs_y = std::abs(y);
-  float x2 = x * x;
-  float y2 = y * y;
-  float z2 = z * z;
-  float r2 = r * r;
-  float rz = r * z;
-  float z2_r2 = z2 - r2;
-  float z3_zr2 = z2_r2 * z;
-  float r_u = fu_ * (abs_x * r2 + rz * sqrtf(z2_r2 + x2)) / z3_zr2;
-  float r_v = fv_ * (abs_y * r2 + rz * sqrtf(z2_r2 + y2)) / z3_zr2;
-  float center_u = x * fu_ / z + ppu_;
-  float center_v = y * fv_ / z + ppv_;
-
-  // Calculate region of interest
-  int u_min = int(center_u - r_u - kRegionOfInterestMargin + 0.5f);
-  int u_max = int(center_u + r_u + kRegionOfInterestMargin + 0.5f);
-  int v_min = int(center_v - r_v - kRegionOfInterestMargin + 0.5f);
-  int v_max = int(center_v + r_v + kRegionOfInterestMargin + 0.5f);
-  u_min = std::max(u_min, 0);
-  u_max = std::min(u_max, image_width_minus_1_);
-  v_min = std::max(v_min, 0);
-  v_max = std::min(v_max, image_height_minus_1_);
-  if (u_min >= u_max || v_min >= v_max) return false;
-  region_of_interest->x = u_min;
-  region_of_interest->y = v_min;
-  region_of_interest->width = u_max - u_min;
-  region_of_interest->height = v_max - v_min;
-
-  // Calculate scale
-  *scale = float(focused_image_size_) / std::max(2.0f * r_u, 2.0f * r_v);
-  return true;
+  return m3t::CalculateScaleAndRegionOfInterest(
+      body2camera_pose_, 0.5f * body_ptr_->maximum_body_diameter(),
+      color_camera_ptr_->intrinsics(), focused_image_size_,
+      kRegionOfInterestMargin, region_of_interest, scale);
 }
 
-void TextureModality::ComputeKeyframeData() {
-  if (points_keyframes_.size() >= n_keyframes_) {
-    // // My_debug
-    // for (const auto &points_keyframe : points_keyframes_) {
-    //   if (points_keyframe.empty()) std::cout << "Point's empty" << std::endl;
-    // }
-
-    points_keyframes_.pop_front();
+bool TextureModality::CalculateSilhouetteMask(
+    const cv::Rect &region_of_interest, float scale, const cv::Size &size,
+    cv::Mat *mask) {
+  if (!silhouette_renderer_ptr_->IsBodyVisible(body_ptr_->name())) return false;
+  silhouette_renderer_ptr_->FetchSilhouetteImage();
+  cv::Mat silhouette{silhouette_renderer_ptr_->focused_silhouette_image() ==
+                     body_ptr_->body_id()};
+
+  // Transform silhouette from focused rendering into focused image
+  float silhouette_scale = silhouette_renderer_ptr_->scale();
+  cv::Matx23f transformation{
+      scale / silhouette_scale,
+      0.0f,
+      (silhouette_renderer_ptr_->corner_u() - region_of_interest.x) * scale,
+      0.0f,
+      scale / silhouette_scale,
+      (silhouette_renderer_ptr_->corner_v() - region_of_interest.y) * scale};
+  cv::warpAffine(silhouette, *mask, transformation, size, cv::INTER_NEAREST,
+                 cv::BORDER_CONSTANT, cv::Scalar{0});
+
+  // Dilate mask
+  if (silhouette_mask_dilation_ > 0) {
+    int kernel_size = 2 * silhouette_mask_dilation_ + 1;
+    cv::dilate(*mask, *mask,
+               cv::getStructuringElement(cv::MORPH_ELLIPSE,
+                                         cv::Size{kernel_size, kernel_size}));
+  }
+  return true;
+}
 
-    // // My_debug
-    // for (const auto &points_keyframe : points_keyframes_) {
-    //   if (points_keyframe.empty()) std::cout << "Point's empty" << std::endl;
-    // }
-#ifdef USE_CUDA
-    if (descriptor_type_ == DescriptorType::ORB_CUDA)
-      descriptors_keyframes_cuda_.pop_front();
-    else
-#endif
-      // // My_debug
-      // for (const auto &descriptors_keyframe : descriptors_keyframes_) {
-      //   if (!descriptors_keyframe.empty() && !descriptors_.empty())
-      //     std::cout << "Desctiptor's empty" << std::endl;
-      // }
-
-    descriptors_keyframes_.pop_front();
-
-    // // My_debug
-    // for (const auto &descriptors_keyframe : descriptors_keyframes_) {
-    //   if (!descriptors_keyframe.empty() && !descriptors_.empty())
-    //     std::cout << "Desctiptor's empty" << std::endl;
-    // }
+void TextureModality::FilterKeypointsWithSilhouetteMask() {
+  // Compute mask in the focused image that would be used for detection
+  cv::Rect region_of_interest;
+  float scale;
+  if (!CalculateScaleAndRegionOfInterest(&region_of_interest, &scale)) return;
+  cv::Size size{int(region_of_interest.width * scale + 0.5f),
+                int(region_of_interest.height * scale + 0.5f)};
+  cv::Mat mask;
+  if (!CalculateSilhouetteMask(region_of_interest, scale, size, &mask)) return;
+
+  // Keep keypoints and descriptors inside the mask
+  std::vector<int> indexes;
+  for (int i = 0; i < int(keypoints_.size()); ++i) {
+    int u = int((keypoints_[i].pt.x - region_of_interest.x) * scale);
+    int v = int((keypoints_[i].pt.y - region_of_interest.y) * scale);
+    if (u < 0 || u >= mask.cols || v < 0 || v >= mask.rows) continue;
+    if (mask.at<uchar>(v, u)) indexes.push_back(i);
   }
+  std::vector<cv::KeyPoint> keypoints(indexes.size());
+  cv::Mat descriptors(int(indexes.size()), descriptors_.cols,
+                      descriptors_.type());
+  for (size_t i = 0; i < indexes.size(); ++i) {
+    keypoints[i] = keypoints_[indexes[i]];
+    descriptors_.row(indexes[i]).copyTo(descriptors.row(int(i)));
+  }
+  keypoints_ = std::move(keypoints);
+  descriptors_ = descriptors;
+}
 
+void TextureModality::ComputeKeyframeData() {
   // Fetch depth and silhouette images
   if (!silhouette_renderer_ptr_->IsBodyVisible(body_ptr_->name())) return;
   silhouette_renderer_ptr_->FetchDepthImage();
@@ -990,19 +1169,19 @@ void TextureModality::ComputeKeyframeData() {
     points_keyframe.push_back(std::move(point));
     indexes.push_back(i);
   }
-  // My_debug
-  if (points_keyframe.empty()){
-    std::cout << "#### Point's empty" << std::endl;
-  } 
-  else{
-    points_keyframes_.push_back(std::move(points_keyframe));
-  }
-  
 
-  // // My_debug
-  // for (const auto &points_keyframe : points_keyframes_) {
-  //   if (points_keyframe.empty()) std::cout << "Point's empty" << std::endl;
-  // }
+  // Only replace the oldest keyframe if the new keyframe is valid
+  if (points_keyframe.empty()) return;
+  if (points_keyframes_.size() >= n_keyframes_) {
+    points_keyframes_.pop_front();
+#ifdef USE_CUDA
+    if (descriptor_type_ == DescriptorType::ORB_CUDA)
+      descriptors_keyframes_cuda_.pop_front();
+    else
+#endif
+      descriptors_keyframes_.pop_front();
+  }
+  points_keyframes_.push_back(std::move(points_keyframe));
 
   // Copy descriptors
 #ifdef USE_CUDA
@@ -1020,20 +1199,8 @@ void TextureModality::ComputeKeyframeData() {
                                  descriptors_.type());
     for (size_t i = 0; i < indexes.size(); ++i)
       descriptors_.row(indexes[i]).copyTo(descriptors_keyframe.row(i));
-
-    // My_debug
-    for (const auto &descriptors_keyframe : descriptors_keyframes_) {
-      if (!descriptors_keyframe.empty() && !descriptors_.empty())
-        std::cout << "Desctiptor's empty" << std::endl;
-    }
-
     descriptors_keyframes_.push_back(std::move(descriptors_keyframe));
-
-    // // My_debug
-    // for (const auto &descriptors_keyframe : descriptors_keyframes_) {
-    //   if (!descriptors_keyframe.empty() && !descriptors_.empty())
-    //     std::cout << "Desctiptor's empty" << std::endl;
-    // }
+    if (use_binary_matcher_) UpdateBinaryDescriptorStore();
   }
 
   // Store orientation
@@ -1043,6 +1210,222 @@ void TextureModality::ComputeKeyframeData() {
   keyframe_age_ = 0;
 }
 
+bool TextureModality::PropagateDataPoints() {
+  if (propagation_image_.empty() || data_points_.empty()) return false;
+  if (++n_frames_since_detection_ >= klt_detection_interval_) return false;
+  if (int(data_points_.size()) < klt_min_n_points_) return false;
+
+  // Convert current image cropped at the previous region of interest
+  cv::Mat image;
+  cv::cvtColor(color_camera_ptr_->image()(propagation_region_), image,
+               cv::COLOR_BGR2GRAY);
+
+  // Track correspondence centers from previous image
+  std::vector<cv::Point2f> previous_centers;
+  previous_centers.reserve(data_points_.size());
+  for (const auto &data_point : data_points_)
+    previous_centers.emplace_back(
+        data_point.correspondence_center(0) - propagation_region_.x,
+        data_point.correspondence_center(1) - propagation_region_.y);
+  std::vector<cv::Point2f> centers;
+  std::vector<uchar> status;
+  std::vector<float> errors;
+  cv::Size window_size{klt_window_size_, klt_window_size_};
+  cv::calcOpticalFlowPyrLK(propagation_image_, image, previous_centers,
+                           centers, status, errors, window_size,
+                           klt_n_pyramid_levels_ - 1);
+
+  // Track propagated centers back to the previous image
+  std::vector<cv::Point2f> backtracked_centers;
+  std::vector<uchar> backtracked_status;
+  std::vector<float> backtracked_errors;
+  cv::calcOpticalFlowPyrLK(image, propagation_image_, centers,
+                           backtracked_centers, backtracked_status,
+                           backtracked_errors, window_size,
+                           klt_n_pyramid_levels_ - 1);
+
+  // Keep data points that were tracked consistently with a low error
+  size_t n_data_points = 0;
+  for (size_t i = 0; i < data_points_.size(); ++i) {
+    if (!status[i] || !backtracked_status[i]) continue;
+    if (errors[i] > klt_max_error_) continue;
+    if (cv::norm(backtracked_centers[i] - previous_centers[i]) >
+        klt_max_forward_backward_error_)
+      continue;
+    DataPoint &data_point{data_points_[n_data_points++]};
+    data_point = data_points_[i];
+    data_point.correspondence_center =
+        Eigen::Vector2f{centers[i].x + propagation_region_.x,
+                        centers[i].y + propagation_region_.y};
+  }
+  data_points_.resize(n_data_points);
+  keypoints_current_ = false;
+  return int(n_data_points) >= klt_min_n_points_;
+}
+
+void TextureModality::UpdatePropagationImage() {
+  float scale;
+  if (!CalculateScaleAndRegionOfInterest(&propagation_region_, &scale)) {
+    propagation_image_.release();
+    return;
+  }
+  cv::cvtColor(color_camera_ptr_->image()(propagation_region_),
+               propagation_image_, cv::COLOR_BGR2GRAY);
+}
+
+void TextureModality::RemoveInconsistentDataPoints() {
+  Transform3fA body2camera_pose{color_camera_ptr_->world2camera_pose() *
+                                body_ptr_->body2world_pose()};
+  float max_squared_error = tukey_norm_constant_ * tukey_norm_constant_;
+  data_points_.erase(
+      std::remove_if(
+          begin(data_points_), end(data_points_),
+          [&](const DataPoint &data_point) {
+            Eigen::Vector3f center_f_camera{body2camera_pose *
+                                            data_point.center_f_body};
+            Eigen::Vector2f center{
+                center_f_camera(0) * fu_ / center_f_camera(2) + ppu_,
+                center_f_camera(1) * fv_ / center_f_camera(2) + ppv_};
+            return (center - data_point.correspondence_center).squaredNorm() >
+                   max_squared_error;
+          }),
+      end(data_points_));
+}
+
+void TextureModality::UpdateBinaryDescriptorStore() {
+  // Count descriptors and determine padded row size
+  int n_descriptors = 0;
+  int descriptor_size = 0;
+  for (const auto &descriptors_keyframe : descriptors_keyframes_) {
+    n_descriptors += descriptors_keyframe.rows;
+    descriptor_size = std::max(descriptor_size, descriptors_keyframe.cols);
+  }
+  n_binary_descriptor_blocks_ =
+      (descriptor_size + kBinaryDescriptorBlockSize - 1) /
+      kBinaryDescriptorBlockSize;
+
+  // Copy descriptors of all keyframes into one contiguous zero-padded store
+  binary_descriptors_keyframes_.create(
+      n_descriptors, n_binary_descriptor_blocks_ * kBinaryDescriptorBlockSize,
+      CV_8U);
+  binary_descriptors_keyframes_.setTo(0);
+  binary_keyframe_ids_.resize(n_descriptors);
+  binary_keyframe_idxs_.resize(n_descriptors);
+  int row = 0;
+  for (int id = 0; id < int(descriptors_keyframes_.size()); ++id) {
+    const cv::Mat &descriptors_keyframe{descriptors_keyframes_[id]};
+    for (int idx = 0; idx < descriptors_keyframe.rows; ++idx, ++row) {
+      std::memcpy(binary_descriptors_keyframes_.ptr<uchar>(row),
+                  descriptors_keyframe.ptr<uchar>(idx),
+                  descriptors_keyframe.cols);
+      binary_keyframe_ids_[row] = id;
+      binary_keyframe_idxs_[row] = idx;
+    }
+  }
+  binary_matches_.reserve(n_descriptors);
+}
+
+void TextureModality::MatchBinaryDescriptors() {
+  binary_matches_.clear();
+  if (binary_descriptors_keyframes_.empty() || descriptors_.rows < 2) return;
+
+  // Use descriptors directly if rows already have the padded layout
+  const cv::Mat *descriptors_ptr = &descriptors_;
+  int row_size = n_binary_descriptor_blocks_ * kBinaryDescriptorBlockSize;
+  if (descriptors_.cols != row_size || !descriptors_.isContinuous()) {
+    if (binary_descriptors_.rows < descriptors_.rows ||
+        binary_descriptors_.cols != row_size)
+      binary_descriptors_.create(descriptors_.rows, row_size, CV_8U);
+    binary_descriptors_.setTo(0);
+    int n_bytes = std::min(descriptors_.cols, row_size);
+    for (int i = 0; i < descriptors_.rows; ++i)
+      std::memcpy(binary_descriptors_.ptr<uchar>(i), descriptors_.ptr<uchar>(i),
+                  n_bytes);
+    descriptors_ptr = &binary_descriptors_;
+  }
+
+  // Find the two nearest neighbors and apply thresholds inline
+  const cv::Mat descriptors{descriptors_ptr->rowRange(0, descriptors_.rows)};
+  int idx;
+  for (int i = 0; i < binary_descriptors_keyframes_.rows; ++i) {
+    if (MatchBinaryDescriptor(binary_descriptors_keyframes_.ptr<uchar>(i),
+                              descriptors, n_binary_descriptor_blocks_,
+                              max_hamming_distance_,
+                              descriptor_distance_threshold_, &idx))
+      binary_matches_.push_back(BinaryMatch{binary_keyframe_ids_[i],
+                                            binary_keyframe_idxs_[i], idx});
+  }
+}
+
+bool TextureModality::MatchBinaryDescriptor(const uchar *descriptor,
+                                            const cv::Mat &descriptors,
+                                            int n_blocks,
+                                            int max_hamming_distance,
+                                            float descriptor_distance_threshold,
+                                            int *idx) {
+  int min_distance = std::numeric_limits<int>::max();
+  int second_min_distance = std::numeric_limits<int>::max();
+  int min_idx = 0;
+  for (int j = 0; j < descriptors.rows; ++j) {
+    int distance =
+        HammingDistance(descriptor, descriptors.ptr<uchar>(j), n_blocks);
+    if (distance < min_distance) {
+      second_min_distance = min_distance;
+      min_distance = distance;
+      min_idx = j;
+    } else if (distance < second_min_distance) {
+      second_min_distance = distance;
+    }
+  }
+  if (min_distance > max_hamming_distance) return false;
+
+  // Identical best and second-best distances of zero are accepted
+  if (second_min_distance > 0 &&
+      float(min_distance) >=
+          descriptor_distance_threshold * float(second_min_distance))
+    return false;
+  *idx = min_idx;
+  return true;
+}
+
+int TextureModality::HammingDistance(const uchar *descriptor1,
+                                     const uchar *descriptor2, int n_blocks) {
+#ifdef __AVX2__
+  // Population count using nibble lookup tables
+  const __m256i lookup = _mm256_setr_epi8(
+      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+      2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i sum = _mm256_setzero_si256();
+  for (int i = 0; i < n_blocks; ++i) {
+    __m256i x = _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(descriptor1) + i),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(descriptor2) + i));
+    __m256i low = _mm256_and_si256(x, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), low_mask);
+    __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                    _mm256_shuffle_epi8(lookup, high));
+    sum = _mm256_add_epi64(sum, _mm256_sad_epu8(count, _mm256_setzero_si256()));
+  }
+  return int(_mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+             _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3));
+#else
+  int distance = 0;
+  int n_words = n_blocks * kBinaryDescriptorBlockSize / sizeof(uint64_t);
+  for (int i = 0; i < n_words; ++i) {
+    uint64_t word1, word2;
+    std::memcpy(&word1, descriptor1 + i * sizeof(uint64_t), sizeof(uint64_t));
+    std::memcpy(&word2, descriptor2 + i * sizeof(uint64_t), sizeof(uint64_t));
+#if defined(__GNUC__) || defined(__clang__)
+    distance += __builtin_popcountll(word1 ^ word2);
+#else
+    distance += int(std::bitset<64>(word1 ^ word2).count());
+#endif
+  }
+  return distance;
+#endif
+}
+
 bool TextureModality::Reconstruct3DPoint(const cv::Point2f &center,
                                          Eigen::Vector3f *center_f_body) const {
   const cv::Mat &silhouette_image{
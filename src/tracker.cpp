@@ -218,6 +218,10 @@ void Tracker::set_visualization_time(int visualization_time) {
 
 void Tracker::set_viewer_time(int viewer_time) { viewer_time_ = viewer_time; }
 
+void Tracker::set_use_batched_optimization(bool use_batched_optimization) {
+  use_batched_optimization_ = use_batched_optimization;
+}
+
 bool Tracker::RunTrackerProcess(bool execute_detection, bool start_tracking,
                                 const std::set<std::string> *names_detecting,
                                 const std::set<std::string> *names_starting) {
@@ -407,7 +411,9 @@ bool Tracker::ExecuteDetectingStep(int iteration) {
   MoveBackPoses(names_detecting_);
   std::set<std::string> names_detected;
   if (!DetectPoses(names_detecting_, &names_detected)) return false;
-  if (!RefinePoses(names_detected)) return false;
+  std::map<std::string, std::vector<Transform3fA>> link2world_pose_hypotheses;
+  AddPoseHypotheses(names_detected, &link2world_pose_hypotheses);
+  if (!RefinePoses(names_detected, &link2world_pose_hypotheses)) return false;
   if (!CalculateConsistentPoses()) return false;
   if (start_tracking_after_detection_)
     names_starting_.insert(names_detected.begin(), names_detected.end());
@@ -420,6 +426,7 @@ bool Tracker::ExecuteDetectingStep(int iteration) {
 bool Tracker::ExecuteStartingStep(int iteration) {
   if (names_starting_.empty()) return true;
   if (!StartModalities(iteration)) return false;
+  ResetMotionModels(names_starting_);
   names_tracking_.insert(names_starting_.begin(), names_starting_.end());
   names_starting_.clear();
   AssambleInternallyUsedObjectPtrs();
@@ -427,6 +434,7 @@ bool Tracker::ExecuteStartingStep(int iteration) {
 }
 
 bool Tracker::ExecuteTrackingStep(int iteration) {
+  if (!PredictPoses()) return false;
   for (int corr_iteration = 0; corr_iteration < n_corr_iterations_;
        ++corr_iteration) {
     int corr_save_idx = iteration * n_corr_iterations_ + corr_iteration;
@@ -442,9 +450,11 @@ bool Tracker::ExecuteTrackingStep(int iteration) {
       if (!CalculateOptimization(iteration, corr_iteration, update_iteration))
         return false;
       if (!VisualizeOptimization(update_save_idx)) return false;
+      if (HaveOptimizersConverged()) break;
     }
   }
   if (!CalculateResults(iteration)) return false;
+  if (!UpdateMotionModels()) return false;
   return VisualizeResults(iteration);
 }
 
@@ -498,9 +508,26 @@ bool Tracker::DetectPoses(const std::set<std::string> &names,
   return true;
 }
 
-bool Tracker::RefinePoses(const std::set<std::string> &names) {
+void Tracker::AddPoseHypotheses(
+    const std::set<std::string> &names,
+    std::map<std::string, std::vector<Transform3fA>>
+        *link2world_pose_hypotheses) const {
+  for (auto &detector_ptr : detecting_detector_ptrs_)
+    detector_ptr->AddPoseHypotheses(names, link2world_pose_hypotheses);
+}
+
+bool Tracker::RefinePoses(
+    const std::set<std::string> &names,
+    const std::map<std::string, std::vector<Transform3fA>>
+        *link2world_pose_hypotheses) {
   for (auto &refiner_ptr : detecting_refiner_ptrs_) {
-    if (!refiner_ptr->RefinePoses(names)) return false;
+    if (link2world_pose_hypotheses && !link2world_pose_hypotheses->empty()) {
+      if (!refiner_ptr->RefinePoseHypotheses(names,
+                                             *link2world_pose_hypotheses))
+        return false;
+    } else if (!refiner_ptr->RefinePoses(names)) {
+      return false;
+    }
   }
   return true;
 }
@@ -529,6 +556,21 @@ bool Tracker::StartModalities(int iteration) {
   return true;
 }
 
+void Tracker::ResetMotionModels(const std::set<std::string> &names) {
+  for (auto &optimizer_ptr : optimizer_ptrs_) {
+    if (names.find(optimizer_ptr->name()) != names.end())
+      optimizer_ptr->ResetMotionModel();
+  }
+}
+
+bool Tracker::PredictPoses() {
+  double timestamp = CameraTimestamp();
+  for (auto &optimizer_ptr : tracking_optimizer_ptrs_) {
+    if (!optimizer_ptr->PredictPoses(timestamp)) return false;
+  }
+  return true;
+}
+
 bool Tracker::CalculateCorrespondences(int iteration, int corr_iteration) {
   for (auto &correspondence_renderer_ptr :
        tracking_correspondence_renderer_ptrs_) {
@@ -565,6 +607,9 @@ bool Tracker::CalculateGradientAndHessian(int iteration, int corr_iteration,
 
 bool Tracker::CalculateOptimization(int iteration, int corr_iteration,
                                     int update_iteration) {
+  if (use_batched_optimization_)
+    return CalculateBatchedOptimization(iteration, corr_iteration,
+                                        update_iteration);
   for (auto &optimizer_ptr : tracking_optimizer_ptrs_) {
     if (!optimizer_ptr->CalculateOptimization(iteration, corr_iteration,
                                               update_iteration))
@@ -573,6 +618,39 @@ bool Tracker::CalculateOptimization(int iteration, int corr_iteration,
   return true;
 }
 
+bool Tracker::CalculateBatchedOptimization(int iteration, int corr_iteration,
+                                           int update_iteration) {
+  // Gather batchable optimizers and optimize others individually
+  batched_optimizer_ptrs_.clear();
+  for (auto &optimizer_ptr : tracking_optimizer_ptrs_) {
+    if (optimizer_ptr->IsBatchable()) {
+      batched_optimizer_ptrs_.push_back(optimizer_ptr.get());
+    } else if (!optimizer_ptr->CalculateOptimization(
+                   iteration, corr_iteration, update_iteration)) {
+      return false;
+    }
+  }
+  if (batched_optimizer_ptrs_.empty()) return true;
+
+  // Solve all systems at once and scatter pose updates
+  Eigen::Matrix<float, 6, 6> a;
+  Eigen::Matrix<float, 6, 1> b;
+  batch_solver_.Resize(int(batched_optimizer_ptrs_.size()));
+  for (int i = 0; i < int(batched_optimizer_ptrs_.size()); ++i) {
+    if (!batched_optimizer_ptrs_[i]->CalculateSingleLinkSystem(&a, &b))
+      return false;
+    batch_solver_.SetSystem(i, a, b);
+  }
+  batch_solver_.Solve();
+  Eigen::Matrix<float, 6, 1> theta;
+  for (int i = 0; i < int(batched_optimizer_ptrs_.size()); ++i) {
+    if (batch_solver_.GetSolution(i, &theta) &&
+        !batched_optimizer_ptrs_[i]->ApplySingleLinkVariation(theta))
+      return false;
+  }
+  return true;
+}
+
 bool Tracker::VisualizeOptimization(int save_idx) {
   bool imshow_pose_update = false;
   for (auto &modality_ptr : tracking_modality_ptrs_) {
@@ -601,6 +679,14 @@ bool Tracker::CalculateResults(int iteration) {
   return true;
 }
 
+bool Tracker::UpdateMotionModels() {
+  double timestamp = CameraTimestamp();
+  for (auto &optimizer_ptr : tracking_optimizer_ptrs_) {
+    if (!optimizer_ptr->UpdateMotionModel(timestamp)) return false;
+  }
+  return true;
+}
+
 bool Tracker::VisualizeResults(int save_idx) {
   bool imshow_result = false;
   for (auto &modality_ptr : tracking_modality_ptrs_) {
@@ -717,6 +803,10 @@ int Tracker::visualization_time() const { return visualization_time_; }
 
 int Tracker::viewer_time() const { return viewer_time_; }
 
+bool Tracker::use_batched_optimization() const {
+  return use_batched_optimization_;
+}
+
 bool Tracker::set_up() const { return set_up_; }
 
 bool Tracker::LoadMetaData() {
@@ -734,6 +824,8 @@ bool Tracker::LoadMetaData() {
   ReadOptionalValueFromYaml(fs, "cycle_duration", &i_cycle_duration);
   ReadOptionalValueFromYaml(fs, "visualization_time", &visualization_time_);
   ReadOptionalValueFromYaml(fs, "viewer_time", &viewer_time_);
+  ReadOptionalValueFromYaml(fs, "use_batched_optimization",
+                            &use_batched_optimization_);
   cycle_duration_ = std::chrono::milliseconds{i_cycle_duration};
   fs.release();
   return true;
@@ -1004,4 +1096,18 @@ bool Tracker::AreAllObjectsSetUp() {
          AreObjectPtrsSetUp(&subscriber_ptrs_);
 }
 
+bool Tracker::HaveOptimizersConverged() const {
+  if (tracking_optimizer_ptrs_.empty()) return false;
+  for (auto &optimizer_ptr : tracking_optimizer_ptrs_)
+    if (!optimizer_ptr->converged()) return false;
+  return true;
+}
+
+double Tracker::CameraTimestamp() const {
+  double timestamp = 0.0;
+  for (auto &camera_ptr : camera_ptrs_)
+    timestamp = std::max(timestamp, camera_ptr->timestamp());
+  return timestamp;
+}
+
 }  // namespace m3t
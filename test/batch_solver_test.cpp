@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <gtest/gtest.h>
+#include <m3t/batch_solver.h>
+
+#include <vector>
+
+#include "common_test.h"
+
+class BatchSolverTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    for (int i = 0; i < n_systems_; ++i) {
+      Eigen::Matrix<float, 6, 6> random{Eigen::Matrix<float, 6, 6>::Random()};
+      a_.push_back(random * random.transpose() * 1000.0f +
+                   Eigen::Matrix<float, 6, 6>::Identity());
+      b_.push_back(Eigen::Matrix<float, 6, 1>::Random());
+    }
+  }
+
+  int n_systems_ = 19;
+  std::vector<Eigen::Matrix<float, 6, 6>> a_;
+  std::vector<Eigen::Matrix<float, 6, 1>> b_;
+};
+
+TEST_F(BatchSolverTest, Solve) {
+  m3t::BatchSolver batch_solver;
+  batch_solver.Resize(n_systems_);
+  ASSERT_EQ(batch_solver.n_systems(), n_systems_);
+  for (int i = 0; i < n_systems_; ++i) batch_solver.SetSystem(i, a_[i], b_[i]);
+  batch_solver.Solve();
+  for (int i = 0; i < n_systems_; ++i) {
+    Eigen::Matrix<float, 6, 1> theta;
+    ASSERT_TRUE(batch_solver.GetSolution(i, &theta));
+    Eigen::Matrix<float, 6, 1> expected{a_[i].llt().solve(b_[i])};
+    ASSERT_TRUE(theta.isApprox(expected, 1.0e-3f));
+  }
+}
+
+TEST_F(BatchSolverTest, NotPositiveDefinite) {
+  m3t::BatchSolver batch_solver;
+  batch_solver.Resize(n_systems_);
+  a_[3] = -a_[3];
+  for (int i = 0; i < n_systems_; ++i) batch_solver.SetSystem(i, a_[i], b_[i]);
+  batch_solver.Solve();
+  Eigen::Matrix<float, 6, 1> theta;
+  ASSERT_FALSE(batch_solver.GetSolution(3, &theta));
+  ASSERT_TRUE(batch_solver.GetSolution(4, &theta));
+  ASSERT_TRUE(theta.isApprox(a_[4].llt().solve(b_[4]), 1.0e-3f));
+
+  // Systems are solved again after reducing the number of systems
+  batch_solver.Resize(3);
+  for (int i = 0; i < 3; ++i) batch_solver.SetSystem(i, a_[i], b_[i]);
+  batch_solver.Solve();
+  for (int i = 0; i < 3; ++i) ASSERT_TRUE(batch_solver.GetSolution(i, &theta));
+}
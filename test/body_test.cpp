@@ -103,3 +103,78 @@ TEST_F(BodyTest, TestPose) {
   ASSERT_TRUE(body_ptr_->world2body_pose().matrix() ==
               pose_.inverse().matrix());
 }
+
+TEST_F(BodyTest, TestLODMeshes) {
+  body_ptr_->set_n_lod_levels(2);
+  body_ptr_->set_lod_reduction_factor(0.5f);
+  ASSERT_TRUE(body_ptr_->SetUp());
+  const auto &lod_meshes{body_ptr_->lod_meshes()};
+  ASSERT_FALSE(lod_meshes.empty());
+  size_t n_triangles = body_ptr_->mesh_indices().size();
+  float geometric_error = 0.0f;
+  for (const auto &lod_mesh : lod_meshes) {
+    ASSERT_LT(lod_mesh.mesh_indices.size(), n_triangles);
+    ASSERT_GE(lod_mesh.geometric_error, geometric_error);
+    for (const auto &triangle_indices : lod_mesh.mesh_indices) {
+      for (int index : triangle_indices)
+        ASSERT_LT(index, int(lod_mesh.vertices.size()));
+    }
+    n_triangles = lod_mesh.mesh_indices.size();
+    geometric_error = lod_mesh.geometric_error;
+  }
+  ASSERT_EQ(body_ptr_->SelectLODLevel(-1.0f), 0);
+  ASSERT_EQ(body_ptr_->SelectLODLevel(std::numeric_limits<float>::max()),
+            int(lod_meshes.size()));
+}
+
+TEST_F(BodyTest, TestMeshCache) {
+  std::filesystem::create_directory(temp_directory);
+  std::filesystem::path geometry_path{temp_directory / "triangle.obj"};
+  std::filesystem::copy_file(
+      geometry_path_, geometry_path,
+      std::filesystem::copy_options::overwrite_existing);
+  std::filesystem::remove(geometry_path.string() + ".m3tmesh");
+
+  body_ptr_->set_use_mesh_cache(false);
+  ASSERT_TRUE(body_ptr_->SetUp());
+  m3t::Body body{name_, geometry_path, geometry_unit_in_meter_,
+                 geometry_counterclockwise_, geometry_enable_culling_,
+                 geometry2body_pose_};
+  ASSERT_FALSE(body.use_mesh_cache());
+  body.set_use_mesh_cache(true);
+  ASSERT_TRUE(body.SetUp());
+  ASSERT_TRUE(std::filesystem::exists(body.mesh_cache_path()));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(body.SetUp());
+    ASSERT_TRUE(body.vertices() == body_ptr_->vertices());
+    ASSERT_TRUE(body.mesh_indices() == body_ptr_->mesh_indices());
+    ASSERT_EQ(body.maximum_body_diameter(), maximum_body_diameter_);
+  }
+
+  // Scale and winding order are applied after reading the cache
+  body.set_geometry_unit_in_meter(2.0f);
+  body.set_geometry_counterclockwise(false);
+  ASSERT_TRUE(body.SetUp());
+  ASSERT_TRUE(body.vertices()[0].isApprox(2.0f * body_ptr_->vertices()[0]));
+  ASSERT_EQ(body.mesh_indices()[0][0], body_ptr_->mesh_indices()[0][2]);
+  body.set_geometry_unit_in_meter(geometry_unit_in_meter_);
+  body.set_geometry_counterclockwise(geometry_counterclockwise_);
+
+  // Truncated caches are ignored and rewritten
+  std::filesystem::resize_file(
+      body.mesh_cache_path(),
+      std::filesystem::file_size(body.mesh_cache_path()) - 4);
+  ASSERT_TRUE(body.SetUp());
+  ASSERT_TRUE(body.vertices() == body_ptr_->vertices());
+  ASSERT_TRUE(body.mesh_indices() == body_ptr_->mesh_indices());
+
+  // Caches are stored in mesh cache directory if it is set
+  std::filesystem::path mesh_cache_directory{temp_directory / "mesh_cache"};
+  std::filesystem::remove_all(mesh_cache_directory);
+  body.set_mesh_cache_directory(mesh_cache_directory);
+  ASSERT_TRUE(body.SetUp());
+  ASSERT_EQ(body.mesh_cache_path().parent_path(), mesh_cache_directory);
+  ASSERT_TRUE(std::filesystem::exists(body.mesh_cache_path()));
+  ASSERT_TRUE(body.SetUp());
+  ASSERT_TRUE(body.vertices() == body_ptr_->vertices());
+}
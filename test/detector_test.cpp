@@ -6,6 +6,7 @@
 #include <m3t/camera.h>
 #include <m3t/manual_detector.h>
 #include <m3t/static_detector.h>
+#include <m3t/template_detector.h>
 
 #include "common_test.h"
 
@@ -148,3 +149,96 @@ TEST_F(ManualDetectorTest, TestWithoutSetUpCamera) {
   detector_ptr_->set_color_camera_ptr(ColorCameraPtrNoSetUp());
   ASSERT_FALSE(detector_ptr_->SetUp());
 }
+
+class TemplateDetectorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    body_ptr_ = TriangleBodyPtr();
+    link_ptr_ = std::make_shared<m3t::Link>("triangle_link", body_ptr_);
+    link_ptr_->SetUp();
+    optimizer_ptr_ =
+        std::make_shared<m3t::Optimizer>("triangle_optimizer", link_ptr_);
+    optimizer_ptr_->SetUp();
+    camera_ptr_ = ColorCameraPtr();
+    region_model_ptr_ = TriangleRegionModelPtr();
+    names_.insert(optimizer_ptr_->name());
+    detector_ptr_ = std::make_shared<m3t::TemplateDetector>(
+        name_, optimizer_ptr_, camera_ptr_, region_model_ptr_);
+  }
+
+  std::shared_ptr<m3t::TemplateDetector> detector_ptr_;
+  std::string name_{"detector"};
+  std::shared_ptr<m3t::Body> body_ptr_;
+  std::shared_ptr<m3t::Link> link_ptr_;
+  std::shared_ptr<m3t::Optimizer> optimizer_ptr_;
+  std::shared_ptr<m3t::LoaderColorCamera> camera_ptr_;
+  std::shared_ptr<m3t::RegionModel> region_model_ptr_;
+  std::set<std::string> names_{};
+};
+
+TEST_F(TemplateDetectorTest, SetUpFromData) {
+  ASSERT_TRUE(detector_ptr_->SetUp());
+  ASSERT_TRUE(detector_ptr_->set_up());
+  ASSERT_GT(detector_ptr_->n_templates(), 0);
+}
+
+TEST_F(TemplateDetectorTest, TestWithoutSetUp) {
+  ASSERT_FALSE(detector_ptr_->DetectPoses(names_));
+}
+
+TEST_F(TemplateDetectorTest, TestWithoutSetUpRegionModel) {
+  detector_ptr_->set_region_model_ptr(TriangleRegionModelPtrNoSetUp());
+  ASSERT_FALSE(detector_ptr_->SetUp());
+}
+
+TEST_F(TemplateDetectorTest, DetectPoseHypotheses) {
+  // Body is initialized with the ground-truth pose of the test image
+  m3t::Transform3fA body2world_pose{body_ptr_->body2world_pose()};
+  float distance{(camera_ptr_->world2camera_pose() * body2world_pose)
+                     .translation()
+                     .norm()};
+  detector_ptr_->set_distances({distance});
+  detector_ptr_->set_min_similarity(0.0f);
+  ASSERT_TRUE(detector_ptr_->SetUp());
+  std::set<std::string> detected_names;
+  ASSERT_TRUE(detector_ptr_->DetectPoses(names_, &detected_names));
+  ASSERT_EQ(detected_names.count(optimizer_ptr_->name()), 1);
+
+  // Hypotheses are sorted and the best pose is set
+  const auto &similarities{detector_ptr_->similarities()};
+  ASSERT_FALSE(similarities.empty());
+  ASSERT_LE(int(similarities.size()), detector_ptr_->n_hypotheses());
+  ASSERT_TRUE(std::is_sorted(similarities.rbegin(), similarities.rend()));
+  ASSERT_LE(similarities.front(), 1.0f);
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      detector_ptr_->link2world_pose_hypotheses().front().matrix()));
+
+  // Best hypothesis is close to the ground-truth pose
+  const auto &best_pose{detector_ptr_->link2world_pose_hypotheses().front()};
+  ASSERT_LT(
+      (best_pose.translation() - body2world_pose.translation()).norm(), 0.05f);
+  ASSERT_LT(Eigen::AngleAxisf{body2world_pose.rotation().transpose() *
+                              best_pose.rotation()}
+                .angle(),
+            0.6f);
+
+  // Hypotheses are provided for optimizers that are considered
+  std::map<std::string, std::vector<m3t::Transform3fA>> hypotheses;
+  detector_ptr_->AddPoseHypotheses({}, &hypotheses);
+  ASSERT_TRUE(hypotheses.empty());
+  detector_ptr_->AddPoseHypotheses(names_, &hypotheses);
+  ASSERT_EQ(hypotheses[optimizer_ptr_->name()].size(), similarities.size());
+}
+
+TEST_F(TemplateDetectorTest, TestInvalidParameters) {
+  detector_ptr_->set_n_pyramid_levels(0);
+  ASSERT_FALSE(detector_ptr_->SetUp());
+  detector_ptr_->set_n_pyramid_levels(3);
+  detector_ptr_->set_n_rolls(0);
+  ASSERT_FALSE(detector_ptr_->SetUp());
+  detector_ptr_->set_n_rolls(12);
+  detector_ptr_->set_distances({});
+  ASSERT_FALSE(detector_ptr_->SetUp());
+  detector_ptr_->set_distances({0.5f});
+  ASSERT_TRUE(detector_ptr_->SetUp());
+}
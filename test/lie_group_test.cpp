@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <gtest/gtest.h>
+#include <m3t/lie_group.h>
+
+#include <unsupported/Eigen/MatrixFunctions>
+
+#include "common_test.h"
+
+class LieGroupTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    pose_ = m3t::Transform3fA{Eigen::Translation3f{0.1f, -0.2f, 0.3f}};
+    pose_.rotate(Eigen::AngleAxisf{0.7f, Eigen::Vector3f{1.0f, 2.0f, -1.0f}
+                                             .normalized()});
+  }
+
+  std::vector<Eigen::Vector3f> rotation_vectors_{
+      Eigen::Vector3f{0.0f, 0.0f, 0.0f},
+      Eigen::Vector3f{1.0e-5f, -2.0e-5f, 3.0e-5f},
+      Eigen::Vector3f{0.01f, -0.02f, 0.03f},
+      Eigen::Vector3f{0.5f, -0.3f, 0.2f},
+      Eigen::Vector3f{-1.0f, 2.0f, 0.5f},
+      Eigen::Vector3f{0.0f, 0.0f, 3.14f}};
+  m3t::Transform3fA pose_;
+};
+
+TEST_F(LieGroupTest, ExpSO3) {
+  for (const auto &rotation_vector : rotation_vectors_) {
+    Eigen::Matrix3f expected{
+        m3t::Vector2Skewsymmetric(rotation_vector).exp()};
+    ASSERT_TRUE(m3t::ExpSO3(rotation_vector).isApprox(expected, 1.0e-5f));
+  }
+}
+
+TEST_F(LieGroupTest, LogSO3) {
+  for (const auto &rotation_vector : rotation_vectors_) {
+    Eigen::Vector3f result{m3t::LogSO3(m3t::ExpSO3(rotation_vector))};
+    ASSERT_LT((result - rotation_vector).norm(), 1.0e-5f);
+  }
+}
+
+TEST_F(LieGroupTest, InverseLeftJacobianSO3) {
+  for (const auto &rotation_vector : rotation_vectors_) {
+    float angle = rotation_vector.norm();
+    Eigen::Vector3f axis{Eigen::Vector3f::UnitX()};
+    if (angle > 0.0f) axis = rotation_vector / angle;
+    float angle_half = 0.5f * angle;
+    float x_cot_x =
+        angle_half > 0.0f ? angle_half / std::tan(angle_half) : 1.0f;
+    Eigen::Matrix3f expected{
+        x_cot_x * Eigen::Matrix3f::Identity() -
+        angle_half * m3t::Vector2Skewsymmetric(axis) +
+        (1.0f - x_cot_x) * axis * axis.transpose()};
+    ASSERT_TRUE(m3t::InverseLeftJacobianSO3(rotation_vector)
+                    .isApprox(expected, 1.0e-5f));
+  }
+}
+
+TEST_F(LieGroupTest, ExpLogSE3) {
+  for (const auto &rotation_vector : rotation_vectors_) {
+    Eigen::Matrix<float, 6, 1> twist;
+    twist << rotation_vector, 0.2f, -0.1f, 0.4f;
+    Eigen::Matrix4f twist_matrix{Eigen::Matrix4f::Zero()};
+    twist_matrix.topLeftCorner<3, 3>() =
+        m3t::Vector2Skewsymmetric(rotation_vector);
+    twist_matrix.topRightCorner<3, 1>() = twist.tail<3>();
+    Eigen::Matrix4f expected{twist_matrix.exp()};
+    m3t::Transform3fA pose{m3t::ExpSE3(twist)};
+    ASSERT_TRUE(pose.matrix().isApprox(expected, 1.0e-5f));
+    ASSERT_LT((m3t::LogSE3(pose) - twist).norm(), 1.0e-4f);
+  }
+}
+
+TEST_F(LieGroupTest, ApplyAdjointSE3) {
+  Eigen::Matrix<float, 6, 6> adjoint{m3t::AdjointSE3(pose_)};
+  Eigen::Matrix3f rotation{adjoint.topLeftCorner<3, 3>()};
+  Eigen::Matrix3f zero{adjoint.topRightCorner<3, 3>()};
+  ASSERT_TRUE(rotation.isApprox(pose_.rotation()));
+  ASSERT_TRUE(zero.isZero());
+
+  Eigen::Matrix<float, 6, Eigen::Dynamic> variations{
+      Eigen::Matrix<float, 6, Eigen::Dynamic>::Random(6, 10)};
+  Eigen::Matrix<float, 6, Eigen::Dynamic> result(6, 10);
+  m3t::ApplyAdjointSE3(pose_, variations, result);
+  ASSERT_TRUE(result.isApprox(adjoint * variations, 1.0e-5f));
+}
@@ -6,6 +6,7 @@
 #include <m3t/camera.h>
 #include <m3t/depth_modality.h>
 #include <m3t/depth_model.h>
+#include <m3t/feature_cache.h>
 #include <m3t/region_modality.h>
 #include <m3t/region_model.h>
 #include <m3t/texture_modality.h>
@@ -677,6 +678,12 @@ TEST_F(TextureModalityTest, TestWithoutSetUpCamera) {
   ASSERT_FALSE(modality_ptr_->SetUp());
 }
 
+TEST_F(TextureModalityTest, TestWithoutSetUpFeatureCache) {
+  modality_ptr_->UseFeatureCache(
+      std::make_shared<m3t::FeatureCache>("feature_cache", color_camera_ptr_));
+  ASSERT_FALSE(modality_ptr_->SetUp());
+}
+
 TEST_F(TextureModalityTest, Reconstruct3DPoints) {
   std::filesystem::create_directory(temp_directory);
   silhouette_renderer_ptr_->StartRendering();
@@ -753,6 +760,64 @@ TEST_F(TextureModalityTest, CalculateCorrespondences) {
       0, 0));
 }
 
+TEST_F(TextureModalityTest, CalculateCorrespondencesSilhouetteMask) {
+  silhouette_renderer_ptr_->StartRendering();
+  modality_ptr_->set_use_silhouette_mask(true);
+  ASSERT_TRUE(modality_ptr_->SetUp());
+  ASSERT_TRUE(modality_ptr_->use_silhouette_mask());
+  ASSERT_TRUE(modality_ptr_->StartModality(0, 0));
+  ASSERT_TRUE(color_camera_ptr_->UpdateImage(false));
+  ASSERT_TRUE(modality_ptr_->CalculateCorrespondences(0, 0));
+  ASSERT_TRUE(modality_ptr_->CalculateGradientAndHessian(0, 0, 0));
+}
+
+TEST_F(TextureModalityTest, CalculateCorrespondencesKLTPropagation) {
+  // Save original, shifted, and random images for a separate camera
+  const cv::Mat &image{color_camera_ptr_->image()};
+  cv::Mat shifted_image;
+  cv::warpAffine(image, shifted_image,
+                 cv::Matx23f{1.0f, 0.0f, 2.0f, 0.0f, 1.0f, 1.0f},
+                 image.size(), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+  cv::Mat random_image{image.size(), image.type()};
+  cv::RNG{42}.fill(random_image, cv::RNG::UNIFORM, 0, 256);
+  std::string image_name_pre{"texture_modality_klt_image_"};
+  cv::imwrite((temp_directory / (image_name_pre + "0.png")).string(), image);
+  cv::imwrite((temp_directory / (image_name_pre + "1.png")).string(),
+              shifted_image);
+  cv::imwrite((temp_directory / (image_name_pre + "2.png")).string(),
+              random_image);
+  auto camera_ptr{std::make_shared<m3t::LoaderColorCamera>(
+      "klt_color_camera", temp_directory, color_camera_ptr_->intrinsics(),
+      image_name_pre)};
+  camera_ptr->set_camera2world_pose(color_camera_ptr_->camera2world_pose());
+  ASSERT_TRUE(camera_ptr->SetUp());
+
+  silhouette_renderer_ptr_->StartRendering();
+  modality_ptr_->set_color_camera_ptr(camera_ptr);
+  modality_ptr_->set_use_klt_propagation(true);
+  modality_ptr_->set_klt_min_n_points(1);
+  ASSERT_TRUE(modality_ptr_->SetUp());
+  ASSERT_TRUE(modality_ptr_->use_klt_propagation());
+  ASSERT_TRUE(modality_ptr_->StartModality(0, 0));
+  ASSERT_TRUE(modality_ptr_->CalculateCorrespondences(0, 0));
+  ASSERT_FALSE(modality_ptr_->data_points_propagated());
+  ASSERT_GT(modality_ptr_->n_data_points(), 0);
+  ASSERT_TRUE(modality_ptr_->CalculateResults(0));
+
+  // Correspondences are propagated to the shifted image
+  ASSERT_TRUE(camera_ptr->UpdateImage(false));
+  ASSERT_TRUE(modality_ptr_->CalculateCorrespondences(1, 0));
+  ASSERT_TRUE(modality_ptr_->data_points_propagated());
+  ASSERT_GT(modality_ptr_->n_data_points(), 0);
+  ASSERT_TRUE(modality_ptr_->CalculateGradientAndHessian(1, 0, 0));
+  ASSERT_TRUE(modality_ptr_->CalculateResults(1));
+
+  // Propagation to an unrelated image is rejected
+  ASSERT_TRUE(camera_ptr->UpdateImage(false));
+  ASSERT_TRUE(modality_ptr_->CalculateCorrespondences(2, 0));
+  ASSERT_FALSE(modality_ptr_->data_points_propagated());
+}
+
 TEST_F(TextureModalityTest, CalculateGradientAndHessian) {
   silhouette_renderer_ptr_->StartRendering();
   ASSERT_TRUE(modality_ptr_->SetUp());
@@ -773,3 +838,69 @@ TEST_F(TextureModalityTest, CalculateGradientAndHessian) {
                                     "texture_modality_gradient.txt",
                                     modality_ptr_->gradient(), 1.0e-3f));
 }
+
+TEST_F(TextureModalityTest, CalculateCorrespondencesFeatureCache) {
+  auto feature_cache_ptr{
+      std::make_shared<m3t::FeatureCache>("feature_cache", color_camera_ptr_)};
+  ASSERT_TRUE(feature_cache_ptr->SetUp());
+  silhouette_renderer_ptr_->StartRendering();
+  modality_ptr_->UseFeatureCache(feature_cache_ptr);
+  ASSERT_TRUE(modality_ptr_->SetUp());
+  ASSERT_TRUE(modality_ptr_->use_feature_cache());
+  ASSERT_TRUE(modality_ptr_->StartModality(0, 0));
+  ASSERT_TRUE(color_camera_ptr_->UpdateImage(false));
+  ASSERT_TRUE(modality_ptr_->CalculateCorrespondences(0, 0));
+  ASSERT_FALSE(feature_cache_ptr->gray_image().empty());
+  ASSERT_TRUE(modality_ptr_->CalculateGradientAndHessian(0, 0, 0));
+  modality_ptr_->DoNotUseFeatureCache();
+  ASSERT_FALSE(modality_ptr_->set_up());
+  ASSERT_TRUE(modality_ptr_->SetUp());
+}
+
+TEST_F(TextureModalityTest, HammingDistance) {
+  constexpr int kBlockSize = m3t::TextureModality::kBinaryDescriptorBlockSize;
+  cv::RNG rng{42};
+  for (int n_bytes : {1, 17, 32, 48, 61, 64, 100}) {
+    // Descriptors are zero-padded to full blocks
+    int n_blocks = (n_bytes + kBlockSize - 1) / kBlockSize;
+    cv::Mat descriptors{cv::Mat::zeros(2, n_blocks * kBlockSize, CV_8U)};
+    rng.fill(descriptors.colRange(0, n_bytes), cv::RNG::UNIFORM, 0, 256);
+    int expected_distance = 0;
+    for (int i = 0; i < n_bytes; ++i)
+      expected_distance += int(std::bitset<8>(descriptors.at<uchar>(0, i) ^
+                                              descriptors.at<uchar>(1, i))
+                                   .count());
+    ASSERT_EQ(m3t::TextureModality::HammingDistance(
+                  descriptors.ptr<uchar>(0), descriptors.ptr<uchar>(1),
+                  n_blocks),
+              expected_distance);
+  }
+}
+
+TEST_F(TextureModalityTest, MatchBinaryDescriptor) {
+  constexpr int kBlockSize = m3t::TextureModality::kBinaryDescriptorBlockSize;
+  cv::Mat descriptor{cv::Mat::zeros(1, kBlockSize, CV_8U)};
+  cv::Mat descriptors{cv::Mat::zeros(3, kBlockSize, CV_8U)};
+  descriptors.row(0).colRange(0, 4).setTo(cv::Scalar{255});  // distance 32
+  descriptors.row(1).colRange(0, 1).setTo(cv::Scalar{15});   // distance 4
+  descriptors.row(2).colRange(0, 2).setTo(cv::Scalar{255});  // distance 16
+  int idx = -1;
+
+  // Best match is accepted if distances are below thresholds
+  ASSERT_TRUE(m3t::TextureModality::MatchBinaryDescriptor(
+      descriptor.ptr<uchar>(), descriptors, 1, 64, 0.7f, &idx));
+  ASSERT_EQ(idx, 1);
+
+  // Matches are rejected based on the maximum distance and ratio test
+  ASSERT_FALSE(m3t::TextureModality::MatchBinaryDescriptor(
+      descriptor.ptr<uchar>(), descriptors, 1, 3, 0.7f, &idx));
+  ASSERT_FALSE(m3t::TextureModality::MatchBinaryDescriptor(
+      descriptor.ptr<uchar>(), descriptors, 1, 64, 0.25f, &idx));
+
+  // Identical descriptors with a distance of zero are accepted
+  descriptors.row(1).setTo(cv::Scalar{0});
+  descriptors.row(2).setTo(cv::Scalar{0});
+  ASSERT_TRUE(m3t::TextureModality::MatchBinaryDescriptor(
+      descriptor.ptr<uchar>(), descriptors, 1, 64, 0.7f, &idx));
+  ASSERT_EQ(idx, 1);
+}
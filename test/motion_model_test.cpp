@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+#include <gtest/gtest.h>
+#include <m3t/motion_model.h>
+
+#include "common_test.h"
+
+class MotionModelTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    velocity_ << 0.3f, -0.2f, 0.5f, 0.1f, 0.05f, -0.2f;
+    initial_pose_ = m3t::Transform3fA{Eigen::Translation3f{0.1f, 0.0f, 0.5f}};
+    initial_pose_.rotate(Eigen::AngleAxisf{0.4f, Eigen::Vector3f::UnitY()});
+  }
+
+  m3t::Transform3fA PoseAt(double timestamp) const {
+    return initial_pose_ * m3t::ExpSE3(velocity_ * float(timestamp));
+  }
+
+  Eigen::Matrix<float, 6, 1> velocity_;
+  m3t::Transform3fA initial_pose_;
+};
+
+TEST_F(MotionModelTest, ConstantVelocity) {
+  m3t::MotionModel motion_model;
+  m3t::Transform3fA pose;
+  motion_model.Update(PoseAt(0.0), 0.0);
+  ASSERT_FALSE(motion_model.Predict(0.033, &pose));
+
+  // Variable intervals between frames
+  motion_model.Update(PoseAt(0.033), 0.033);
+  ASSERT_TRUE(motion_model.Predict(0.1, &pose));
+  ASSERT_TRUE(pose.matrix().isApprox(PoseAt(0.1).matrix(), 1.0e-4f));
+  ASSERT_TRUE(motion_model.velocity().isApprox(velocity_, 1.0e-3f));
+
+  motion_model.Reset();
+  ASSERT_FALSE(motion_model.velocity_valid());
+  ASSERT_FALSE(motion_model.Predict(0.1, &pose));
+}
+
+TEST_F(MotionModelTest, WithoutTimestamps) {
+  m3t::MotionModel motion_model;
+  m3t::Transform3fA pose;
+  motion_model.Update(PoseAt(0.0), 0.0);
+  motion_model.Update(PoseAt(0.1), 0.0);
+  ASSERT_TRUE(motion_model.Predict(0.0, &pose));
+  ASSERT_TRUE(pose.matrix().isApprox(PoseAt(0.2).matrix(), 1.0e-4f));
+}
+
+TEST_F(MotionModelTest, KalmanFilter) {
+  m3t::MotionModel motion_model;
+  motion_model.set_use_kalman_filter(true);
+  motion_model.set_process_noise(1.0f);
+  motion_model.set_measurement_noise(1.0f);
+
+  // Noise-free motion keeps the velocity
+  for (int i = 0; i < 5; ++i) motion_model.Update(PoseAt(i * 0.1), i * 0.1);
+  ASSERT_TRUE(motion_model.velocity().isApprox(velocity_, 1.0e-3f));
+
+  // Single outlier only partially changes the velocity
+  motion_model.Update(PoseAt(0.6), 0.5);
+  float filtered_error = (motion_model.velocity() - velocity_).norm();
+  float measured_error = velocity_.norm();
+  ASSERT_GT(filtered_error, 0.0f);
+  ASSERT_LT(filtered_error, 0.5f * measured_error);
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
+
+// Allocation functions are replaced for the entire executable. This test is
+// therefore built as a separate executable gtest_allocation_run.
+
+#include <gtest/gtest.h>
+#include <m3t/body.h>
+#include <m3t/camera.h>
+#include <m3t/depth_modality.h>
+#include <m3t/optimizer.h>
+#include <m3t/region_modality.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+
+#include "common_test.h"
+
+#ifdef __GLIBC__
+// Count heap allocations by interposing allocation functions of glibc
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void *__libc_memalign(size_t alignment, size_t size);
+static std::atomic<bool> count_allocations{false};
+static std::atomic<int> n_allocations{0};
+
+static void CountAllocation() {
+  if (count_allocations.load(std::memory_order_relaxed))
+    n_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void *malloc(size_t size) {
+  CountAllocation();
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+  CountAllocation();
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+  CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+extern "C" void *memalign(size_t alignment, size_t size) {
+  CountAllocation();
+  return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  CountAllocation();
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void *result = __libc_memalign(alignment, size);
+  if (!result) return ENOMEM;
+  *ptr = result;
+  return 0;
+}
+
+class OptimizerAllocationTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    auto body_ptr{TriangleBodyPtr()};
+    auto region_modality_ptr{std::make_shared<m3t::RegionModality>(
+        "triangle_region_modality", body_ptr, ColorCameraPtr(),
+        TriangleRegionModelPtr())};
+    region_modality_ptr->SetUp();
+    region_modality_ptr->StartModality(0, 0);
+    region_modality_ptr->CalculateCorrespondences(0, 0);
+    region_modality_ptr->CalculateGradientAndHessian(0, 0, 0);
+    auto depth_modality_ptr{std::make_shared<m3t::DepthModality>(
+        "triangle_depth_modality", body_ptr, DepthCameraPtr(),
+        TriangleDepthModelPtr())};
+    depth_modality_ptr->SetUp();
+    depth_modality_ptr->CalculateCorrespondences(0, 0);
+    depth_modality_ptr->CalculateGradientAndHessian(0, 0, 0);
+    link_ptr_ = std::make_shared<m3t::Link>("link", body_ptr);
+    link_ptr_->AddModality(region_modality_ptr);
+    link_ptr_->AddModality(depth_modality_ptr);
+    link_ptr_->SetUp();
+
+    optimizer_ptr_ = std::make_shared<m3t::Optimizer>(
+        "optimizer", link_ptr_, 5000.0f, 500000.0f);
+  }
+
+  std::shared_ptr<m3t::Optimizer> optimizer_ptr_;
+  std::shared_ptr<m3t::Link> link_ptr_;
+};
+
+TEST_F(OptimizerAllocationTest, AllocationFree) {
+  // Create branched structure with a constraint and a soft constraint
+  auto child_link_ptr{std::make_shared<m3t::Link>("child_link")};
+  auto grandchild_link_ptr{std::make_shared<m3t::Link>("grandchild_link")};
+  auto second_child_link_ptr{std::make_shared<m3t::Link>("second_child_link")};
+  child_link_ptr->set_joint2parent_pose(
+      m3t::Transform3fA{Eigen::Translation3f{0.01f, 0.0f, 0.0f}});
+  grandchild_link_ptr->set_joint2parent_pose(
+      m3t::Transform3fA{Eigen::Translation3f{0.01f, 0.0f, 0.0f}});
+  ASSERT_TRUE(child_link_ptr->AddChildLink(grandchild_link_ptr));
+  ASSERT_TRUE(link_ptr_->AddChildLink(child_link_ptr));
+  ASSERT_TRUE(link_ptr_->AddChildLink(second_child_link_ptr));
+  for (auto &link_ptr : {link_ptr_, child_link_ptr, grandchild_link_ptr,
+                         second_child_link_ptr})
+    ASSERT_TRUE(link_ptr->SetUp());
+  auto constraint_ptr{std::make_shared<m3t::Constraint>(
+      "constraint", link_ptr_, grandchild_link_ptr,
+      m3t::Transform3fA{Eigen::Translation3f{0.02f, 0.0f, 0.0f}},
+      m3t::Transform3fA::Identity(),
+      std::array<bool, 6>{false, false, true, true, true, false})};
+  ASSERT_TRUE(constraint_ptr->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->AddConstraint(constraint_ptr));
+  auto soft_constraint_ptr{std::make_shared<m3t::SoftConstraint>(
+      "soft_constraint", child_link_ptr, second_child_link_ptr,
+      m3t::Transform3fA::Identity(), m3t::Transform3fA::Identity(),
+      std::array<bool, 6>{true, true, false, true, true, true}, 0.0f, 0.0f)};
+  ASSERT_TRUE(soft_constraint_ptr->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->AddSoftConstraint(soft_constraint_ptr));
+
+  // Check that iterations after the first do not allocate memory
+  for (bool use_levenberg_marquardt : {false, true}) {
+    for (bool use_tree_solver : {true, false}) {
+      optimizer_ptr_->set_use_levenberg_marquardt(use_levenberg_marquardt);
+      optimizer_ptr_->set_use_tree_solver(use_tree_solver);
+      ASSERT_TRUE(optimizer_ptr_->SetUp());
+      ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+      n_allocations = 0;
+      count_allocations = true;
+      bool success = true;
+      for (int i = 1; i <= 10; ++i)
+        success &= optimizer_ptr_->CalculateOptimization(0, 0, i);
+      count_allocations = false;
+      ASSERT_TRUE(success);
+      ASSERT_EQ(n_allocations.load(), 0);
+    }
+  }
+}
+#endif
@@ -2,6 +2,7 @@
 // Copyright (c) 2023 Manuel Stoiber, German Aerospace Center (DLR)
 
 #include <gtest/gtest.h>
+#include <m3t/batch_solver.h>
 #include <m3t/body.h>
 #include <m3t/camera.h>
 #include <m3t/depth_modality.h>
@@ -103,3 +104,208 @@ TEST_F(OptimizerTest, Optimize) {
   ASSERT_TRUE(CompareToLoadedMatrix(optimizer_test_directory,
                                     "triangle_pose.txt", pose_matrix, 1.0e-5f));
 }
+
+TEST_F(OptimizerTest, TreeSolver) {
+  // Create chain of child links with a constraint that closes the loop
+  std::vector<std::shared_ptr<m3t::Link>> link_ptrs{link_ptr_};
+  for (int i = 0; i < 3; ++i) {
+    auto child_link_ptr{
+        std::make_shared<m3t::Link>("child_link" + std::to_string(i))};
+    child_link_ptr->set_joint2parent_pose(
+        m3t::Transform3fA{Eigen::Translation3f{0.01f, 0.0f, 0.0f}});
+    link_ptrs.back()->AddChildLink(child_link_ptr);
+    link_ptrs.push_back(child_link_ptr);
+  }
+  for (auto &link_ptr : link_ptrs) ASSERT_TRUE(link_ptr->SetUp());
+  auto constraint_ptr{std::make_shared<m3t::Constraint>(
+      "constraint", link_ptr_, link_ptrs.back(),
+      m3t::Transform3fA{Eigen::Translation3f{0.02f, 0.0f, 0.0f}},
+      m3t::Transform3fA::Identity(),
+      std::array<bool, 6>{false, false, true, true, true, false})};
+  ASSERT_TRUE(constraint_ptr->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->AddConstraint(constraint_ptr));
+
+  // Optimize with tree solver
+  auto body2world_pose{link_ptr_->body_ptr()->body2world_pose()};
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->use_tree_solver());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  std::vector<m3t::Transform3fA> link2world_poses;
+  for (auto &link_ptr : link_ptrs)
+    link2world_poses.push_back(link_ptr->link2world_pose());
+
+  // Reset poses and compare to dense solver
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+  for (auto &link_ptr : link_ptrs) link_ptr->ResetJointPoses();
+  optimizer_ptr_->set_use_tree_solver(false);
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  for (size_t i = 0; i < link_ptrs.size(); ++i) {
+    ASSERT_TRUE(link_ptrs[i]->link2world_pose().matrix().isApprox(
+        link2world_poses[i].matrix(), 1.0e-4f));
+  }
+}
+
+TEST_F(OptimizerTest, SparseJacobian) {
+  // Create branched structure with depth-first order root, child, grandchild,
+  // and second child
+  auto child_link_ptr{std::make_shared<m3t::Link>("child_link")};
+  auto grandchild_link_ptr{std::make_shared<m3t::Link>("grandchild_link")};
+  auto second_child_link_ptr{std::make_shared<m3t::Link>("second_child_link")};
+  second_child_link_ptr->set_joint2parent_pose(
+      m3t::Transform3fA{Eigen::Translation3f{0.01f, 0.0f, 0.0f}});
+  ASSERT_TRUE(child_link_ptr->AddChildLink(grandchild_link_ptr));
+  ASSERT_TRUE(link_ptr_->AddChildLink(child_link_ptr));
+  ASSERT_TRUE(link_ptr_->AddChildLink(second_child_link_ptr));
+  for (auto &link_ptr : {link_ptr_, child_link_ptr, grandchild_link_ptr,
+                         second_child_link_ptr})
+    ASSERT_TRUE(link_ptr->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+
+  // Consecutive free directions of ancestors are merged into a single block
+  const auto &grandchild_blocks{grandchild_link_ptr->jacobian_blocks()};
+  ASSERT_EQ(grandchild_blocks.size(), 1u);
+  ASSERT_EQ(grandchild_blocks[0].first_jacobian_index, 0);
+  ASSERT_EQ(grandchild_blocks[0].n_columns, 18);
+  ASSERT_EQ(grandchild_link_ptr->jacobian().cols(), 18);
+
+  // Free directions of other branches are not stored
+  const auto &second_child_blocks{second_child_link_ptr->jacobian_blocks()};
+  ASSERT_EQ(second_child_blocks.size(), 2u);
+  ASSERT_EQ(second_child_blocks[0].first_jacobian_index, 0);
+  ASSERT_EQ(second_child_blocks[1].first_jacobian_index, 18);
+  ASSERT_EQ(second_child_blocks[1].first_column, 6);
+  const auto &jacobian{second_child_link_ptr->jacobian()};
+  ASSERT_EQ(jacobian.cols(), 12);
+  ASSERT_TRUE(jacobian.leftCols(6).isApprox(
+      second_child_link_ptr->parent_adjoint() * link_ptr_->jacobian()));
+  ASSERT_TRUE(
+      jacobian.rightCols(6).isApprox(second_child_link_ptr->joint_jacobian()));
+}
+
+TEST_F(OptimizerTest, SingleLink) {
+  // Optimize single link with six degrees of freedom
+  auto body2world_pose{link_ptr_->body_ptr()->body2world_pose()};
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  auto link2world_pose{link_ptr_->link2world_pose()};
+
+  // Reset pose and compare to solver with an additional fixed child link
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+  auto child_link_ptr{std::make_shared<m3t::Link>(
+      "child_link", nullptr, m3t::Transform3fA::Identity(),
+      m3t::Transform3fA::Identity(), m3t::Transform3fA::Identity(),
+      std::array<bool, 6>{false, false, false, false, false, false})};
+  ASSERT_TRUE(link_ptr_->AddChildLink(child_link_ptr));
+  ASSERT_TRUE(link_ptr_->SetUp());
+  ASSERT_TRUE(child_link_ptr->SetUp());
+  for (bool use_tree_solver : {true, false}) {
+    link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+    optimizer_ptr_->set_use_tree_solver(use_tree_solver);
+    ASSERT_TRUE(optimizer_ptr_->SetUp());
+    ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+    ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+        link2world_pose.matrix(), 1.0e-4f));
+  }
+}
+
+TEST_F(OptimizerTest, BatchedSingleLink) {
+  // Optimize single link individually
+  auto body2world_pose{link_ptr_->body_ptr()->body2world_pose()};
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->IsBatchable());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  auto link2world_pose{link_ptr_->link2world_pose()};
+
+  // Reset pose and compare to batched optimization
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+  Eigen::Matrix<float, 6, 6> a;
+  Eigen::Matrix<float, 6, 1> b;
+  ASSERT_TRUE(optimizer_ptr_->CalculateSingleLinkSystem(&a, &b));
+  m3t::BatchSolver batch_solver;
+  batch_solver.Resize(1);
+  batch_solver.SetSystem(0, a, b);
+  batch_solver.Solve();
+  Eigen::Matrix<float, 6, 1> theta;
+  ASSERT_TRUE(batch_solver.GetSolution(0, &theta));
+  ASSERT_TRUE(optimizer_ptr_->ApplySingleLinkVariation(theta));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      link2world_pose.matrix(), 1.0e-4f));
+
+  // Optimizers with Levenberg-Marquardt are not batchable
+  optimizer_ptr_->set_use_levenberg_marquardt(true);
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_FALSE(optimizer_ptr_->IsBatchable());
+  ASSERT_FALSE(optimizer_ptr_->CalculateSingleLinkSystem(&a, &b));
+}
+
+TEST_F(OptimizerTest, LevenbergMarquardt) {
+  // First step is equal to step without Levenberg-Marquardt
+  auto body2world_pose{link_ptr_->body_ptr()->body2world_pose()};
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  auto link2world_pose{link_ptr_->link2world_pose()};
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+  optimizer_ptr_->set_use_levenberg_marquardt(true);
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 0));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      link2world_pose.matrix(), 1.0e-4f));
+  ASSERT_EQ(optimizer_ptr_->damping_factor(), 1.0f);
+
+  // Unchanged gradients and Hessians increase more than predicted
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(0, 0, 1));
+  ASSERT_LT(optimizer_ptr_->damping_factor(), 1.0f);
+  ASSERT_GE(optimizer_ptr_->damping_factor(),
+            optimizer_ptr_->min_damping_factor());
+
+  // Damping is reset at the start of the next frame
+  ASSERT_TRUE(optimizer_ptr_->CalculateOptimization(1, 0, 0));
+  ASSERT_EQ(optimizer_ptr_->damping_factor(), 1.0f);
+
+  // Reverting a joint variation restores the pose
+  link2world_pose = link_ptr_->link2world_pose();
+  Eigen::Matrix<float, 6, 1> joint_variation;
+  joint_variation << 0.1f, -0.2f, 0.3f, 0.01f, 0.02f, -0.03f;
+  ASSERT_TRUE(link_ptr_->ApplyJointVariation(nullptr, joint_variation));
+  ASSERT_FALSE(link_ptr_->link2world_pose().matrix().isApprox(
+      link2world_pose.matrix(), 1.0e-4f));
+  ASSERT_TRUE(link_ptr_->RevertJointVariation(nullptr, joint_variation));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      link2world_pose.matrix(), 1.0e-5f));
+}
+
+TEST_F(OptimizerTest, MotionModel) {
+  // Poses are not predicted without motion model
+  auto body2world_pose{link_ptr_->body_ptr()->body2world_pose()};
+  ASSERT_TRUE(optimizer_ptr_->SetUp());
+  ASSERT_TRUE(optimizer_ptr_->UpdateMotionModel(0.0));
+  ASSERT_TRUE(optimizer_ptr_->PredictPoses(0.1));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      body2world_pose.matrix()));
+
+  // Constant velocity extrapolates the previous motion
+  optimizer_ptr_->set_use_motion_model(true);
+  ASSERT_TRUE(optimizer_ptr_->UpdateMotionModel(0.0));
+  ASSERT_TRUE(optimizer_ptr_->PredictPoses(0.1));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      body2world_pose.matrix()));
+  m3t::Transform3fA motion{Eigen::Translation3f{0.01f, 0.0f, -0.02f}};
+  motion.rotate(Eigen::AngleAxisf{0.05f, Eigen::Vector3f::UnitZ()});
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose * motion);
+  ASSERT_TRUE(optimizer_ptr_->UpdateMotionModel(0.1));
+  ASSERT_TRUE(optimizer_ptr_->PredictPoses(0.3));
+  m3t::Transform3fA expected_pose{body2world_pose * motion * motion * motion};
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      expected_pose.matrix(), 1.0e-4f));
+  ASSERT_TRUE(link_ptr_->body_ptr()->body2world_pose().matrix().isApprox(
+      expected_pose.matrix(), 1.0e-4f));
+
+  // Poses are not predicted after reset
+  optimizer_ptr_->ResetMotionModel();
+  link_ptr_->body_ptr()->set_body2world_pose(body2world_pose);
+  ASSERT_TRUE(optimizer_ptr_->PredictPoses(0.4));
+  ASSERT_TRUE(link_ptr_->link2world_pose().matrix().isApprox(
+      body2world_pose.matrix()));
+}
@@ -103,3 +103,19 @@ TEST_F(RefinerTest, OptimizePoseMatrix) {
   ASSERT_TRUE(CompareToLoadedMatrix(refiner_test_directory, "triangle_pose.txt",
                                     pose_matrix, 1.0e-5f));
 }
+
+TEST_F(RefinerTest, PoseHypotheses) {
+  ASSERT_TRUE(refiner_ptr_->AddOptimizer(optimizer_ptr_));
+  ASSERT_TRUE(refiner_ptr_->SetUp());
+  const auto &body_ptr{refiner_ptr_->body_ptrs()[0]};
+  m3t::Transform3fA initial_pose{body_ptr->body2world_pose()};
+  m3t::Transform3fA shifted_pose{
+      initial_pose * m3t::Transform3fA{Eigen::Translation3f{0.3f, 0.0f, 0.0f}}};
+  std::map<std::string, std::vector<m3t::Transform3fA>> hypotheses{
+      {optimizer_ptr_->name(), {shifted_pose, initial_pose}}};
+  ASSERT_TRUE(refiner_ptr_->RefinePoseHypotheses(names_, hypotheses));
+  ASSERT_GT(refiner_ptr_->scores().at(optimizer_ptr_->name()), 0.0f);
+  auto pose_matrix{body_ptr->body2world_pose().matrix()};
+  ASSERT_TRUE(CompareToLoadedMatrix(refiner_test_directory, "triangle_pose.txt",
+                                    pose_matrix, 1.0e-4f));
+}
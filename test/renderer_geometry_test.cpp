@@ -5,6 +5,8 @@
 #include <m3t/body.h>
 #include <m3t/renderer_geometry.h>
 
+#include <thread>
+
 #include "common_test.h"
 
 class RendererGeometryTest : public testing::Test {
@@ -57,6 +59,28 @@ TEST_F(RendererGeometryTest, AddDeleteBodiesAfterSetUp) {
       TestRendererDataSchauma(renderer_geometry_ptr_->render_data_bodies()[0]));
 }
 
+TEST_F(RendererGeometryTest, ShareVertexObjects) {
+  auto schauma_2_body_ptr{SchaumaBodyPtr()};
+  schauma_2_body_ptr->set_name("schauma_2");
+  ASSERT_TRUE(renderer_geometry_ptr_->AddBody(schauma_body_ptr_));
+  ASSERT_TRUE(renderer_geometry_ptr_->AddBody(triangle_body_ptr_));
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_TRUE(renderer_geometry_ptr_->AddBody(schauma_2_body_ptr));
+  const auto &render_data_bodies{renderer_geometry_ptr_->render_data_bodies()};
+  ASSERT_EQ(render_data_bodies[0].vbo, render_data_bodies[2].vbo);
+  ASSERT_EQ(render_data_bodies[0].vao, render_data_bodies[2].vao);
+  ASSERT_NE(render_data_bodies[0].vbo, render_data_bodies[1].vbo);
+
+  // Shared vertex objects remain valid after the first body is deleted
+  ASSERT_TRUE(renderer_geometry_ptr_->DeleteBody("schauma"));
+  ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent());
+  ASSERT_TRUE(glIsBuffer(render_data_bodies[1].vbo));
+  ASSERT_TRUE(renderer_geometry_ptr_->DetachContext());
+  ASSERT_EQ(render_data_bodies[1].n_vertices, 62850u);
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_NE(render_data_bodies[1].vbo, 0u);
+}
+
 TEST_F(RendererGeometryTest, ClearBodiesBeforeSetUp) {
   renderer_geometry_ptr_->AddBody(triangle_body_ptr_);
   renderer_geometry_ptr_->AddBody(schauma_body_ptr_);
@@ -89,7 +113,50 @@ TEST_F(RendererGeometryTest, TestWithoutSetUp) {
 }
 
 TEST_F(RendererGeometryTest, MakeContextCurrent) {
-  renderer_geometry_ptr_->SetUp();
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent());
+  ASSERT_TRUE(renderer_geometry_ptr_->DetachContext());
+}
+
+TEST_F(RendererGeometryTest, MakeContextCurrentAfterRepeatedSetUp) {
+  // Single default context is guarded after every set up
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+    ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent());
+    ASSERT_TRUE(renderer_geometry_ptr_->DetachContext());
+  }
+  renderer_geometry_ptr_->set_n_contexts(2);
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  renderer_geometry_ptr_->set_n_contexts(1);
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent());
+  ASSERT_TRUE(renderer_geometry_ptr_->DetachContext());
+  ASSERT_FALSE(renderer_geometry_ptr_->MakeContextCurrent(1));
+}
+
+TEST_F(RendererGeometryTest, MakeSharedContextsCurrent) {
+  renderer_geometry_ptr_->set_n_contexts(2);
+  renderer_geometry_ptr_->AddBody(schauma_body_ptr_);
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_NE(renderer_geometry_ptr_->render_data_bodies()[0].context_vao(1), 0u);
+  std::thread thread{[&] {
+    ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent(1));
+    ASSERT_TRUE(renderer_geometry_ptr_->DetachContext(1));
+  }};
+  ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent(0));
+  ASSERT_TRUE(renderer_geometry_ptr_->DetachContext(0));
+  thread.join();
+  ASSERT_FALSE(renderer_geometry_ptr_->MakeContextCurrent(2));
+}
+
+#ifdef USE_EGL
+TEST_F(RendererGeometryTest, SetUpEGL) {
+  renderer_geometry_ptr_->set_backend(m3t::ContextBackend::EGL);
+  renderer_geometry_ptr_->AddBody(schauma_body_ptr_);
+  ASSERT_TRUE(renderer_geometry_ptr_->SetUp());
+  ASSERT_TRUE(
+      TestRendererDataSchauma(renderer_geometry_ptr_->render_data_bodies()[0]));
   ASSERT_TRUE(renderer_geometry_ptr_->MakeContextCurrent());
   ASSERT_TRUE(renderer_geometry_ptr_->DetachContext());
 }
+#endif
@@ -6,9 +6,12 @@
 #include <m3t/body.h>
 #include <m3t/camera.h>
 #include <m3t/normal_renderer.h>
+#include <m3t/renderer_atlas.h>
 #include <m3t/renderer_geometry.h>
 #include <m3t/silhouette_renderer.h>
 
+#include <thread>
+
 #include "common_test.h"
 
 const std::filesystem::path renderer_test_directory{data_directory /
@@ -149,6 +152,20 @@ TEST_F(FullSilhouetteRendererTest, TestDepthImage) {
                                    renderer_ptr_->depth_image(), 0, 10));
 }
 
+TEST_F(FullSilhouetteRendererTest, TestPixelBufferReadback) {
+  renderer_ptr_->set_use_pixel_buffer_readback(true);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(renderer_ptr_->use_pixel_buffer_readback());
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_TRUE(renderer_ptr_->FetchSilhouetteImage());
+  ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+  ASSERT_TRUE(CompareToLoadedImage(renderer_test_directory,
+                                   "silhouette_image.png",
+                                   renderer_ptr_->silhouette_image(), 0, 10));
+  ASSERT_TRUE(CompareToLoadedImage(renderer_test_directory, "depth_image.png",
+                                   renderer_ptr_->depth_image(), 0, 10));
+}
+
 class FocusedSilhouetteRendererTest : public testing::Test {
  protected:
   void SetUp() override {
@@ -322,6 +339,130 @@ TEST_F(FocusedSilhouetteRendererTest, TestDepthImage) {
                            renderer_ptr_->focused_depth_image(), 0, 10));
 }
 
+TEST_F(FocusedSilhouetteRendererTest, TestRenderCache) {
+  renderer_ptr_->set_render_cache_threshold(0.5f);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  float corner_u = renderer_ptr_->corner_u();
+
+  m3t::Transform3fA body2world_pose{triangle_body_ptr_->body2world_pose()};
+  triangle_body_ptr_->set_body2world_pose(
+      body2world_pose * Eigen::Translation3f{1.0e-6f, 0.0f, 0.0f});
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_EQ(renderer_ptr_->corner_u(), corner_u);
+
+  triangle_body_ptr_->set_body2world_pose(
+      body2world_pose * Eigen::Translation3f{0.01f, 0.0f, 0.0f});
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_NE(renderer_ptr_->corner_u(), corner_u);
+  triangle_body_ptr_->set_body2world_pose(body2world_pose);
+}
+
+TEST_F(FocusedSilhouetteRendererTest, TestRegionReadback) {
+  renderer_ptr_->set_use_region_readback(true);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_TRUE(renderer_ptr_->FetchSilhouetteImage());
+  ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+
+  const cv::Rect &region{renderer_ptr_->valid_region()};
+  ASSERT_FALSE(region.empty());
+  ASSERT_EQ(region & cv::Rect{0, 0, image_size_, image_size_}, region);
+  cv::Mat silhouette_image{cv::imread(
+      (renderer_test_directory / "focused_silhouette_image.png").string(),
+      cv::IMREAD_UNCHANGED)};
+  cv::Mat depth_image{
+      cv::imread((renderer_test_directory / "focused_depth_image.png").string(),
+                 cv::IMREAD_UNCHANGED)};
+  ASSERT_TRUE(CompareImages(silhouette_image(region),
+                            renderer_ptr_->focused_silhouette_image()(region),
+                            0, 10));
+  ASSERT_TRUE(CompareImages(depth_image(region),
+                            renderer_ptr_->focused_depth_image()(region), 0,
+                            10));
+}
+
+TEST_F(FocusedSilhouetteRendererTest, TestLinearDepth) {
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+  cv::Mat depth_image{renderer_ptr_->focused_depth_image().clone()};
+  cv::Mat depth_image_values{depth_image.size(), CV_32F};
+  for (int v = 0; v < depth_image.rows; ++v) {
+    for (int u = 0; u < depth_image.cols; ++u)
+      depth_image_values.at<float>(v, u) =
+          renderer_ptr_->Depth(depth_image.at<ushort>(v, u));
+  }
+
+  renderer_ptr_->set_use_linear_depth(true);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_TRUE(renderer_ptr_->FetchSilhouetteImage());
+  ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+  ASSERT_TRUE(CompareToLoadedImage(
+      renderer_test_directory, "focused_silhouette_image.png",
+      renderer_ptr_->focused_silhouette_image(), 0, 10));
+  const cv::Mat &linear_depth_image{renderer_ptr_->focused_depth_image()};
+  int n_compared = 0;
+  for (int v = 0; v < depth_image.rows; ++v) {
+    for (int u = 0; u < depth_image.cols; ++u) {
+      ushort value = linear_depth_image.at<ushort>(v, u);
+      if (value == USHRT_MAX || depth_image.at<ushort>(v, u) == USHRT_MAX)
+        continue;
+      ASSERT_NEAR(renderer_ptr_->Depth(value),
+                  depth_image_values.at<float>(v, u), 1.0e-3f);
+      ++n_compared;
+    }
+  }
+  ASSERT_GT(n_compared, 0);
+}
+
+TEST_F(FocusedSilhouetteRendererTest, TestSoftwareRendering) {
+  renderer_ptr_->set_use_software_rendering(true);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  std::thread thread{[&] {
+    ASSERT_TRUE(renderer_ptr_->StartRendering());
+    ASSERT_TRUE(renderer_ptr_->FetchSilhouetteImage());
+    ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+  }};
+  thread.join();
+  ASSERT_TRUE(CompareToLoadedImage(
+      renderer_test_directory, "focused_silhouette_image.png",
+      renderer_ptr_->focused_silhouette_image(), 0, 100));
+  ASSERT_TRUE(
+      CompareToLoadedImage(renderer_test_directory, "focused_depth_image.png",
+                           renderer_ptr_->focused_depth_image(), 1, 100));
+}
+
+TEST_F(FocusedSilhouetteRendererTest, TestAtlas) {
+  auto atlas_ptr{std::make_shared<m3t::FocusedRendererAtlas>(
+      "atlas", renderer_geometry_ptr_)};
+  ASSERT_TRUE(atlas_ptr->SetUp());
+  auto second_renderer_ptr{std::make_shared<m3t::FocusedBasicDepthRenderer>(
+      "second_renderer", renderer_geometry_ptr_, world2camera_pose_,
+      intrinsics_, 150, z_min_, z_max_)};
+  second_renderer_ptr->AddReferencedBody(triangle_body_ptr_);
+  renderer_ptr_->UseAtlas(atlas_ptr);
+  second_renderer_ptr->UseAtlas(atlas_ptr);
+  ASSERT_TRUE(renderer_ptr_->SetUp());
+  ASSERT_TRUE(second_renderer_ptr->SetUp());
+  ASSERT_EQ(atlas_ptr->n_tiles(), 2);
+
+  ASSERT_TRUE(renderer_ptr_->StartRendering());
+  ASSERT_TRUE(second_renderer_ptr->StartRendering());
+  ASSERT_TRUE(renderer_ptr_->FetchSilhouetteImage());
+  ASSERT_TRUE(renderer_ptr_->FetchDepthImage());
+  ASSERT_TRUE(second_renderer_ptr->FetchDepthImage());
+  ASSERT_EQ(second_renderer_ptr->focused_depth_image().size(),
+            cv::Size(150, 150));
+  ASSERT_TRUE(CompareToLoadedImage(
+      renderer_test_directory, "focused_silhouette_image.png",
+      renderer_ptr_->focused_silhouette_image(), 0, 10));
+  ASSERT_TRUE(
+      CompareToLoadedImage(renderer_test_directory, "focused_depth_image.png",
+                           renderer_ptr_->focused_depth_image(), 0, 10));
+}
+
 class FullNormalRendererTest : public testing::Test {
  protected:
   void SetUp() override {